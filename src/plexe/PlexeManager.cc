@@ -21,16 +21,53 @@
 #include "PlexeManager.h"
 
 #include "plexe/mobility/CommandInterface.h"
+#include "plexe/traci/PlexeScenarioManagerLaunchd.h"
+#include "plexe/utilities/DynamicPositionManager.h"
+#include "plexe/utilities/EventProfiler.h"
+#include "plexe/utilities/SpeedProfilePlayer.h"
+
+#include "veins/base/utils/FindModule.h"
+
+#include <fstream>
 
 namespace plexe {
 
 Define_Module(PlexeManager);
 
+PlexeManager* PlexeManager::instance = nullptr;
+
+PlexeManager::~PlexeManager()
+{
+    if (instance == this) instance = nullptr;
+}
+
+PlexeManager* PlexeManager::get()
+{
+    if (!instance) instance = veins::FindModule<PlexeManager*>::findGlobalModule();
+    return instance;
+}
+
 void PlexeManager::initialize(int stage)
 {
+    instance = this;
+
     const auto scenarioManager = veins::TraCIScenarioManagerAccess().get();
     ASSERT(scenarioManager);
 
+    // other managers have no recycleModules parameter, so the setting would be silently ignored
+    const char* recycleModules = getEnvir()->getConfig()->getPerObjectConfigValue(scenarioManager->getFullPath().c_str(), "recycleModules");
+    if (!dynamic_cast<PlexeScenarioManagerLaunchd*>(scenarioManager) && opp_strcmp(recycleModules, "true") == 0) throw cRuntimeError("recycleModules requires PlexeScenarioManagerLaunchd (useLaunchd = true)");
+
+    enableProfiler = par("enableProfiler").boolValue();
+    profilerOutput = par("profilerOutput").stdstringValue();
+    deferCommands = par("deferCommands").boolValue();
+    EventProfiler::getInstance().clear();
+    EventProfiler::getInstance().setEnabled(enableProfiler);
+    SpeedProfilePlayer::getInstance().clear();
+    // the singleton outlives the run, while platoon ids are reused by the next one
+    DynamicPositionManager::getInstance().clear();
+    platoonSketches.clear();
+
     if (scenarioManager->isUsable()) {
         initializeCommandInterface();
     }
@@ -46,8 +83,57 @@ void PlexeManager::initializeCommandInterface()
     ASSERT(scenarioManager);
     commandInterface.reset(new traci::CommandInterface(this, scenarioManager->getCommandInterface(), scenarioManager->getConnection()));
 
-    auto timestep = [this](veins::SignalPayload<simtime_t const&>) { commandInterface->executePlexeTimestep(); };
+    auto timestep = [this](veins::SignalPayload<simtime_t const&>) {
+        EventProfiler::Scope scope(this, "receiveSignal", "traciTimestepEnd");
+        commandInterface->executePlexeTimestep();
+        // feed speed profiles to all vehicles with a single message
+        SpeedProfilePlayer::getInstance().step(simTime());
+    };
     signalManager.subscribeCallback(scenarioManager, veins::TraCIScenarioManager::traciTimestepEndSignal, timestep);
+
+    if (deferCommands) {
+        commandInterface->setDeferCommands(true);
+        // send everything the vehicles deferred since the last step, right
+        // before SUMO computes the next one
+        auto flush = [this](veins::SignalPayload<simtime_t const&>) {
+            EventProfiler::Scope scope(this, "receiveSignal", "traciTimestepBegin");
+            commandInterface->sendDeferredParameters();
+        };
+        signalManager.subscribeCallback(scenarioManager, veins::TraCIScenarioManager::traciTimestepBeginSignal, flush);
+    }
+}
+
+QuantileSketch& PlexeManager::getPlatoonSketch(int platoonId, const std::string& name, double relativeAccuracy)
+{
+    std::map<std::string, QuantileSketch>& sketches = platoonSketches[platoonId];
+    auto sketch = sketches.find(name);
+    if (sketch == sketches.end()) sketch = sketches.emplace(name, QuantileSketch(relativeAccuracy)).first;
+    return sketch->second;
+}
+
+void PlexeManager::finish()
+{
+    for (auto& platoon : platoonSketches) {
+        for (auto& sketch : platoon.second) sketch.second.recordScalars(this, "platoon" + std::to_string(platoon.first) + "." + sketch.first);
+    }
+    platoonSketches.clear();
+    if (deferCommands && commandInterface) {
+        recordScalar("deferredCommands", commandInterface->getDeferredCommands());
+        recordScalar("coalescedCommands", commandInterface->getCoalescedCommands());
+    }
+    EventProfiler& profiler = EventProfiler::getInstance();
+    if (enableProfiler) {
+        std::ofstream times(profilerOutput);
+        if (!times) throw cRuntimeError("Unable to open profiler output file %s", profilerOutput.c_str());
+        profiler.writeTimes(times);
+        std::ofstream counts(profilerOutput + ".count");
+        profiler.writeCounts(counts);
+    }
+    profiler.setEnabled(false);
+    profiler.clear();
+    SpeedProfilePlayer::getInstance().clear();
+    // the singleton outlives the run, while platoon ids are reused by the next one
+    DynamicPositionManager::getInstance().clear();
 }
 
 } // namespace plexe
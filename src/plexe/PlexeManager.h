@@ -27,12 +27,25 @@
 #include <veins/modules/utility/SignalManager.h>
 
 #include <plexe/mobility/CommandInterface.h>
+#include <plexe/utilities/QuantileSketch.h>
+
+#include <map>
 
 namespace plexe {
 
 class PlexeManager : public cSimpleModule {
 public:
+    ~PlexeManager() override;
+
     void initialize(int stage) override;
+    void finish() override;
+
+    /**
+     * Returns the PlexeManager of the simulation. The module is searched in
+     * the network only once and then cached, so that vehicles do not walk the
+     * whole module tree every time one of them is created.
+     */
+    static PlexeManager* get();
 
     /**
      * Return a weak pointer to the CommandInterface owned by this manager.
@@ -42,11 +55,30 @@ public:
         return commandInterface.get();
     }
 
+    /**
+     * Returns the sketch collecting a statistic for all the members of a
+     * platoon, creating it with the given accuracy if needed. Platoon
+     * sketches are recorded as scalars of this module, named
+     * platoon<id>.<name>, when the simulation ends
+     */
+    QuantileSketch& getPlatoonSketch(int platoonId, const std::string& name, double relativeAccuracy);
+
 private:
     void initializeCommandInterface();
 
+    static PlexeManager* instance;
+
     std::unique_ptr<traci::CommandInterface> commandInterface;
     veins::SignalManager signalManager;
+
+    // whether the event profiler is enabled and where to write its results
+    bool enableProfiler = false;
+    std::string profilerOutput;
+    // whether the controller data fed by vehicles is sent once per step
+    bool deferCommands = false;
+
+    // statistics sketches of each platoon, by platoon id and statistic name
+    std::map<int, std::map<std::string, QuantileSketch>> platoonSketches;
 };
 
 } // namespace plexe
@@ -27,6 +27,8 @@
 
 #include "plexe/protocols/BaseProtocol.h"
 #include "plexe/PlexeManager.h"
+#include "plexe/utilities/EventProfiler.h"
+#include "plexe/utilities/PlatoonKpi.h"
 
 using namespace veins;
 
@@ -40,28 +42,23 @@ void BaseApp::initialize(int stage)
     BaseApplLayer::initialize(stage);
 
     if (stage == 0) {
-        // set names for output vectors
-        // distance from front vehicle
-        distanceOut.setName("distance");
-        // relative speed w.r.t. front vehicle
-        relSpeedOut.setName("relativeSpeed");
-        // vehicle id
-        nodeIdOut.setName("nodeId");
-        // current speed
-        speedOut.setName("speed");
-        // vehicle position
-        posxOut.setName("posx");
-        posyOut.setName("posy");
-        // vehicle acceleration
-        accelerationOut.setName("acceleration");
-        controllerAccelerationOut.setName("controllerAcceleration");
+        leanProfile = par("leanProfile").boolValue();
+        if (!leanProfile) getVectors();
+
+        useQuantileSketches = par("useQuantileSketches").boolValue();
+        sketchAccuracy = par("sketchAccuracy").doubleValue();
+        distanceSketch = QuantileSketch(sketchAccuracy);
+        relSpeedSketch = QuantileSketch(sketchAccuracy);
+
+        useNeighborTable = par("useNeighborTable").boolValue();
+        neighborTable = NeighborTable(par("neighborTimeout").doubleValue());
     }
 
     if (stage == 1) {
         mobility = veins::TraCIMobilityAccess().get(getParentModule());
         traci = mobility->getCommandInterface();
         traciVehicle = mobility->getVehicleCommandInterface();
-        auto plexe = FindModule<PlexeManager*>::findGlobalModule();
+        auto plexe = PlexeManager::get();
         ASSERT(plexe);
         plexeTraci = plexe->getCommandInterface();
         plexeTraciVehicle.reset(new traci::CommandInterface::Vehicle(plexeTraci, mobility->getExternalId()));
@@ -72,21 +69,98 @@ void BaseApp::initialize(int stage)
         // connect application to protocol
         protocol->registerApplication(BaseProtocol::BEACON_TYPE, gate("lowerLayerIn"), gate("lowerLayerOut"), gate("lowerControlIn"), gate("lowerControlOut"));
 
-        recordData = new cMessage("recordData");
-        // init statistics collection. round to 0.1 seconds
-        SimTime rounded = SimTime(floor(simTime().dbl() * 1000 + 100), SIMTIME_MS);
-        scheduleAt(rounded, recordData);
+        // init statistics collection on a grid of 0.1 seconds shared by all
+        // vehicles, so that their timers coalesce in the timer service
+        SimTime period = SimTime(100, SIMTIME_MS);
+        SimTime rounded = period * ((simTime().raw() + period.raw() - 1) / period.raw());
+        TimerService* timerService = TimerService::get();
+        if (timerService) {
+            recordDataTimer = timerService->addTimer(this, "recordData", rounded, period, [this]() { logVehicleData(plexeTraciVehicle->isCrashed()); });
+        }
+        else {
+            recordData = new cMessage("recordData");
+            scheduleAt(rounded, recordData);
+        }
+    }
+}
+
+BaseApp::OutputVectors* BaseApp::getVectors()
+{
+    // vectors are kept when the module is reused for another vehicle
+    if (vectors || vectorsChecked) return vectors.get();
+    vectorsChecked = true;
+    if (leanProfile && !isVectorRecordingEnabled(this, {"distance", "relativeSpeed", "nodeId", "speed", "posx", "posy", "acceleration", "controllerAcceleration"})) return nullptr;
+
+    vectors.reset(new OutputVectors());
+    // set names for output vectors
+    // distance from front vehicle
+    vectors->distanceOut.setName("distance");
+    // relative speed w.r.t. front vehicle
+    vectors->relSpeedOut.setName("relativeSpeed");
+    // vehicle id
+    vectors->nodeIdOut.setName("nodeId");
+    // current speed
+    vectors->speedOut.setName("speed");
+    // vehicle position
+    vectors->posxOut.setName("posx");
+    vectors->posyOut.setName("posy");
+    // vehicle acceleration
+    vectors->accelerationOut.setName("acceleration");
+    vectors->controllerAccelerationOut.setName("controllerAcceleration");
+    return vectors.get();
+}
+
+size_t BaseApp::getMemoryFootprint() const
+{
+    size_t bytes = sizeof(BaseApp);
+    if (vectors) bytes += sizeof(OutputVectors);
+    if (recordData) bytes += sizeof(cMessage);
+    bytes += mapFootprint(lastMemberDataTime);
+    bytes += distanceSketch.getMemoryFootprint() + relSpeedSketch.getMemoryFootprint();
+    bytes += neighborTable.getMemoryFootprint();
+    return bytes;
+}
+
+void BaseApp::finish()
+{
+    if (useQuantileSketches) {
+        distanceSketch.recordScalars(this, "distance");
+        relSpeedSketch.recordScalars(this, "relativeSpeed");
     }
+    BaseApplLayer::finish();
 }
 
 BaseApp::~BaseApp()
 {
     cancelAndDelete(recordData);
     recordData = nullptr;
+    // the service might have been deleted first at the end of the simulation
+    if (recordDataTimer >= 0 && TimerService::get()) TimerService::get()->removeTimer(recordDataTimer);
+    recordDataTimer = -1;
     cancelAndDelete(stopSimulation);
     stopSimulation = nullptr;
 }
 
+void BaseApp::resetForReuse()
+{
+    cancelAndDelete(recordData);
+    recordData = nullptr;
+    if (recordDataTimer >= 0) TimerService::get()->removeTimer(recordDataTimer);
+    recordDataTimer = -1;
+    cancelAndDelete(stopSimulation);
+    stopSimulation = nullptr;
+    lastMemberDataTime.clear();
+    distanceSketch.clear();
+    relSpeedSketch.clear();
+    neighborTable.clear();
+}
+
+void BaseApp::handleMessage(cMessage* msg)
+{
+    PROFILE_EVENT("handleMessage", msg);
+    BaseApplLayer::handleMessage(msg);
+}
+
 void BaseApp::handleLowerMsg(cMessage* msg)
 {
     BaseFrame1609_4* frame = check_and_cast<BaseFrame1609_4*>(msg);
@@ -117,14 +191,39 @@ void BaseApp::logVehicleData(bool crashed)
         scheduleAt(simTime() + SimTime(1, SIMTIME_MS), stopSimulation);
     }
     // write data to output files
-    distanceOut.record(distance);
-    relSpeedOut.record(relSpeed);
-    nodeIdOut.record(myId);
-    accelerationOut.record(data.acceleration);
-    controllerAccelerationOut.record(data.u);
-    speedOut.record(data.speed);
-    posxOut.record(data.positionX);
-    posyOut.record(data.positionY);
+    if (OutputVectors* out = getVectors()) {
+        out->distanceOut.record(distance);
+        out->relSpeedOut.record(relSpeed);
+        out->nodeIdOut.record(myId);
+        out->accelerationOut.record(data.acceleration);
+        out->controllerAccelerationOut.record(data.u);
+        out->speedOut.record(data.speed);
+        out->posxOut.record(data.positionX);
+        out->posyOut.record(data.positionY);
+    }
+
+    if (mayHaveListeners(PlatoonKpi::vehicleSampleSignal)) {
+        VehicleSample sample;
+        sample.vehicleId = myId;
+        sample.platoonId = positionHelper->getPlatoonId();
+        sample.position = positionHelper->getPosition();
+        sample.distance = distance;
+        sample.relativeSpeed = relSpeed;
+        sample.acceleration = data.acceleration;
+        emit(PlatoonKpi::vehicleSampleSignal, &sample);
+    }
+
+    // the radar returns a negative distance when there is no vehicle in front
+    if (useQuantileSketches && distance >= 0) {
+        distanceSketch.add(distance);
+        relSpeedSketch.add(relSpeed);
+        int platoonId = positionHelper->getPlatoonId();
+        if (platoonId >= 0) {
+            PlexeManager* plexe = PlexeManager::get();
+            plexe->getPlatoonSketch(platoonId, "distance", sketchAccuracy).add(distance);
+            plexe->getPlatoonSketch(platoonId, "relativeSpeed", sketchAccuracy).add(relSpeed);
+        }
+    }
 }
 
 void BaseApp::handleLowerControl(cMessage* msg)
@@ -155,6 +254,17 @@ void BaseApp::handleSelfMsg(cMessage* msg)
 
 void BaseApp::onPlatoonBeacon(const PlatooningBeacon* pb)
 {
+    if (useNeighborTable) {
+        Neighbor neighbor;
+        neighbor.vehicleId = pb->getVehicleId();
+        neighbor.platoonId = pb->getPlatoonId();
+        neighbor.platoonPosition = pb->getPlatoonPosition();
+        neighbor.lane = pb->getPlatoonLane();
+        neighbor.position = pb->getPositionX();
+        neighbor.speed = pb->getSpeed();
+        neighbor.time = simTime();
+        neighborTable.update(neighbor);
+    }
     if (positionHelper->isInSamePlatoon(pb->getVehicleId())) {
         // if the message comes from the leader
         if (pb->getVehicleId() == positionHelper->getLeaderId()) {
@@ -164,23 +274,70 @@ void BaseApp::onPlatoonBeacon(const PlatooningBeacon* pb)
         if (pb->getVehicleId() == positionHelper->getFrontId()) {
             plexeTraciVehicle->setFrontVehicleData(pb->getControllerAcceleration(), pb->getAcceleration(), pb->getSpeed(), pb->getPositionX(), pb->getPositionY(), pb->getTime());
         }
-        // send data about every vehicle to the CACC. this is needed by the consensus controller
-        struct VEHICLE_DATA vehicleData;
-        vehicleData.index = positionHelper->getMemberPosition(pb->getVehicleId());
-        vehicleData.acceleration = pb->getAcceleration();
-        vehicleData.length = pb->getLength();
-        vehicleData.positionX = pb->getPositionX();
-        vehicleData.positionY = pb->getPositionY();
-        vehicleData.speed = pb->getSpeed();
-        vehicleData.time = pb->getTime();
-        vehicleData.u = pb->getControllerAcceleration();
-        vehicleData.speedX = pb->getSpeedX();
-        vehicleData.speedY = pb->getSpeedY();
-        vehicleData.angle = pb->getAngle();
-        // send information to CACC
-        plexeTraciVehicle->setVehicleData(&vehicleData);
+        // send data about every vehicle to the CACC. this is needed by the consensus controller.
+        // when the leader aggregates the platoon state, the data about the other members is
+        // taken from the leader's beacon instead
+        bool aggregating = protocol->isAggregatingPlatoonState();
+        bool queued = false;
+        if (!aggregating || pb->getVehicleId() == positionHelper->getLeaderId() || pb->getVehicleId() == positionHelper->getFrontId()) {
+            MemberState state;
+            state.vehicleId = pb->getVehicleId();
+            state.controllerAcceleration = pb->getControllerAcceleration();
+            state.acceleration = pb->getAcceleration();
+            state.speed = pb->getSpeed();
+            state.positionX = pb->getPositionX();
+            state.positionY = pb->getPositionY();
+            state.time = pb->getTime();
+            state.length = pb->getLength();
+            state.speedX = pb->getSpeedX();
+            state.speedY = pb->getSpeedY();
+            state.angle = pb->getAngle();
+            // the same data might be received both directly and through the leader
+            queued |= queueMemberData(state, aggregating);
+        }
+        if (const PlatoonStateBeacon* psb = dynamic_cast<const PlatoonStateBeacon*>(pb)) {
+            // forget the members that left the platoon
+            for (auto last = lastMemberDataTime.begin(); last != lastMemberDataTime.end();) {
+                if (positionHelper->isInSamePlatoon(last->first))
+                    last++;
+                else
+                    last = lastMemberDataTime.erase(last);
+            }
+            for (unsigned int i = 0; i < psb->getMembersArraySize(); i++) {
+                const MemberState& state = psb->getMembers(i);
+                if (state.vehicleId != myId && positionHelper->isInSamePlatoon(state.vehicleId)) queued |= queueMemberData(state, true);
+            }
+        }
+        // pass the data about all members to the CACC in a single message.
+        // deferred data is sent together with the other deferred commands
+        if (queued) plexeTraci->sendQueuedParameters();
     }
     delete pb;
 }
 
+bool BaseApp::queueMemberData(const MemberState& state, bool skipStale)
+{
+    if (skipStale) {
+        auto last = lastMemberDataTime.find(state.vehicleId);
+        if (last != lastMemberDataTime.end() && last->second >= state.time) return false;
+        lastMemberDataTime[state.vehicleId] = state.time;
+    }
+
+    struct VEHICLE_DATA vehicleData;
+    vehicleData.index = positionHelper->getMemberPosition(state.vehicleId);
+    vehicleData.acceleration = state.acceleration;
+    vehicleData.length = state.length;
+    vehicleData.positionX = state.positionX;
+    vehicleData.positionY = state.positionY;
+    vehicleData.speed = state.speed;
+    vehicleData.time = state.time;
+    vehicleData.u = state.controllerAcceleration;
+    vehicleData.speedX = state.speedX;
+    vehicleData.speedY = state.speedY;
+    vehicleData.angle = state.angle;
+    // send information to CACC
+    plexeTraciVehicle->queueVehicleData(&vehicleData);
+    return true;
+}
+
 } // namespace plexe
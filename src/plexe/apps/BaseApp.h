@@ -26,17 +26,24 @@
 
 #include "plexe/CC_Const.h"
 #include "plexe/messages/PlatooningBeacon_m.h"
+#include "plexe/messages/PlatoonStateBeacon_m.h"
 #include "plexe/mobility/CommandInterface.h"
 #include "plexe/utilities/BasePositionHelper.h"
+#include "plexe/utilities/MemoryFootprint.h"
+#include "plexe/utilities/NeighborTable.h"
+#include "plexe/utilities/QuantileSketch.h"
+#include "plexe/utilities/RecyclableModule.h"
+#include "plexe/utilities/TimerService.h"
 
 namespace plexe {
 
 class BaseProtocol;
 
-class BaseApp : public veins::BaseApplLayer {
+class BaseApp : public veins::BaseApplLayer, public RecyclableModule, public MemoryFootprint {
 
 public:
     virtual void initialize(int stage) override;
+    virtual void finish() override;
 
 protected:
     // id of this vehicle
@@ -60,17 +67,47 @@ protected:
     virtual void logVehicleData(bool crashed = false);
 
     // output vectors for mobility stats
-    // id of the vehicle
-    cOutVector nodeIdOut;
-    // distance and relative speed
-    cOutVector distanceOut, relSpeedOut;
-    // speed and position
-    cOutVector speedOut, posxOut, posyOut;
-    // real acceleration and controller acceleration
-    cOutVector accelerationOut, controllerAccelerationOut;
+    struct OutputVectors {
+        // id of the vehicle
+        cOutVector nodeIdOut;
+        // distance and relative speed
+        cOutVector distanceOut, relSpeedOut;
+        // speed and position
+        cOutVector speedOut, posxOut, posyOut;
+        // real acceleration and controller acceleration
+        cOutVector accelerationOut, controllerAccelerationOut;
+    };
+    std::unique_ptr<OutputVectors> vectors;
+
+    // if true, output vectors are only allocated when first recorded, and
+    // only if their recording is enabled. GeneralPlatooningApp also creates
+    // maneuvers only when they are first needed
+    bool leanProfile;
+    // true once it is known whether output vectors are recorded
+    bool vectorsChecked;
+
+    /**
+     * Returns the output vectors, allocating them on first use with the
+     * lean profile, or nullptr if none of them is recorded
+     */
+    OutputVectors* getVectors();
+
+    // if true, distance and relative speed are also summarized by quantile
+    // sketches, per vehicle and per platoon, recorded as scalars at the end
+    // of the simulation
+    bool useQuantileSketches;
+    double sketchAccuracy;
+    QuantileSketch distanceSketch, relSpeedSketch;
+
+    // if true, the vehicles heard through beacons are stored in a table
+    // indexed by road position, used to find nearby platoons
+    bool useNeighborTable;
+    NeighborTable neighborTable;
 
     // messages for scheduleAt
     cMessage* recordData;
+    // id of the recordData timer when using the TimerService, -1 otherwise
+    int recordDataTimer;
     // message to stop the simulation in case of collision
     cMessage* stopSimulation;
 
@@ -78,10 +115,22 @@ public:
     BaseApp()
     {
         recordData = 0;
+        recordDataTimer = -1;
         stopSimulation = nullptr;
+        useQuantileSketches = false;
+        sketchAccuracy = 0.01;
+        useNeighborTable = false;
+        leanProfile = false;
+        vectorsChecked = false;
     }
     virtual ~BaseApp();
 
+    /** override from RecyclableModule */
+    virtual void resetForReuse() override;
+
+    /** override from MemoryFootprint */
+    virtual size_t getMemoryFootprint() const override;
+
     /**
      * Sends a frame
      *
@@ -90,7 +139,18 @@ public:
      */
     void sendFrame(cPacket* msg, int destination);
 
+    /**
+     * Returns the table of the neighbors heard through beacons, or nullptr
+     * if the table is disabled
+     */
+    NeighborTable* getNeighborTable()
+    {
+        return useNeighborTable ? &neighborTable : nullptr;
+    }
+
 protected:
+    // override handleMessage to account the time spent in each event
+    virtual void handleMessage(cMessage* msg) override;
     virtual void handleLowerMsg(cMessage* msg) override;
     virtual void handleSelfMsg(cMessage* msg) override;
     virtual void handleLowerControl(cMessage* msg) override;
@@ -99,6 +159,18 @@ protected:
      * Handles PlatoonBeacons
      */
     virtual void onPlatoonBeacon(const PlatooningBeacon* pb);
+
+    /**
+     * Queues the data about a platoon member for the controller, to be sent
+     * with CommandInterface::sendQueuedParameters(). If skipStale is set,
+     * the data is dropped when more recent data has already been queued.
+     * Returns whether the data has been queued
+     */
+    bool queueMemberData(const MemberState& state, bool skipStale);
+
+    // timestamp of the last data passed to the controller for each member,
+    // only kept for data that can be received more than once
+    std::map<int, double> lastMemberDataTime;
 };
 
 } // namespace plexe
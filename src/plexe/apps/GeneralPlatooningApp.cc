@@ -28,6 +28,8 @@
 #include "veins/modules/mac/ieee80211p/Mac1609_4.h"
 #include "plexe/messages/PlexeInterfaceControlInfo_m.h"
 #include "veins/base/utils/FindModule.h"
+#include "plexe/utilities/EventProfiler.h"
+#include "plexe/utilities/DynamicPositionManager.h"
 
 using namespace veins;
 
@@ -45,30 +47,125 @@ void GeneralPlatooningApp::initialize(int stage)
         // register to the signal indicating failed unicast transmissions
         findHost()->subscribe(Mac1609_4::sigRetriesExceeded, this);
 
+        formationRepairTimeout = SimTime(par("formationRepairTimeout").doubleValue());
+        maxFormationRepairAttempts = par("formationRepairAttempts").intValue();
+        formationRepair = new cMessage("formationRepair");
+
+        if (par("reliableManeuverTransport").boolValue()) {
+            transport = new ManeuverTransport(this, par("transportInitialRto").doubleValue(), par("transportMinRto").doubleValue(), par("transportMaxRto").doubleValue(), par("transportMaxRetransmissions").intValue(), par("transportAckDelay").doubleValue());
+        }
+
+        // with the lean profile, maneuvers are created when first needed
+        if (!leanProfile) {
+            getJoinManeuver();
+            getMergeManeuver();
+            getOvertakeManeuver();
+        }
+
+        scenario = FindModule<BaseScenario*>::findSubModule(getParentModule());
+    }
+}
+
+JoinManeuver* GeneralPlatooningApp::getJoinManeuver()
+{
+    if (!joinManeuver) {
+        // maneuvers might be started by other modules, but own their timers
+        Enter_Method_Silent();
         std::string joinManeuverName = par("joinManeuver").stdstringValue();
         if (joinManeuverName == "JoinAtBack")
             joinManeuver = new JoinAtBack(this);
         else
             throw new cRuntimeError("Invalid join maneuver implementation chosen");
+        updateManeuverHandlers();
+    }
+    return joinManeuver;
+}
 
+JoinManeuver* GeneralPlatooningApp::getMergeManeuver()
+{
+    if (!mergeManeuver) {
+        Enter_Method_Silent();
         std::string mergeManeuverName = par("mergeManeuver").stdstringValue();
         if (mergeManeuverName == "MergeAtBack")
             mergeManeuver = new MergeAtBack(this);
         else
             throw new cRuntimeError("Invalid merge maneuver implementation chosen");
+        updateManeuverHandlers();
+    }
+    return mergeManeuver;
+}
 
+OvertakeManeuver* GeneralPlatooningApp::getOvertakeManeuver()
+{
+    if (!overtakeManeuver) {
+        Enter_Method_Silent();
         std::string overtakeManeuverName = par("overtakeManeuver").stdstringValue();
         if (overtakeManeuverName == "AssistedOvertake")
             overtakeManeuver = new AssistedOvertake(this);
         else
             throw new cRuntimeError("Invalid overtake maneuver implementation chosen");
+        updateManeuverHandlers();
+    }
+    return overtakeManeuver;
+}
 
-        scenario = FindModule<BaseScenario*>::findSubModule(getParentModule());
+void GeneralPlatooningApp::updateManeuverHandlers()
+{
+    // register maneuvers for the message types they handle. messages
+    // without a type tag are given to all maneuvers
+    for (int type = 0; type < MMT_COUNT; type++) maneuverHandlers[type].clear();
+    for (Maneuver* maneuver : {(Maneuver*) joinManeuver, (Maneuver*) mergeManeuver, (Maneuver*) overtakeManeuver}) {
+        if (!maneuver) continue;
+        for (int type = 0; type < MMT_COUNT; type++) {
+            if (type == MMT_UNKNOWN || maneuver->handlesMessageType(type)) maneuverHandlers[type].push_back(maneuver);
+        }
     }
 }
 
+size_t GeneralPlatooningApp::getMemoryFootprint() const
+{
+    size_t bytes = BaseApp::getMemoryFootprint() - sizeof(BaseApp) + sizeof(GeneralPlatooningApp);
+    for (Maneuver* maneuver : {(Maneuver*) joinManeuver, (Maneuver*) mergeManeuver, (Maneuver*) overtakeManeuver}) {
+        if (maneuver) bytes += maneuver->getMemoryFootprint();
+    }
+    for (int type = 0; type < MMT_COUNT; type++) bytes += vectorFootprint(maneuverHandlers[type]);
+    bytes += mapFootprint(memberFormationVersion);
+    if (formationRepair) bytes += sizeof(cMessage);
+    if (transport) bytes += sizeof(ManeuverTransport);
+    if (overtakeWaitTimeOut) bytes += sizeof(cOutVector);
+    return bytes;
+}
+
+void GeneralPlatooningApp::finish()
+{
+    if (transport) transport->recordStatistics();
+    if (joinManeuver) joinManeuver->recordStatistics();
+    if (mergeManeuver) mergeManeuver->recordStatistics();
+    if (overtakeManeuver) overtakeManeuver->recordStatistics();
+    emitManeuverEvent(ManeuverEvent::REMOVED);
+    BaseApp::finish();
+}
+
 void GeneralPlatooningApp::handleSelfMsg(cMessage* msg)
 {
+    if (transport && transport->handleSelfMsg(msg)) return;
+
+    if (msg == formationRepair) {
+        if (getPlatoonRole() != PlatoonRole::LEADER) return;
+        // repair members that did not acknowledge the current version
+        bool lagging = false;
+        for (int i = 1; i < positionHelper->getPlatoonSize(); i++) {
+            int member = positionHelper->getMemberId(i);
+            auto version = memberFormationVersion.find(member);
+            if (version == memberFormationVersion.end() || version->second != positionHelper->getFormationVersion()) {
+                repairPlatoonFormation(member);
+                lagging = true;
+            }
+        }
+        if (lagging && ++formationRepairAttempts < maxFormationRepairAttempts) scheduleAt(simTime() + formationRepairTimeout, formationRepair);
+        return;
+    }
+
     if (joinManeuver && joinManeuver->handleSelfMsg(msg)) return;
     if (mergeManeuver && mergeManeuver->handleSelfMsg(msg)) return;
     if (overtakeManeuver && overtakeManeuver->handleSelfMsg(msg)) return;
@@ -100,7 +197,7 @@ void GeneralPlatooningApp::startJoinManeuver(int platoonId, int leaderId, int po
     params.platoonId = platoonId;
     params.leaderId = leaderId;
     params.position = position;
-    joinManeuver->startManeuver(&params);
+    getJoinManeuver()->startManeuver(&params);
 }
 
 void GeneralPlatooningApp::startMergeManeuver(int platoonId, int leaderId, int position)
@@ -112,13 +209,22 @@ void GeneralPlatooningApp::startMergeManeuver(int platoonId, int leaderId, int p
     params.platoonId = platoonId;
     params.leaderId = leaderId;
     params.position = position;
-    mergeManeuver->startManeuver(&params);
+    getMergeManeuver()->startManeuver(&params);
 }
 
 void GeneralPlatooningApp::sendUnicast(cPacket* msg, int destination)
 {
     Enter_Method_Silent();
     take(msg);
+    if (transport && destination != LAddress::L2BROADCAST()) {
+        transport->send(check_and_cast<ManeuverMessage*>(msg), destination);
+        return;
+    }
+    sendManeuverFrame(msg, destination);
+}
+
+void GeneralPlatooningApp::sendManeuverFrame(cPacket* msg, int destination)
+{
     BaseFrame1609_4* frame = new BaseFrame1609_4("BaseFrame1609_4", msg->getKind());
     frame->setRecipientAddress(destination);
     frame->setChannelNumber(static_cast<int>(Channel::cch));
@@ -130,6 +236,11 @@ void GeneralPlatooningApp::sendUnicast(cPacket* msg, int destination)
     sendDown(frame);
 }
 
+void GeneralPlatooningApp::sendBroadcast(cPacket* msg)
+{
+    sendUnicast(msg, LAddress::L2BROADCAST());
+}
+
 void GeneralPlatooningApp::handleLowerMsg(cMessage* msg)
 {
     BaseFrame1609_4* frame = check_and_cast<BaseFrame1609_4*>(msg);
@@ -139,16 +250,13 @@ void GeneralPlatooningApp::handleLowerMsg(cMessage* msg)
 
     if (enc->getKind() == MANEUVER_TYPE) {
         ManeuverMessage* mm = check_and_cast<ManeuverMessage*>(frame->decapsulate());
-        if (UpdatePlatoonData* msg = dynamic_cast<UpdatePlatoonData*>(mm)) {
-            handleUpdatePlatoonData(msg);
-            delete msg;
-        }
-        else if (UpdatePlatoonFormation* msg = dynamic_cast<UpdatePlatoonFormation*>(mm)) {
-            handleUpdatePlatoonFormation(msg);
-            delete msg;
+        if (mm->getMessageType() == MMT_BUNDLE) {
+            ManeuverBundle* bundle = check_and_cast<ManeuverBundle*>(mm);
+            for (ManeuverMessage* m : bundle->releaseMessages()) dispatchManeuverMessage(m);
+            delete bundle;
         }
         else {
-            onManeuverMessage(mm);
+            dispatchManeuverMessage(mm);
         }
         delete frame;
     }
@@ -157,12 +265,40 @@ void GeneralPlatooningApp::handleLowerMsg(cMessage* msg)
     }
 }
 
+void GeneralPlatooningApp::dispatchManeuverMessage(ManeuverMessage* mm)
+{
+    if (transport && !transport->receive(mm)) {
+        delete mm;
+        return;
+    }
+
+    switch (mm->getMessageType()) {
+    case MMT_UPDATE_PLATOON_DATA:
+        handleUpdatePlatoonData(static_cast<UpdatePlatoonData*>(mm));
+        delete mm;
+        break;
+    case MMT_UPDATE_PLATOON_FORMATION:
+        handleUpdatePlatoonFormation(static_cast<UpdatePlatoonFormation*>(mm));
+        delete mm;
+        break;
+    case MMT_UPDATE_PLATOON_FORMATION_ACK:
+        handleUpdatePlatoonFormationAck(static_cast<UpdatePlatoonFormationAck*>(mm));
+        delete mm;
+        break;
+    default:
+        onManeuverMessage(mm);
+        break;
+    }
+}
+
 void GeneralPlatooningApp::handleUpdatePlatoonData(const UpdatePlatoonData* msg)
 {
     if (getPlatoonRole() != PlatoonRole::FOLLOWER) return;
     if (msg->getPlatoonId() != positionHelper->getPlatoonId()) return;
     if (msg->getVehicleId() != positionHelper->getLeaderId()) return;
 
+    // formation versions are meaningful within a platoon only
+    positionHelper->setFormationVersion(0);
     handleUpdatePlatoonFormation(msg);
     LOG << positionHelper->getId() << " changing platoon id from " << positionHelper->getPlatoonId() << " to " << msg->getNewPlatoonId() << "\n";
     positionHelper->setPlatoonId(msg->getNewPlatoonId());
@@ -173,6 +309,9 @@ void GeneralPlatooningApp::handleUpdatePlatoonFormation(const UpdatePlatoonForma
     if (getPlatoonRole() != PlatoonRole::FOLLOWER) return;
     if (msg->getPlatoonId() != positionHelper->getPlatoonId()) return;
     if (msg->getVehicleId() != positionHelper->getLeaderId()) return;
+    // ignore duplicates, e.g., a repair for an update already received
+    int version = msg->getFormationVersion();
+    if (version != 0 && version <= positionHelper->getFormationVersion()) return;
 
     // update formation information
     LOG << positionHelper->getId() << " changing platoon formation: ";
@@ -183,6 +322,50 @@ void GeneralPlatooningApp::handleUpdatePlatoonFormation(const UpdatePlatoonForma
     }
     LOG << "\n";
     positionHelper->setPlatoonFormation(f);
+    if (version != 0) positionHelper->setFormationVersion(version);
+}
+
+void GeneralPlatooningApp::handleUpdatePlatoonFormationAck(const UpdatePlatoonFormationAck* msg)
+{
+    if (getPlatoonRole() != PlatoonRole::LEADER) return;
+    if (msg->getPlatoonId() != positionHelper->getPlatoonId()) return;
+    if (!positionHelper->isInSamePlatoon(msg->getVehicleId())) return;
+
+    memberFormationVersion[msg->getVehicleId()] = msg->getFormationVersion();
+    if (msg->getFormationVersion() != positionHelper->getFormationVersion()) repairPlatoonFormation(msg->getVehicleId());
+}
+
+void GeneralPlatooningApp::sendPlatoonFormationUpdate()
+{
+    ASSERT(getPlatoonRole() == PlatoonRole::LEADER);
+
+    // versions are counted per platoon, so that a new leader continues
+    // from the versions its members already know
+    positionHelper->setFormationVersion(DynamicPositionManager::getInstance().nextFormationVersion(positionHelper->getPlatoonId()));
+    // forget the versions of the vehicles that left the platoon
+    for (auto version = memberFormationVersion.begin(); version != memberFormationVersion.end();) {
+        if (positionHelper->isInSamePlatoon(version->first))
+            version++;
+        else
+            version = memberFormationVersion.erase(version);
+    }
+
+    LOG << positionHelper->getId() << " broadcasting UpdatePlatoonFormation version " << positionHelper->getFormationVersion() << "\n";
+    UpdatePlatoonFormation* msg = createUpdatePlatoonFormation(positionHelper->getId(), positionHelper->getExternalId(), positionHelper->getPlatoonId(), -1, positionHelper->getPlatoonSpeed(), traciVehicle->getLaneIndex(), positionHelper->getPlatoonFormation());
+    msg->setFormationVersion(positionHelper->getFormationVersion());
+    sendBroadcast(msg);
+
+    formationRepairAttempts = 0;
+    cancelEvent(formationRepair);
+    scheduleAt(simTime() + formationRepairTimeout, formationRepair);
+}
+
+void GeneralPlatooningApp::repairPlatoonFormation(int memberId)
+{
+    LOG << positionHelper->getId() << " sending UpdatePlatoonFormation version " << positionHelper->getFormationVersion() << " to lagging member " << memberId << "\n";
+    UpdatePlatoonFormation* msg = createUpdatePlatoonFormation(positionHelper->getId(), positionHelper->getExternalId(), positionHelper->getPlatoonId(), memberId, positionHelper->getPlatoonSpeed(), traciVehicle->getLaneIndex(), positionHelper->getPlatoonFormation());
+    msg->setFormationVersion(positionHelper->getFormationVersion());
+    sendUnicast(msg, memberId);
 }
 
 void GeneralPlatooningApp::setPlatoonRole(PlatoonRole r)
@@ -192,9 +375,29 @@ void GeneralPlatooningApp::setPlatoonRole(PlatoonRole r)
 
 void GeneralPlatooningApp::onPlatoonBeacon(const PlatooningBeacon* pb)
 {
-    joinManeuver->onPlatoonBeacon(pb);
-    mergeManeuver->onPlatoonBeacon(pb);
-    overtakeManeuver->onPlatoonBeacon(pb);
+    if (positionHelper->isInSamePlatoon(pb->getVehicleId())) {
+        if (getPlatoonRole() == PlatoonRole::LEADER) {
+            // beacons acknowledge the formation version known by members
+            memberFormationVersion[pb->getVehicleId()] = pb->getFormationVersion();
+        }
+        else if (getPlatoonRole() == PlatoonRole::FOLLOWER && pb->getVehicleId() == positionHelper->getLeaderId()) {
+            // the leader has a formation we do not know about. ask for it, once per version
+            int version = pb->getFormationVersion();
+            if (version != 0 && version != positionHelper->getFormationVersion() && version != lastNackedVersion) {
+                lastNackedVersion = version;
+                UpdatePlatoonFormationAck* nack = new UpdatePlatoonFormationAck("UpdatePlatoonFormationAck");
+                fillManeuverMessage(nack, positionHelper->getId(), positionHelper->getExternalId(), positionHelper->getPlatoonId(), positionHelper->getLeaderId());
+                nack->setPlatoonSpeed(positionHelper->getPlatoonSpeed());
+                nack->setPlatoonLane(positionHelper->getPlatoonLane());
+                nack->setFormationVersion(positionHelper->getFormationVersion());
+                sendUnicast(nack, positionHelper->getLeaderId());
+            }
+        }
+    }
+    // maneuvers not created yet are idle and ignore beacons
+    if (joinManeuver) joinManeuver->onPlatoonBeacon(pb);
+    if (mergeManeuver) mergeManeuver->onPlatoonBeacon(pb);
+    if (overtakeManeuver) overtakeManeuver->onPlatoonBeacon(pb);
     // maintain platoon
     BaseApp::onPlatoonBeacon(pb);
 }
@@ -205,9 +408,16 @@ void GeneralPlatooningApp::onManeuverMessage(ManeuverMessage* mm)
         activeManeuver->onManeuverMessage(mm);
     }
     else {
-        joinManeuver->onManeuverMessage(mm);
-        mergeManeuver->onManeuverMessage(mm);
-        overtakeManeuver->onManeuverMessage(mm);
+        int type = mm->getMessageType();
+        if (type < 0 || type >= MMT_COUNT) type = MMT_UNKNOWN;
+        if (leanProfile) {
+            if (type == MMT_UNKNOWN || JoinManeuver::isJoinMessageType(type)) {
+                getJoinManeuver();
+                getMergeManeuver();
+            }
+            if (type == MMT_UNKNOWN || OvertakeManeuver::isOvertakeMessageType(type)) getOvertakeManeuver();
+        }
+        for (Maneuver* maneuver : maneuverHandlers[type]) maneuver->onManeuverMessage(mm);
     }
     delete mm;
 }
@@ -250,17 +460,34 @@ UpdatePlatoonFormation* GeneralPlatooningApp::createUpdatePlatoonFormation(int v
 
 void GeneralPlatooningApp::receiveSignal(cComponent* src, simsignal_t id, cObject* value, cObject* details)
 {
-    if (id == Mac1609_4::sigRetriesExceeded) {
+    PROFILE_SIGNAL(id);
+    // with the reliable transport, lost frames are recovered by retransmissions
+    if (id == Mac1609_4::sigRetriesExceeded && !transport) {
         BaseFrame1609_4* frame = check_and_cast<BaseFrame1609_4*>(value);
         ManeuverMessage* mm = check_and_cast<ManeuverMessage*>(frame->getEncapsulatedPacket());
-        if (frame) {
-            joinManeuver->onFailedTransmissionAttempt(mm);
-            mergeManeuver->onFailedTransmissionAttempt(mm);
-            overtakeManeuver->onFailedTransmissionAttempt(mm);
-        }
+        if (frame) onFailedTransmission(mm);
     }
 }
 
+void GeneralPlatooningApp::onFailedTransmission(const ManeuverMessage* mm)
+{
+    int type = mm->getMessageType();
+    // only the maneuver that sent the message has to react. followers
+    // opening a gap take part in an overtake without being in a maneuver
+    Maneuver* owner = nullptr;
+    if (activeManeuver && activeManeuver->handlesMessageType(type))
+        owner = activeManeuver;
+    else if (OvertakeManeuver::isOvertakeMessageType(type))
+        owner = overtakeManeuver;
+    else if (JoinManeuver::isJoinMessageType(type))
+        owner = joinManeuver;
+
+    if (owner)
+        owner->onFailedTransmissionAttempt(mm);
+    else
+        LOG << positionHelper->getId() << " ignoring undelivered " << mm->getName() << " to " << mm->getDestinationId() << ": no maneuver in progress\n";
+}
+
 void GeneralPlatooningApp::scheduleSelfMsg(simtime_t t, cMessage* msg)
 {
     scheduleAt(t, msg);
@@ -281,35 +508,118 @@ void GeneralPlatooningApp::startOvertakeManeuver(int platoonId, int leaderId)
     params.platoonId = platoonId;
     params.leaderId = leaderId;
     LOG << "general app starting maneuver";
-    overtakeManeuver->startManeuver(&params);
+    getOvertakeManeuver()->startManeuver(&params);
+}
+
+bool GeneralPlatooningApp::findPlatoonAhead(int lane, double distance, int& platoonId, int& leaderId)
+{
+    if (!useNeighborTable) throw cRuntimeError("Platoon discovery requires useNeighborTable = true");
+
+    // use the same coordinates as the ones in the beacons
+    VEHICLE_DATA data;
+    plexeTraciVehicle->getVehicleData(&data);
+    const Neighbor* neighbor = neighborTable.findPlatoonAhead(data.positionX, lane, distance, positionHelper->getPlatoonId());
+    if (!neighbor) return false;
+    int leader = neighborTable.getPlatoonLeader(neighbor->platoonId);
+    if (leader < 0) return false;
+
+    platoonId = neighbor->platoonId;
+    leaderId = leader;
+    return true;
 }
 
 void GeneralPlatooningApp::changeLane()
 {
-    overtakeManeuver->changeLane();
+    getOvertakeManeuver()->changeLane();
 }
 
 void GeneralPlatooningApp::pauseOvertake()
 {
     ASSERT(getPlatoonRole() == PlatoonRole::LEADER);
-    overtakeManeuver->abortManeuver();
+    getOvertakeManeuver()->abortManeuver();
 }
 
 void GeneralPlatooningApp::emergency(bool emergency)
 {
     ASSERT(getPlatoonRole() == PlatoonRole::LEADER);
     if(emergency){
-        overtakeManeuver->fakeEmergencyStart();
+        emitManeuverEvent(ManeuverEvent::HAZARD);
+        getOvertakeManeuver()->fakeEmergencyStart();
     } else if(!emergency) {
-        overtakeManeuver->fakeEmergencyFinish();
+        getOvertakeManeuver()->fakeEmergencyFinish();
+        emitManeuverEvent(ManeuverEvent::HAZARD_CLEARED);
     }
 }
 
+void GeneralPlatooningApp::cancelOvertakes()
+{
+    ASSERT(getPlatoonRole() == PlatoonRole::LEADER);
+    if (overtakeManeuver) overtakeManeuver->cancelOvertakes();
+}
+
+std::string GeneralPlatooningApp::getManeuverState() const
+{
+    if (!activeManeuver) return "none";
+    std::string maneuver = "other";
+    if (activeManeuver == joinManeuver)
+        maneuver = "join";
+    else if (activeManeuver == mergeManeuver)
+        maneuver = "merge";
+    else if (activeManeuver == overtakeManeuver)
+        maneuver = "overtake";
+    return maneuver + "." + activeManeuver->getStateName();
+}
+
+void GeneralPlatooningApp::emitManeuverEvent(ManeuverEvent::Type type)
+{
+    if (!mayHaveListeners(PlatoonKpi::maneuverEventSignal)) return;
+    ManeuverEvent event;
+    event.type = type;
+    event.vehicleId = myId;
+    event.platoonId = positionHelper->getPlatoonId();
+    emit(PlatoonKpi::maneuverEventSignal, &event);
+}
+
 GeneralPlatooningApp::~GeneralPlatooningApp()
 {
+    cancelAndDelete(formationRepair);
+    formationRepair = nullptr;
+    delete transport;
+    delete joinManeuver;
+    delete mergeManeuver;
+    delete overtakeManeuver;
+}
+
+cOutVector* GeneralPlatooningApp::getOvertakeWaitTimeVector()
+{
+    // the vector is kept when the module is reused for another vehicle
+    if (overtakeWaitTimeOut || overtakeWaitTimeChecked) return overtakeWaitTimeOut.get();
+    overtakeWaitTimeChecked = true;
+    if (leanProfile && !isVectorRecordingEnabled(this, {"overtakeWaitTime"})) return nullptr;
+    overtakeWaitTimeOut.reset(new cOutVector("overtakeWaitTime"));
+    return overtakeWaitTimeOut.get();
+}
+
+void GeneralPlatooningApp::resetForReuse()
+{
+    cancelAndDelete(formationRepair);
+    formationRepair = nullptr;
+    delete transport;
+    transport = nullptr;
     delete joinManeuver;
+    joinManeuver = nullptr;
     delete mergeManeuver;
+    mergeManeuver = nullptr;
     delete overtakeManeuver;
+    overtakeManeuver = nullptr;
+    for (int type = 0; type < MMT_COUNT; type++) maneuverHandlers[type].clear();
+    memberFormationVersion.clear();
+    inManeuver = false;
+    activeManeuver = nullptr;
+    role = PlatoonRole::NONE;
+    formationRepairAttempts = 0;
+    lastNackedVersion = 0;
+    BaseApp::resetForReuse();
 }
 
 } // namespace plexe
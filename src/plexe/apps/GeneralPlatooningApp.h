@@ -32,10 +32,13 @@
 #include "plexe/maneuver/MergeAtBack.h"
 #include "plexe/maneuver/OvertakeManeuver.h"
 #include "plexe/maneuver/AssistedOvertake.h"
+#include "plexe/apps/ManeuverTransport.h"
 
 #include "plexe/messages/UpdatePlatoonData_m.h"
+#include "plexe/messages/UpdatePlatoonFormationAck_m.h"
 
 #include "plexe/scenarios/BaseScenario.h"
+#include "plexe/utilities/PlatoonKpi.h"
 
 #include "veins/modules/mobility/traci/TraCIConstants.h"
 #include "veins/modules/utility/SignalManager.h"
@@ -82,6 +85,12 @@ public:
         , joinManeuver(nullptr)
         , mergeManeuver(nullptr)
         , overtakeManeuver(nullptr)
+        , formationRepair(nullptr)
+        , formationRepairAttempts(0)
+        , maxFormationRepairAttempts(0)
+        , lastNackedVersion(0)
+        , transport(nullptr)
+        , overtakeWaitTimeChecked(false)
     {
     }
 
@@ -110,9 +119,18 @@ public:
     /** override from BaseApp */
     virtual void initialize(int stage) override;
 
+    /** override from BaseApp */
+    virtual void resetForReuse() override;
+
     /** override from BaseApp */
     virtual void handleSelfMsg(cMessage* msg) override;
 
+    /** override from BaseApp */
+    virtual void finish() override;
+
+    /** override from BaseApp, adding maneuvers and their timers */
+    virtual size_t getMemoryFootprint() const override;
+
     /**
      * Request start of JoinManeuver to leader
      * @param int platoonId the id of the platoon to join
@@ -153,6 +171,7 @@ public:
      */
     void setInManeuver(bool b, Maneuver* maneuver)
     {
+        if (b != inManeuver) emitManeuverEvent(b ? ManeuverEvent::STARTED : ManeuverEvent::ENDED);
         inManeuver = b;
         if (inManeuver)
             activeManeuver = maneuver;
@@ -199,6 +218,41 @@ public:
      */
     virtual void sendUnicast(cPacket* msg, int destination);
 
+    /**
+     * Encapsulates a maneuver message into a frame and sends it down to the
+     * protocol, bypassing the reliable transport
+     *
+     * @param cPacket msg message to be encapsulated
+     * @param int destination of the message
+     */
+    void sendManeuverFrame(cPacket* msg, int destination);
+
+    /**
+     * Informs the maneuver that sent a unicast maneuver message that it
+     * could not be delivered, either by the MAC or by the reliable
+     * transport, so that it can abort
+     *
+     * @param ManeuverMessage mm the message that has been lost
+     */
+    void onFailedTransmission(const ManeuverMessage* mm);
+
+    /**
+     * Sends a broadcast message
+     *
+     * @param cPacket msg message to be encapsulated into the broadcast
+     * message
+     */
+    virtual void sendBroadcast(cPacket* msg);
+
+    /**
+     * Disseminates the current formation to all platoon members with a
+     * single broadcast, tagged with a new formation version. Members
+     * acknowledge the version through their beacons: the ones that are
+     * still lagging behind after formationRepairTimeout, or that report a
+     * missing update, are repaired with a unicast message
+     */
+    void sendPlatoonFormationUpdate();
+
     /**
      * Fills members of a ManeuverMessage
      *
@@ -250,6 +304,14 @@ public:
      */
     virtual void handleUpdatePlatoonFormation(const UpdatePlatoonFormation* msg);
 
+    /**
+     * Handles a UpdatePlatoonFormationAck in the context of this
+     * application
+     *
+     * @param UpdatePlatoonFormationAck msg to handle
+     */
+    virtual void handleUpdatePlatoonFormationAck(const UpdatePlatoonFormationAck* msg);
+
     bool isJoinAllowed() const;
 
     /**
@@ -266,8 +328,56 @@ public:
 
     void startOvertakeManeuver(int platoonId, int leaderId);
 
+    /**
+     * Looks for the nearest platoon ahead on the given lane and within the
+     * given distance among the vehicles in the neighbor table. Returns
+     * false if there is none or if its leader has not been heard yet
+     */
+    bool findPlatoonAhead(int lane, double distance, int& platoonId, int& leaderId);
+
     void emergency(bool emergency);
 
+    /**
+     * Notifies a maneuver state transition of this vehicle to the listeners
+     * of PlatoonKpi::maneuverEventSignal
+     */
+    void emitManeuverEvent(ManeuverEvent::Type type);
+
+    /**
+     * Returns the active maneuver and its state (e.g., "overtake.M_OT"), or
+     * "none" if the vehicle is not in a maneuver (see MessageTracker)
+     */
+    std::string getManeuverState() const;
+
+    /** overtake counters of the leader, see OvertakeManeuver */
+    long getAdmittedOvertakes() const
+    {
+        return overtakeManeuver ? overtakeManeuver->getAdmittedOvertakes() : 0;
+    }
+    long getCompletedOvertakes() const
+    {
+        return overtakeManeuver ? overtakeManeuver->getCompletedOvertakes() : 0;
+    }
+    int getLastAdmittedOvertaker() const
+    {
+        return overtakeManeuver ? overtakeManeuver->getLastAdmittedOvertaker() : TraCIConstants::INVALID_INT_VALUE;
+    }
+    int getLastCompletedOvertaker() const
+    {
+        return overtakeManeuver ? overtakeManeuver->getLastCompletedOvertaker() : TraCIConstants::INVALID_INT_VALUE;
+    }
+
+    /** gives up the overtakes in progress, see OvertakeManeuver::cancelOvertakes() */
+    void cancelOvertakes();
+
+    /**
+     * Returns the vector recording the admission wait time of overtakers
+     * (see AssistedOvertake), or nullptr if it is not recorded with the lean
+     * profile. The vector belongs to the app and not to the maneuver, so
+     * that it is kept when the module is reused for another vehicle
+     */
+    cOutVector* getOvertakeWaitTimeVector();
+
 
 protected:
     /** override this method of BaseApp. we want to handle it ourself */
@@ -287,6 +397,15 @@ protected:
      */
     virtual void onManeuverMessage(ManeuverMessage* mm);
 
+    /**
+     * Passes a received maneuver message through the reliable transport, if
+     * enabled, and then to the proper handler. Takes ownership of the
+     * message
+     *
+     * @param ManeuverMessage mm to dispatch
+     */
+    void dispatchManeuverMessage(ManeuverMessage* mm);
+
     /** am i in a maneuver? */
     bool inManeuver;
     /** which maneuver is currently active? */
@@ -298,8 +417,45 @@ protected:
     /** used by maneuvers to schedule self messages, as they are not omnet modules */
     virtual void scheduleSelfMsg(simtime_t t, cMessage* msg);
 
+    /** sends the current formation to a member that missed an update */
+    void repairPlatoonFormation(int memberId);
+
+    /** timer for repairing formation updates not acknowledged by members */
+    cMessage* formationRepair;
+    /** number of repair rounds performed for the current formation version */
+    int formationRepairAttempts;
+    /** maximum number of repair rounds */
+    int maxFormationRepairAttempts;
+    /** time between repair rounds */
+    SimTime formationRepairTimeout;
+    /** formation version last reported by each member (leader only) */
+    std::map<int, int> memberFormationVersion;
+    /** last formation version for which a negative ack has been sent */
+    int lastNackedVersion;
+
+    /** maneuvers handling each maneuver message type */
+    std::vector<Maneuver*> maneuverHandlers[MMT_COUNT];
+
+    /** registers the maneuvers created so far for the message types they handle */
+    void updateManeuverHandlers();
+
+    /**
+     * Return the maneuver implementations, creating them on first use with
+     * the lean profile
+     */
+    JoinManeuver* getJoinManeuver();
+    JoinManeuver* getMergeManeuver();
+    OvertakeManeuver* getOvertakeManeuver();
+
+    /** reliable transport for unicast maneuver messages, nullptr if disabled */
+    ManeuverTransport* transport;
+
     BaseScenario* scenario;
 
+    /** see getOvertakeWaitTimeVector() */
+    std::unique_ptr<cOutVector> overtakeWaitTimeOut;
+    bool overtakeWaitTimeChecked;
+
 private:
     /** the role of this vehicle */
     PlatoonRole role;
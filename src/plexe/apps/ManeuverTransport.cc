@@ -0,0 +1,351 @@
+//
+// Copyright (C) 2012-2021 Michele Segata <segata@ccs-labs.org>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include "plexe/apps/ManeuverTransport.h"
+#include "plexe/apps/GeneralPlatooningApp.h"
+
+namespace plexe {
+
+ManeuverBundle::ManeuverBundle(const char* name)
+    : ManeuverMessage(name, MANEUVER_TYPE)
+{
+    setMessageType(MMT_BUNDLE);
+}
+
+ManeuverBundle::ManeuverBundle(const ManeuverBundle& other)
+    : ManeuverMessage(other)
+{
+    copy(other);
+}
+
+ManeuverBundle::~ManeuverBundle()
+{
+    clear();
+}
+
+ManeuverBundle& ManeuverBundle::operator=(const ManeuverBundle& other)
+{
+    if (this == &other) return *this;
+    ManeuverMessage::operator=(other);
+    clear();
+    copy(other);
+    return *this;
+}
+
+void ManeuverBundle::copy(const ManeuverBundle& other)
+{
+    for (ManeuverMessage* msg : other.messages) {
+        ManeuverMessage* dup = msg->dup();
+        take(dup);
+        messages.push_back(dup);
+    }
+}
+
+void ManeuverBundle::clear()
+{
+    for (ManeuverMessage* msg : messages) dropAndDelete(msg);
+    messages.clear();
+}
+
+void ManeuverBundle::addMessage(ManeuverMessage* msg)
+{
+    take(msg);
+    messages.push_back(msg);
+    addBitLength(msg->getBitLength());
+}
+
+std::vector<ManeuverMessage*> ManeuverBundle::releaseMessages()
+{
+    std::vector<ManeuverMessage*> released;
+    released.swap(messages);
+    for (ManeuverMessage* msg : released) drop(msg);
+    setBitLength(0);
+    return released;
+}
+
+ManeuverTransport::ManeuverTransport(GeneralPlatooningApp* app, simtime_t initialRto, simtime_t minRto, simtime_t maxRto, int maxRetransmissions, simtime_t ackDelay)
+    : app(app)
+    , initialRto(initialRto)
+    , minRto(minRto)
+    , maxRto(maxRto)
+    , maxRetransmissions(maxRetransmissions)
+    , ackDelay(ackDelay)
+    , sentMessages(0)
+    , retransmissions(0)
+    , duplicates(0)
+    , bundles(0)
+    , standaloneAcks(0)
+    , dropped(0)
+{
+    ASSERT2(minRto > 0 && minRto <= maxRto, "invalid retransmission timeout bounds");
+    ASSERT2(ackDelay < minRto, "acknowledgement delay must be smaller than the minimum retransmission timeout");
+    flushTimer = new cMessage("transportFlush");
+    transportTimer = new cMessage("transportTimer");
+}
+
+ManeuverTransport::~ManeuverTransport()
+{
+    app->cancelAndDelete(flushTimer);
+    app->cancelAndDelete(transportTimer);
+    for (auto& peer : peers) {
+        for (auto& pending : peer.second.unacked) delete pending.second.msg;
+    }
+    for (auto& queue : outbox) {
+        for (ManeuverMessage* msg : queue.second) delete msg;
+    }
+}
+
+ManeuverTransport::Peer& ManeuverTransport::getPeer(int id)
+{
+    auto peer = peers.find(id);
+    if (peer != peers.end()) return peer->second;
+    Peer& p = peers[id];
+    p.nextSeq = 1;
+    p.srtt = 0;
+    p.rttvar = 0;
+    p.rto = initialRto;
+    p.hasRttSample = false;
+    p.received = 0;
+    p.ackPending = false;
+    p.ackDeadline = 0;
+    return p;
+}
+
+void ManeuverTransport::send(ManeuverMessage* msg, int destination)
+{
+    Peer& peer = getPeer(destination);
+    int seq = peer.nextSeq++;
+    msg->setTransportSeq(seq);
+
+    PendingMessage pending;
+    pending.msg = msg->dup();
+    pending.lastSent = simTime();
+    pending.deadline = simTime() + peer.rto;
+    pending.retransmissions = 0;
+    peer.unacked[seq] = pending;
+
+    sentMessages++;
+    enqueue(msg, destination);
+    rescheduleTimer();
+}
+
+bool ManeuverTransport::receive(const ManeuverMessage* msg)
+{
+    bool isAck = msg->getMessageType() == MMT_TRANSPORT_ACK;
+    int seq = msg->getTransportSeq();
+    if (seq == 0 && msg->getTransportAck() == 0) return !isAck;
+
+    Peer& peer = getPeer(msg->getVehicleId());
+
+    // acknowledgement of messages we sent to this peer
+    int ack = msg->getTransportAck();
+    if (ack > 0) {
+        simtime_t rtt = -1;
+        for (auto pending = peer.unacked.begin(); pending != peer.unacked.end() && pending->first <= ack;) {
+            // karn's algorithm: retransmitted messages give ambiguous samples
+            if (pending->second.retransmissions == 0) rtt = simTime() - pending->second.lastSent;
+            delete pending->second.msg;
+            pending = peer.unacked.erase(pending);
+        }
+        if (rtt >= 0) updateRto(peer, rtt);
+    }
+
+    if (seq == 0) {
+        rescheduleTimer();
+        return !isAck;
+    }
+
+    // the sender will not retransmit anything before its base anymore
+    if (msg->getTransportBase() - 1 > peer.received) {
+        peer.received = msg->getTransportBase() - 1;
+        peer.outOfOrder.erase(peer.outOfOrder.begin(), peer.outOfOrder.upper_bound(peer.received));
+    }
+
+    bool duplicate = seq <= peer.received || peer.outOfOrder.count(seq) != 0;
+    if (!duplicate) {
+        peer.outOfOrder.insert(seq);
+        while (!peer.outOfOrder.empty() && *peer.outOfOrder.begin() == peer.received + 1) {
+            peer.received++;
+            peer.outOfOrder.erase(peer.outOfOrder.begin());
+        }
+    }
+    else {
+        duplicates++;
+    }
+
+    // acknowledge duplicates as well, as our previous ack might have been lost
+    if (!peer.ackPending) {
+        peer.ackPending = true;
+        peer.ackDeadline = simTime() + ackDelay;
+    }
+    rescheduleTimer();
+
+    return !duplicate;
+}
+
+bool ManeuverTransport::handleSelfMsg(cMessage* msg)
+{
+    if (msg == flushTimer) {
+        flush();
+        return true;
+    }
+    if (msg == transportTimer) {
+        onTimer();
+        return true;
+    }
+    return false;
+}
+
+void ManeuverTransport::enqueue(ManeuverMessage* msg, int destination)
+{
+    outbox[destination].push_back(msg);
+    if (!flushTimer->isScheduled()) app->scheduleAt(simTime(), flushTimer);
+}
+
+void ManeuverTransport::flush()
+{
+    if (flushTimer->isScheduled()) app->cancelEvent(flushTimer);
+
+    for (auto& queue : outbox) {
+        int destination = queue.first;
+        std::vector<ManeuverMessage*>& msgs = queue.second;
+        if (msgs.empty()) continue;
+
+        Peer& peer = getPeer(destination);
+        int base = peer.unacked.empty() ? peer.nextSeq : peer.unacked.begin()->first;
+        for (ManeuverMessage* msg : msgs) {
+            msg->setTransportAck(peer.received);
+            msg->setTransportBase(base);
+        }
+        peer.ackPending = false;
+
+        if (msgs.size() == 1) {
+            app->sendManeuverFrame(msgs[0], destination);
+        }
+        else {
+            ManeuverBundle* bundle = new ManeuverBundle();
+            BasePositionHelper* positionHelper = app->getPositionHelper();
+            app->fillManeuverMessage(bundle, positionHelper->getId(), positionHelper->getExternalId(), positionHelper->getPlatoonId(), destination);
+            for (ManeuverMessage* msg : msgs) bundle->addMessage(msg);
+            bundles++;
+            app->sendManeuverFrame(bundle, destination);
+        }
+        msgs.clear();
+    }
+    outbox.clear();
+}
+
+void ManeuverTransport::onTimer()
+{
+    simtime_t now = simTime();
+    // messages given up on. the maneuvers are told only at the end, as they
+    // might send new messages in reaction
+    std::vector<ManeuverMessage*> failed;
+    for (auto& p : peers) {
+        int id = p.first;
+        Peer& peer = p.second;
+
+        bool backoff = false;
+        for (auto pending = peer.unacked.begin(); pending != peer.unacked.end();) {
+            if (pending->second.deadline > now) {
+                pending++;
+                continue;
+            }
+            if (pending->second.retransmissions >= maxRetransmissions) {
+                LOG << app->getPositionHelper()->getId() << " giving up on " << pending->second.msg->getName() << " to " << id << " after " << maxRetransmissions << " retransmissions\n";
+                dropped++;
+                failed.push_back(pending->second.msg);
+                pending = peer.unacked.erase(pending);
+                continue;
+            }
+            // exponential backoff, once per timer expiration
+            if (!backoff) {
+                peer.rto = std::min(peer.rto * 2, maxRto);
+                backoff = true;
+            }
+            pending->second.retransmissions++;
+            pending->second.lastSent = now;
+            pending->second.deadline = now + peer.rto;
+            retransmissions++;
+            enqueue(pending->second.msg->dup(), id);
+            pending++;
+        }
+
+        // no maneuver message to piggyback the acknowledgement on
+        if (peer.ackPending && peer.ackDeadline <= now && outbox.find(id) == outbox.end()) {
+            TransportAck* ack = new TransportAck("TransportAck");
+            BasePositionHelper* positionHelper = app->getPositionHelper();
+            app->fillManeuverMessage(ack, positionHelper->getId(), positionHelper->getExternalId(), positionHelper->getPlatoonId(), id);
+            standaloneAcks++;
+            enqueue(ack, id);
+        }
+    }
+    flush();
+    rescheduleTimer();
+
+    for (ManeuverMessage* msg : failed) {
+        app->onFailedTransmission(msg);
+        delete msg;
+    }
+}
+
+void ManeuverTransport::rescheduleTimer()
+{
+    simtime_t next = SimTime::getMaxTime();
+    for (auto& p : peers) {
+        const Peer& peer = p.second;
+        for (auto& pending : peer.unacked) next = std::min(next, pending.second.deadline);
+        if (peer.ackPending) next = std::min(next, peer.ackDeadline);
+    }
+    if (transportTimer->isScheduled()) {
+        if (transportTimer->getArrivalTime() == next) return;
+        app->cancelEvent(transportTimer);
+    }
+    if (next != SimTime::getMaxTime()) app->scheduleAt(next, transportTimer);
+}
+
+void ManeuverTransport::updateRto(Peer& peer, simtime_t rtt)
+{
+    // RFC 6298, section 2
+    if (!peer.hasRttSample) {
+        peer.srtt = rtt;
+        peer.rttvar = rtt / 2;
+        peer.hasRttSample = true;
+    }
+    else {
+        simtime_t delta = peer.srtt - rtt;
+        if (delta < 0) delta = -delta;
+        peer.rttvar = peer.rttvar * 0.75 + delta * 0.25;
+        peer.srtt = peer.srtt * 0.875 + rtt * 0.125;
+    }
+    peer.rto = std::max(minRto, std::min(maxRto, peer.srtt + peer.rttvar * 4));
+}
+
+void ManeuverTransport::recordStatistics()
+{
+    app->recordScalar("transportSentMessages", sentMessages);
+    app->recordScalar("transportRetransmissions", retransmissions);
+    app->recordScalar("transportDuplicates", duplicates);
+    app->recordScalar("transportBundles", bundles);
+    app->recordScalar("transportStandaloneAcks", standaloneAcks);
+    app->recordScalar("transportDropped", dropped);
+}
+
+} // namespace plexe
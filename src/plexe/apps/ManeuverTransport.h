@@ -0,0 +1,185 @@
+//
+// Copyright (C) 2012-2021 Michele Segata <segata@ccs-labs.org>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#ifndef MANEUVERTRANSPORT_H_
+#define MANEUVERTRANSPORT_H_
+
+#include <map>
+#include <set>
+#include <vector>
+
+#include "plexe/plexe.h"
+#include "plexe/messages/ManeuverMessage_m.h"
+#include "plexe/messages/TransportAck_m.h"
+
+namespace plexe {
+
+class GeneralPlatooningApp;
+
+/**
+ * Maneuver message carrying several other maneuver messages for the same
+ * destination, so that they share a single frame
+ */
+class ManeuverBundle : public ManeuverMessage {
+
+public:
+    ManeuverBundle(const char* name = "ManeuverBundle");
+    ManeuverBundle(const ManeuverBundle& other);
+    virtual ~ManeuverBundle();
+    ManeuverBundle& operator=(const ManeuverBundle& other);
+    virtual ManeuverBundle* dup() const override
+    {
+        return new ManeuverBundle(*this);
+    }
+
+    /**
+     * Adds a message to the bundle, which takes ownership of it
+     */
+    void addMessage(ManeuverMessage* msg);
+
+    /**
+     * Removes all messages from the bundle and returns them. The caller
+     * becomes responsible for freeing them
+     */
+    std::vector<ManeuverMessage*> releaseMessages();
+
+    size_t getMessageCount() const
+    {
+        return messages.size();
+    }
+
+private:
+    void copy(const ManeuverBundle& other);
+    void clear();
+
+    std::vector<ManeuverMessage*> messages;
+};
+
+/**
+ * End-to-end reliable transport for maneuver messages, sitting between the
+ * GeneralPlatooningApp and the network. Unicast maneuver messages are
+ * numbered per destination and kept until acknowledged, with retransmission
+ * timers adapted to the measured round trip time as in RFC 6298.
+ * Receivers suppress duplicates and acknowledge cumulatively, piggybacking
+ * the acknowledgement on maneuver messages going in the opposite direction
+ * or sending a TransportAck after a short delay if there is none. Messages
+ * for the same destination issued within the same event, including
+ * retransmissions, are bundled into a single frame.
+ *
+ * Failed MAC transmissions are recovered through retransmissions instead of
+ * being reported to the maneuvers. After the maximum number of
+ * retransmissions the message is dropped and reported to the maneuvers as
+ * a failed transmission (see GeneralPlatooningApp::onFailedTransmission()).
+ */
+class ManeuverTransport {
+
+public:
+    ManeuverTransport(GeneralPlatooningApp* app, simtime_t initialRto, simtime_t minRto, simtime_t maxRto, int maxRetransmissions, simtime_t ackDelay);
+    virtual ~ManeuverTransport();
+
+    /**
+     * Sends a maneuver message reliably. Takes ownership of the message
+     */
+    void send(ManeuverMessage* msg, int destination);
+
+    /**
+     * Processes the transport information of a received message. Returns
+     * false if the message must not be passed to the application, i.e., if
+     * it is a duplicate or a standalone acknowledgement
+     */
+    bool receive(const ManeuverMessage* msg);
+
+    /**
+     * Invoked by the application for its self messages. Returns true if the
+     * message belongs to the transport
+     */
+    bool handleSelfMsg(cMessage* msg);
+
+    /**
+     * Records transport statistics as scalars of the application
+     */
+    void recordStatistics();
+
+protected:
+    // a message waiting for an acknowledgement
+    typedef struct {
+        ManeuverMessage* msg;
+        simtime_t lastSent;
+        simtime_t deadline;
+        int retransmissions;
+    } PendingMessage;
+
+    // transport state for a communication peer
+    typedef struct {
+        // sender side
+        int nextSeq;
+        std::map<int, PendingMessage> unacked;
+        simtime_t srtt;
+        simtime_t rttvar;
+        simtime_t rto;
+        bool hasRttSample;
+        // receiver side
+        int received;
+        std::set<int> outOfOrder;
+        bool ackPending;
+        simtime_t ackDeadline;
+    } Peer;
+
+    Peer& getPeer(int id);
+
+    // queues a message for transmission in the current event
+    void enqueue(ManeuverMessage* msg, int destination);
+    // sends all queued messages, bundling the ones for the same destination
+    void flush();
+    // retransmits expired messages and sends delayed acknowledgements
+    void onTimer();
+    // re-arms the timer for the earliest retransmission or acknowledgement
+    void rescheduleTimer();
+    // updates the retransmission timeout with a new rtt sample
+    void updateRto(Peer& peer, simtime_t rtt);
+
+    GeneralPlatooningApp* app;
+
+    simtime_t initialRto;
+    simtime_t minRto;
+    simtime_t maxRto;
+    int maxRetransmissions;
+    simtime_t ackDelay;
+
+    std::map<int, Peer> peers;
+    std::map<int, std::vector<ManeuverMessage*>> outbox;
+
+    // zero-delay timer used to gather messages to be bundled
+    cMessage* flushTimer;
+    // timer for retransmissions and delayed acknowledgements
+    cMessage* transportTimer;
+
+    // statistics
+    long sentMessages;
+    long retransmissions;
+    long duplicates;
+    long bundles;
+    long standaloneAcks;
+    long dropped;
+};
+
+} // namespace plexe
+
+#endif
@@ -0,0 +1,49 @@
+//
+// Copyright (C) 2012-2021 Michele Segata <segata@ccs-labs.org>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include "plexe/driver/BackgroundLoad.h"
+
+#include <algorithm>
+
+namespace plexe {
+
+Define_Module(BackgroundLoad);
+
+void BackgroundLoad::initialize()
+{
+    density = par("density").doubleValue() / 1000;
+    if (density < 0) throw cRuntimeError("Background transmitter density cannot be negative");
+    double beaconingInterval = par("beaconingInterval").doubleValue();
+    if (beaconingInterval <= 0) throw cRuntimeError("Background beaconing interval must be positive");
+    rate = 1 / beaconingInterval;
+    airtime = par("phyOverhead").doubleValue() + par("packetSize").intValue() * 8 / par("bitrate").doubleValue();
+}
+
+double BackgroundLoad::getInterferers(double range) const
+{
+    return density * 2 * range;
+}
+
+double BackgroundLoad::getBusyRatio(double range) const
+{
+    return std::min(1.0, getInterferers(range) * rate * airtime);
+}
+
+} // namespace plexe
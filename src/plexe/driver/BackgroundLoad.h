@@ -0,0 +1,78 @@
+//
+// Copyright (C) 2012-2021 Michele Segata <segata@ccs-labs.org>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#pragma once
+
+#include "plexe/plexe.h"
+
+namespace plexe {
+
+/**
+ * Analytical model of the channel load generated by vehicles which are not
+ * simulated as network nodes, e.g., human driven cars beaconing on the
+ * same channel as platoons. Background transmitters are assumed to be
+ * uniformly distributed along the road with a given linear density (all
+ * lanes together), each sending one frame of fixed size per beacon
+ * interval. PerRadioDriver queries the model to account for the
+ * equivalent channel occupancy instead of exchanging frames with the
+ * background vehicles. The 802.11p NIC has no hook to inject it.
+ */
+class BackgroundLoad : public cSimpleModule {
+
+public:
+    BackgroundLoad()
+        : density(0)
+        , rate(0)
+        , airtime(0)
+    {
+    }
+
+    virtual void initialize() override;
+
+    /**
+     * Returns the average number of background transmitters within the
+     * given range of a radio
+     */
+    double getInterferers(double range) const;
+
+    /**
+     * Returns the fraction of time a radio senses the channel busy because
+     * of background transmissions within the given range
+     */
+    double getBusyRatio(double range) const;
+
+    /**
+     * Returns the duration of a background transmission
+     */
+    double getAirtime() const
+    {
+        return airtime;
+    }
+
+protected:
+    // background transmitters per meter of road
+    double density;
+    // frames per second sent by each background transmitter
+    double rate;
+    // duration of a background frame in seconds
+    double airtime;
+};
+
+} // namespace plexe
@@ -0,0 +1,134 @@
+//
+// Copyright (C) 2012-2021 Michele Segata <segata@ccs-labs.org>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include "plexe/driver/PerChannel.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "plexe/plexe.h"
+
+using namespace veins;
+
+namespace plexe {
+
+PerChannel& PerChannel::getInstance()
+{
+    static PerChannel instance;
+    return instance;
+}
+
+void PerChannel::setCellSize(double cellSize)
+{
+    if (cellSize == this->cellSize) return;
+    ASSERT2(radios.empty(), "cannot change the grid cell size with radios on the channel");
+    ASSERT2(cellSize > 0, "grid cell size must be positive");
+    this->cellSize = cellSize;
+}
+
+PerChannel::Cell PerChannel::getCell(const Coord& position) const
+{
+    return Cell((int) std::floor(position.x / cellSize), (int) std::floor(position.y / cellSize));
+}
+
+void PerChannel::removeFromCell(PerRadioDriver* radio, const Cell& cell)
+{
+    auto entry = grid.find(cell);
+    if (entry == grid.end()) return;
+    std::vector<PerRadioDriver*>& cellRadios = entry->second;
+    auto r = std::find(cellRadios.begin(), cellRadios.end(), radio);
+    if (r != cellRadios.end()) {
+        // order within a cell does not matter
+        *r = cellRadios.back();
+        cellRadios.pop_back();
+    }
+    if (cellRadios.empty()) grid.erase(entry);
+}
+
+void PerChannel::updatePosition(PerRadioDriver* radio, const Coord& position)
+{
+    Cell cell = getCell(position);
+    auto info = radios.find(radio);
+    if (info == radios.end()) {
+        radios[radio] = {cell, position};
+        grid[cell].push_back(radio);
+        return;
+    }
+    info->second.position = position;
+    if (info->second.cell != cell) {
+        removeFromCell(radio, info->second.cell);
+        grid[cell].push_back(radio);
+        info->second.cell = cell;
+    }
+}
+
+void PerChannel::removeRadio(PerRadioDriver* radio)
+{
+    auto info = radios.find(radio);
+    if (info != radios.end()) {
+        removeFromCell(radio, info->second.cell);
+        radios.erase(info);
+    }
+    for (auto node = nodes.begin(); node != nodes.end();) {
+        if (node->second == radio)
+            node = nodes.erase(node);
+        else
+            node++;
+    }
+}
+
+void PerChannel::registerNode(PerRadioDriver* radio, int nodeId)
+{
+    nodes[nodeId] = radio;
+}
+
+PerRadioDriver* PerChannel::getRadio(int nodeId) const
+{
+    auto node = nodes.find(nodeId);
+    if (node == nodes.end()) return nullptr;
+    return node->second;
+}
+
+const Coord& PerChannel::getPosition(const PerRadioDriver* radio) const
+{
+    auto info = radios.find(radio);
+    ASSERT2(info != radios.end(), "radio is not on the channel");
+    return info->second.position;
+}
+
+void PerChannel::getNeighbors(const PerRadioDriver* radio, const Coord& position, double range, std::vector<std::pair<PerRadioDriver*, double>>& neighbors) const
+{
+    neighbors.clear();
+    Cell center = getCell(position);
+    int rings = (int) std::ceil(range / cellSize);
+    for (int x = center.first - rings; x <= center.first + rings; x++) {
+        for (int y = center.second - rings; y <= center.second + rings; y++) {
+            auto cell = grid.find(Cell(x, y));
+            if (cell == grid.end()) continue;
+            for (PerRadioDriver* other : cell->second) {
+                if (other == radio) continue;
+                double distance = position.distance(radios.find(other)->second.position);
+                if (distance <= range) neighbors.push_back(std::make_pair(other, distance));
+            }
+        }
+    }
+}
+
+} // namespace plexe
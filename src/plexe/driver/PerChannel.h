@@ -0,0 +1,104 @@
+//
+// Copyright (C) 2012-2021 Michele Segata <segata@ccs-labs.org>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#pragma once
+
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include "veins/base/utils/Coord.h"
+
+namespace plexe {
+
+class PerRadioDriver;
+
+/**
+ * Shared medium for PerRadioDriver instances. Radios are kept in a uniform
+ * grid of square cells so that neighbours within communication range can be
+ * found by looking at the surrounding cells only, instead of scanning all
+ * the vehicles in the simulation.
+ */
+class PerChannel {
+
+public:
+    static PerChannel& getInstance();
+
+    /**
+     * Sets the size of the grid cells. Should be at least equal to the
+     * communication range. Can only be changed while the channel is empty
+     */
+    void setCellSize(double cellSize);
+
+    /**
+     * Adds a radio to the channel or moves it to its new position
+     */
+    void updatePosition(PerRadioDriver* radio, const veins::Coord& position);
+
+    /**
+     * Removes a radio from the channel
+     */
+    void removeRadio(PerRadioDriver* radio);
+
+    /**
+     * Binds a radio to a vehicle id, used for unicast transmissions
+     */
+    void registerNode(PerRadioDriver* radio, int nodeId);
+
+    /**
+     * Returns the radio bound to the given id, or nullptr if none
+     */
+    PerRadioDriver* getRadio(int nodeId) const;
+
+    /**
+     * Returns the position of a radio as last reported to the channel
+     */
+    const veins::Coord& getPosition(const PerRadioDriver* radio) const;
+
+    /**
+     * Fills neighbors with the radios within range from the given
+     * position, excluding the given radio itself
+     */
+    void getNeighbors(const PerRadioDriver* radio, const veins::Coord& position, double range, std::vector<std::pair<PerRadioDriver*, double>>& neighbors) const;
+
+private:
+    PerChannel()
+        : cellSize(1000)
+    {
+    }
+
+    typedef std::pair<int, int> Cell;
+    typedef std::map<Cell, std::vector<PerRadioDriver*>> Grid;
+
+    typedef struct {
+        Cell cell;
+        veins::Coord position;
+    } RadioInfo;
+
+    Cell getCell(const veins::Coord& position) const;
+    void removeFromCell(PerRadioDriver* radio, const Cell& cell);
+
+    double cellSize;
+    Grid grid;
+    std::unordered_map<const PerRadioDriver*, RadioInfo> radios;
+    std::unordered_map<int, PerRadioDriver*> nodes;
+};
+
+} // namespace plexe
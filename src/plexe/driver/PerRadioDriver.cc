@@ -0,0 +1,241 @@
+//
+// Copyright (C) 2012-2021 Michele Segata <segata@ccs-labs.org>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include "plexe/driver/PerRadioDriver.h"
+
+#include <algorithm>
+
+#include "veins/base/modules/BaseMobility.h"
+#include "veins/base/utils/FindModule.h"
+#include "veins/modules/messages/BaseFrame1609_4_m.h"
+#include "veins/modules/mac/ieee80211p/Mac1609_4.h"
+
+using namespace veins;
+
+namespace plexe {
+
+Define_Module(PerRadioDriver);
+
+void PerRadioDriver::initialize(int stage)
+{
+    BaseApplLayer::initialize(stage);
+
+    if (stage == 0) {
+        range = par("range").doubleValue();
+        bitrate = par("bitrate").doubleValue();
+        unicastRetries = par("unicastRetries").intValue();
+        ASSERT2(unicastRetries > 0, "unicastRetries must be at least 1");
+
+        // load the packet error rate table
+        distances = cStringTokenizer(par("perDistances").stringValue()).asDoubleVector();
+        loads = cStringTokenizer(par("perLoads").stringValue()).asDoubleVector();
+        cStringTokenizer rows(par("perTable").stringValue(), ";");
+        while (rows.hasMoreTokens()) {
+            per.push_back(cStringTokenizer(rows.nextToken()).asDoubleVector());
+        }
+        if (distances.empty() || loads.empty()) throw cRuntimeError("PER table needs at least one distance and one load value");
+        if (per.size() != loads.size()) throw cRuntimeError("PER table has %d rows but %d load values are given", (int) per.size(), (int) loads.size());
+        for (const auto& row : per) {
+            if (row.size() != distances.size()) throw cRuntimeError("PER table has rows with %d columns but %d distance values are given", (int) row.size(), (int) distances.size());
+        }
+        if (!std::is_sorted(distances.begin(), distances.end()) || !std::is_sorted(loads.begin(), loads.end())) throw cRuntimeError("PER table distances and loads must be sorted");
+
+        directIn = findGate("directIn");
+
+        // radios are searched within a radius of one cell
+        PerChannel::getInstance().setCellSize(range);
+
+        backgroundLoad = FindModule<BackgroundLoad*>::findGlobalModule();
+
+        mobility = TraCIMobilityAccess().get(getParentModule());
+        ASSERT(mobility);
+        findHost()->subscribe(BaseMobility::mobilityStateChangedSignal, this);
+    }
+
+    if (stage == 1) {
+        PerChannel::getInstance().updatePosition(this, mobility->getPositionAt(simTime()));
+    }
+}
+
+PerRadioDriver::~PerRadioDriver()
+{
+    PerChannel::getInstance().removeRadio(this);
+}
+
+void PerRadioDriver::resetForReuse()
+{
+    PerChannel::getInstance().removeRadio(this);
+    nodeId = -1;
+    // the scenario manager only cancels them, as for any other timer
+    for (cMessage* failure : pendingFailures) cancelAndDelete(failure);
+    pendingFailures.clear();
+    distances.clear();
+    loads.clear();
+    per.clear();
+    sentFrames = 0;
+    receivedFrames = 0;
+    lostFrames = 0;
+}
+
+void PerRadioDriver::finish()
+{
+    recordScalar("perSentFrames", sentFrames);
+    recordScalar("perReceivedFrames", receivedFrames);
+    recordScalar("perLostFrames", lostFrames);
+    BaseApplLayer::finish();
+}
+
+bool PerRadioDriver::registerNode(int nodeId)
+{
+    this->nodeId = nodeId;
+    PerChannel::getInstance().registerNode(this, nodeId);
+    return true;
+}
+
+void PerRadioDriver::receiveSignal(cComponent* source, simsignal_t signalID, cObject* obj, cObject* details)
+{
+    if (signalID == BaseMobility::mobilityStateChangedSignal && source == mobility) {
+        PerChannel::getInstance().updatePosition(this, mobility->getPositionAt(simTime()));
+    }
+}
+
+double PerRadioDriver::getPer(double distance, double load) const
+{
+    if (distance > range) return 1;
+
+    // find the interpolation interval and weight for a sorted vector of values
+    auto interval = [](const std::vector<double>& values, double v, int& i, double& w) {
+        if (v <= values.front() || values.size() == 1) {
+            i = 0;
+            w = 0;
+            return;
+        }
+        if (v >= values.back()) {
+            i = values.size() - 2;
+            w = 1;
+            return;
+        }
+        i = std::upper_bound(values.begin(), values.end(), v) - values.begin() - 1;
+        w = (v - values[i]) / (values[i + 1] - values[i]);
+    };
+
+    int d, l;
+    double wd, wl;
+    interval(distances, distance, d, wd);
+    interval(loads, load, l, wl);
+    int d1 = std::min<int>(d + 1, distances.size() - 1);
+    int l1 = std::min<int>(l + 1, loads.size() - 1);
+
+    // bilinear interpolation between the four surrounding table entries
+    double low = per[l][d] * (1 - wd) + per[l][d1] * wd;
+    double high = per[l1][d] * (1 - wd) + per[l1][d1] * wd;
+    return low * (1 - wl) + high * wl;
+}
+
+bool PerRadioDriver::isReceived(double distance, double load)
+{
+    return uniform(0, 1) >= getPer(distance, load);
+}
+
+simtime_t PerRadioDriver::getAccessDelay()
+{
+    if (!backgroundLoad || uniform(0, 1) >= backgroundLoad->getBusyRatio(range)) return 0;
+    // wait for the residual time of the ongoing background frame
+    return uniform(0, backgroundLoad->getAirtime());
+}
+
+void PerRadioDriver::handleMessage(cMessage* msg)
+{
+    if (msg->getArrivalGateId() == directIn) {
+        receivedFrames++;
+        sendUp(msg);
+    }
+    else {
+        BaseApplLayer::handleMessage(msg);
+    }
+}
+
+void PerRadioDriver::handleSelfMsg(cMessage* msg)
+{
+    // a unicast frame which could not be delivered. notify the application
+    // in the same way the 802.11p MAC does
+    BaseFrame1609_4* frame = check_and_cast<BaseFrame1609_4*>(msg);
+    pendingFailures.erase(frame);
+    emit(Mac1609_4::sigRetriesExceeded, frame);
+    delete frame;
+}
+
+void PerRadioDriver::handleUpperMsg(cMessage* msg)
+{
+    BaseFrame1609_4* frame = check_and_cast<BaseFrame1609_4*>(msg);
+    // interface selection is meaningless past the driver, as in the 802.11p MAC
+    delete frame->removeControlInfo();
+    PerChannel& channel = PerChannel::getInstance();
+    const Coord& position = channel.getPosition(this);
+
+    sentFrames++;
+    // the number of radios within range is used as channel load indicator
+    channel.getNeighbors(this, position, range, neighbors);
+    double load = neighbors.size();
+    // background transmitters only raise the load. the PER table already
+    // accounts for the collisions at this load, so they are not drawn again
+    if (backgroundLoad) load += backgroundLoad->getInterferers(range);
+    double duration = frame->getBitLength() / bitrate;
+    simtime_t accessDelay = getAccessDelay();
+
+    if (frame->getRecipientAddress() == LAddress::L2BROADCAST()) {
+        for (auto& neighbor : neighbors) {
+            if (isReceived(neighbor.second, load))
+                deliver(frame->dup(), neighbor.first, accessDelay);
+            else
+                lostFrames++;
+        }
+        delete frame;
+        return;
+    }
+
+    // unicast frame. emulate MAC retransmissions with independent attempts
+    PerRadioDriver* destination = channel.getRadio(frame->getRecipientAddress());
+    double distance = destination ? position.distance(channel.getPosition(destination)) : range + 1;
+    simtime_t failureDelay = accessDelay;
+    for (int attempt = 0; attempt < unicastRetries; attempt++) {
+        if (destination && isReceived(distance, load)) {
+            deliver(frame, destination, failureDelay);
+            return;
+        }
+        lostFrames++;
+        failureDelay += par("latency").doubleValue() + duration;
+    }
+    pendingFailures.insert(frame);
+    scheduleAt(simTime() + failureDelay, frame);
+}
+
+void PerRadioDriver::handleLowerMsg(cMessage* msg)
+{
+    throw cRuntimeError("PerRadioDriver has no lower layer");
+}
+
+void PerRadioDriver::deliver(cPacket* frame, PerRadioDriver* destination, simtime_t extraDelay)
+{
+    simtime_t delay = extraDelay + par("latency").doubleValue() + frame->getBitLength() / bitrate;
+    sendDirect(frame, delay, 0, destination->gate(destination->directIn));
+}
+
+} // namespace plexe
@@ -0,0 +1,139 @@
+//
+// Copyright (C) 2012-2021 Michele Segata <segata@ccs-labs.org>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#pragma once
+
+#include <set>
+#include <vector>
+
+#include "veins/base/modules/BaseApplLayer.h"
+#include "veins/modules/mobility/traci/TraCIMobility.h"
+#include "plexe/driver/PlexeRadioDriverInterface.h"
+#include "plexe/driver/PerChannel.h"
+#include "plexe/driver/BackgroundLoad.h"
+#include "plexe/utilities/RecyclableModule.h"
+
+namespace plexe {
+
+/**
+ * Abstract radio that replaces the 802.11p MAC and PHY with a lookup table
+ * of packet error rates indexed by distance and channel load. Frames are
+ * delivered directly to the drivers of the receiving vehicles after a
+ * configurable latency. The driver reports itself as an 802.11p device, so
+ * protocols and applications can use it without modifications.
+ */
+class PerRadioDriver : public PlexeRadioDriverInterface, public veins::BaseApplLayer, public RecyclableModule {
+
+public:
+    PerRadioDriver()
+        : mobility(nullptr)
+        , backgroundLoad(nullptr)
+        , nodeId(-1)
+        , range(0)
+        , bitrate(0)
+        , unicastRetries(0)
+        , directIn(-1)
+        , sentFrames(0)
+        , receivedFrames(0)
+        , lostFrames(0)
+    {
+    }
+    virtual ~PerRadioDriver();
+
+    virtual void initialize(int stage) override;
+    virtual void finish() override;
+    virtual void resetForReuse() override;
+    virtual int numInitStages() const override
+    {
+        return 2;
+    }
+
+    virtual bool registerNode(int nodeId) override;
+    virtual int getDeviceType() override
+    {
+        return PlexeRadioInterfaces::VEINS_11P;
+    }
+
+    /**
+     * Returns the packet error rate for a frame travelling the given
+     * distance when the given number of radios share the channel
+     */
+    double getPer(double distance, double load) const;
+
+    using veins::BaseApplLayer::receiveSignal;
+    virtual void receiveSignal(cComponent* source, simsignal_t signalID, cObject* obj, cObject* details) override;
+
+protected:
+    virtual void handleMessage(cMessage* msg) override;
+    virtual void handleSelfMsg(cMessage* msg) override;
+    virtual void handleUpperMsg(cMessage* msg) override;
+    virtual void handleLowerMsg(cMessage* msg) override;
+
+    /**
+     * Delivers the frame to the given radio after the channel latency plus
+     * the given extra delay. Takes ownership of the frame
+     */
+    void deliver(cPacket* frame, PerRadioDriver* destination, simtime_t extraDelay = 0);
+
+    /**
+     * Draws whether a frame is correctly received at the given distance
+     * and channel load
+     */
+    bool isReceived(double distance, double load);
+
+    /**
+     * Draws the time spent waiting for background transmissions to end
+     * before accessing the channel
+     */
+    simtime_t getAccessDelay();
+
+    veins::TraCIMobility* mobility;
+    // analytical load of vehicles not simulated as nodes, if any
+    BackgroundLoad* backgroundLoad;
+    int nodeId;
+
+    // maximum communication range
+    double range;
+    // transmission bitrate, used to compute the airtime of a frame
+    double bitrate;
+    // number of attempts for unicast frames before giving up
+    int unicastRetries;
+
+    // packet error rate table, one row per load value, one column per distance
+    std::vector<double> distances;
+    std::vector<double> loads;
+    std::vector<std::vector<double>> per;
+
+    // gate where frames sent by other drivers arrive
+    int directIn;
+
+    // statistics
+    long sentFrames;
+    long receivedFrames;
+    long lostFrames;
+
+    // undelivered unicast frames waiting to be reported to the application
+    std::set<cMessage*> pendingFailures;
+
+    // reused neighbor buffer to avoid allocations
+    std::vector<std::pair<PerRadioDriver*, double>> neighbors;
+};
+
+} // namespace plexe
@@ -38,6 +38,12 @@ public:
 
     // returns the type of the device which is used by the protocols to choose the proper radio interface
     virtual int getDeviceType() = 0;
+
+    // binds the radio to the given vehicle id, which is used as network address by the protocols
+    virtual bool registerNode(int nodeId)
+    {
+        return true;
+    }
 };
 
 } /* namespace plexe */
@@ -0,0 +1,200 @@
+//
+// Copyright (C) 2012-2021 Michele Segata <segata@ccs-labs.org>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include "plexe/driver/RadioTrace.h"
+
+#include <algorithm>
+#include <sstream>
+
+namespace plexe {
+
+RadioTrace& RadioTrace::getInstance()
+{
+    static RadioTrace instance;
+    return instance;
+}
+
+void RadioTrace::startRecording(const std::string& file)
+{
+    if (file == recordFile && out.is_open()) return;
+    if (out.is_open()) out.close();
+    out.open(file);
+    if (!out) throw cRuntimeError("Unable to open radio trace %s for writing", file.c_str());
+    recordFile = file;
+}
+
+void RadioTrace::recordTransmission(long frameId, simtime_t time, int sender, int destination, short kind, int64_t bits)
+{
+    out << "T " << frameId << " " << time << " " << sender << " " << destination << " " << kind << " " << bits << "\n";
+}
+
+void RadioTrace::recordDelivery(long frameId, simtime_t time, int receiver)
+{
+    out << "D " << frameId << " " << time << " " << receiver << "\n";
+}
+
+void RadioTrace::recordFailure(long frameId, simtime_t time)
+{
+    out << "F " << frameId << " " << time << "\n";
+}
+
+void RadioTrace::flush()
+{
+    if (out.is_open()) out.flush();
+}
+
+void RadioTrace::load(const std::string& file)
+{
+    // every driver loads the trace, but replayed frames are only forgotten
+    // when a new run starts
+    std::string run = getEnvir()->getConfigEx()->getVariable("runid");
+    if (file == loadedFile) {
+        if (run != loadedRun) {
+            for (auto& sent : transmissions)
+                for (auto& transmission : sent.second) transmission.used = false;
+            loadedRun = run;
+        }
+        return;
+    }
+    std::ifstream in(file);
+    if (!in) throw cRuntimeError("Unable to open radio trace %s", file.c_str());
+    parse(in, file);
+    loadedFile = file;
+    loadedRun = run;
+}
+
+void RadioTrace::parse(std::istream& in, const std::string& file)
+{
+    transmissions.clear();
+    // position of each frame in the vector of its sender
+    std::unordered_map<long, std::pair<int, size_t>> frames;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        lineNumber++;
+        if (line.empty()) continue;
+        std::istringstream fields(line);
+        char event;
+        long frameId;
+        std::string time;
+        fields >> event >> frameId >> time;
+        if (!fields) throw cRuntimeError("Invalid event in radio trace %s, line %d", file.c_str(), lineNumber);
+
+        if (event == 'T') {
+            int sender;
+            Transmission transmission;
+            int64_t bits;
+            fields >> sender >> transmission.destination >> transmission.kind >> bits;
+            if (!fields) throw cRuntimeError("Invalid transmission in radio trace %s, line %d", file.c_str(), lineNumber);
+            transmission.time = SimTime::parse(time.c_str());
+            transmission.failed = false;
+            transmission.used = false;
+            std::vector<Transmission>& sent = transmissions[sender];
+            frames[frameId] = std::make_pair(sender, sent.size());
+            sent.push_back(transmission);
+            continue;
+        }
+
+        // deliveries and failures of frames sent before the trace was started are ignored
+        auto frame = frames.find(frameId);
+        if (frame == frames.end()) continue;
+        Transmission& transmission = transmissions[frame->second.first][frame->second.second];
+        if (event == 'D') {
+            Delivery delivery;
+            fields >> delivery.receiver;
+            if (!fields) throw cRuntimeError("Invalid delivery in radio trace %s, line %d", file.c_str(), lineNumber);
+            delivery.delay = SimTime::parse(time.c_str()) - transmission.time;
+            transmission.deliveries.push_back(delivery);
+        }
+        else if (event == 'F') {
+            transmission.failed = true;
+            transmission.failureDelay = SimTime::parse(time.c_str()) - transmission.time;
+        }
+        else {
+            throw cRuntimeError("Unknown event %c in radio trace %s, line %d", event, file.c_str(), lineNumber);
+        }
+    }
+}
+
+RadioTrace::Transmission* RadioTrace::match(int sender, int destination, simtime_t time, simtime_t window)
+{
+    auto sent = transmissions.find(sender);
+    if (sent == transmissions.end()) return nullptr;
+    std::vector<Transmission>& list = sent->second;
+
+    auto byTime = [](const Transmission& t, simtime_t time) { return t.time < time; };
+    Transmission* best = nullptr;
+    simtime_t bestOffset;
+    for (auto t = std::lower_bound(list.begin(), list.end(), time - window, byTime); t != list.end() && t->time <= time + window; t++) {
+        if (t->used || t->destination != destination) continue;
+        simtime_t offset = t->time > time ? t->time - time : time - t->time;
+        if (!best || offset < bestOffset) {
+            best = &*t;
+            bestOffset = offset;
+        }
+    }
+    if (best) best->used = true;
+    return best;
+}
+
+const RadioTrace::Transmission* RadioTrace::getNearestBroadcast(int sender, simtime_t time) const
+{
+    auto sent = transmissions.find(sender);
+    if (sent == transmissions.end()) return nullptr;
+    const std::vector<Transmission>& list = sent->second;
+
+    auto byTime = [](const Transmission& t, simtime_t time) { return t.time < time; };
+    auto next = std::lower_bound(list.begin(), list.end(), time, byTime);
+    const Transmission* after = nullptr;
+    for (auto t = next; t != list.end() && !after; t++) {
+        if (t->destination == -1) after = &*t;
+    }
+    const Transmission* before = nullptr;
+    for (auto t = next; t != list.begin() && !before;) {
+        t--;
+        if (t->destination == -1) before = &*t;
+    }
+    if (!before) return after;
+    if (!after) return before;
+    return time - before->time <= after->time - time ? before : after;
+}
+
+void RadioTrace::registerRadio(TraceRadioDriver* radio, int nodeId)
+{
+    radios[nodeId] = radio;
+}
+
+void RadioTrace::removeRadio(TraceRadioDriver* radio)
+{
+    for (auto r = radios.begin(); r != radios.end();) {
+        if (r->second == radio)
+            r = radios.erase(r);
+        else
+            r++;
+    }
+}
+
+TraceRadioDriver* RadioTrace::getRadio(int nodeId) const
+{
+    auto radio = radios.find(nodeId);
+    return radio == radios.end() ? nullptr : radio->second;
+}
+
+} // namespace plexe
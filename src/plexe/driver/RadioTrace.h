@@ -0,0 +1,134 @@
+//
+// Copyright (C) 2012-2021 Michele Segata <segata@ccs-labs.org>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#pragma once
+
+#include <fstream>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "plexe/plexe.h"
+
+namespace plexe {
+
+class TraceRadioDriver;
+
+/**
+ * Trace of the frames exchanged by the vehicles, shared by all radio
+ * drivers. Veins11pRadioDriver records, for each frame sent by a vehicle,
+ * the vehicles that received it and when, or whether a unicast frame was
+ * dropped after exhausting its retransmissions. TraceRadioDriver replays
+ * the trace without simulating MAC and PHY: a frame sent at a given time is
+ * delivered to the receivers of the recorded frame of the same sender and
+ * destination closest in time, with the same delays.
+ *
+ * The trace is a text file with one event per line:
+ * - T <frame> <time> <sender> <destination> <kind> <bits>: frame sent.
+ * destination is -1 for broadcast frames
+ * - D <frame> <time> <receiver>: frame received
+ * - F <frame> <time>: unicast frame dropped after all retransmissions
+ */
+class RadioTrace {
+
+public:
+    typedef struct {
+        int receiver;
+        simtime_t delay;
+    } Delivery;
+
+    typedef struct {
+        simtime_t time;
+        int destination;
+        short kind;
+        std::vector<Delivery> deliveries;
+        // for unicast frames dropped by the MAC, the time it took to give up
+        bool failed;
+        simtime_t failureDelay;
+        // whether the transmission has already been replayed
+        bool used;
+    } Transmission;
+
+    static RadioTrace& getInstance();
+
+    /**
+     * Starts writing a trace to the given file. Calls with the file that is
+     * already being written have no effect
+     */
+    void startRecording(const std::string& file);
+    void recordTransmission(long frameId, simtime_t time, int sender, int destination, short kind, int64_t bits);
+    void recordDelivery(long frameId, simtime_t time, int receiver);
+    void recordFailure(long frameId, simtime_t time);
+    void flush();
+
+    /**
+     * Loads a trace for replay. Calls with the file that is already loaded
+     * do not parse it again, but the first one of each run marks all its
+     * transmissions as not replayed yet
+     */
+    void load(const std::string& file);
+
+    /**
+     * Replaces the transmissions with the ones of the trace read from the
+     * stream. file is only used in error messages
+     */
+    void parse(std::istream& in, const std::string& file);
+
+    /**
+     * Returns the transmission of the sender to the given destination (-1
+     * for broadcast) closest to the given time, within the given window,
+     * and marks it as used. Returns nullptr if there is none
+     */
+    Transmission* match(int sender, int destination, simtime_t time, simtime_t window);
+
+    /**
+     * Returns the broadcast transmission of the sender closest to the given
+     * time, telling which vehicles it could reach at that time. Returns
+     * nullptr if the sender never broadcast
+     */
+    const Transmission* getNearestBroadcast(int sender, simtime_t time) const;
+
+    /**
+     * Binds a replay driver to a vehicle id, so that frames can be
+     * delivered to it
+     */
+    void registerRadio(TraceRadioDriver* radio, int nodeId);
+    void removeRadio(TraceRadioDriver* radio);
+    TraceRadioDriver* getRadio(int nodeId) const;
+
+private:
+    RadioTrace()
+    {
+    }
+
+    std::string recordFile;
+    std::ofstream out;
+
+    std::string loadedFile;
+    // id of the run the used flags belong to
+    std::string loadedRun;
+    // transmissions of each sender, sorted by time
+    std::unordered_map<int, std::vector<Transmission>> transmissions;
+
+    std::unordered_map<int, TraceRadioDriver*> radios;
+};
+
+} // namespace plexe
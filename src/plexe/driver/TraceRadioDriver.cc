@@ -0,0 +1,161 @@
+//
+// Copyright (C) 2012-2021 Michele Segata <segata@ccs-labs.org>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include "plexe/driver/TraceRadioDriver.h"
+
+#include "veins/modules/messages/BaseFrame1609_4_m.h"
+#include "veins/modules/mac/ieee80211p/Mac1609_4.h"
+#include "veins/base/utils/FindModule.h"
+#include "plexe/driver/BackgroundLoad.h"
+
+using namespace veins;
+
+namespace plexe {
+
+Define_Module(TraceRadioDriver);
+
+void TraceRadioDriver::initialize(int stage)
+{
+    BaseApplLayer::initialize(stage);
+
+    if (stage == 0) {
+        // traces already include the load of the recorded run
+        if (FindModule<BackgroundLoad*>::findGlobalModule())
+            throw cRuntimeError("BackgroundLoad is only supported by PerRadioDriver (usePerRadio = true)");
+        matchWindow = par("matchWindow").doubleValue();
+        directIn = findGate("directIn");
+        RadioTrace::getInstance().load(par("traceFile").stdstringValue());
+    }
+}
+
+TraceRadioDriver::~TraceRadioDriver()
+{
+    RadioTrace::getInstance().removeRadio(this);
+}
+
+void TraceRadioDriver::resetForReuse()
+{
+    RadioTrace::getInstance().removeRadio(this);
+    nodeId = -1;
+    // the scenario manager only cancels them, as for any other timer
+    for (cMessage* failure : pendingFailures) cancelAndDelete(failure);
+    pendingFailures.clear();
+    sentFrames = 0;
+    receivedFrames = 0;
+    lostFrames = 0;
+    unmatchedFrames = 0;
+}
+
+void TraceRadioDriver::finish()
+{
+    recordScalar("traceSentFrames", sentFrames);
+    recordScalar("traceReceivedFrames", receivedFrames);
+    recordScalar("traceLostFrames", lostFrames);
+    recordScalar("traceUnmatchedFrames", unmatchedFrames);
+    BaseApplLayer::finish();
+}
+
+bool TraceRadioDriver::registerNode(int nodeId)
+{
+    this->nodeId = nodeId;
+    RadioTrace::getInstance().registerRadio(this, nodeId);
+    return true;
+}
+
+void TraceRadioDriver::handleMessage(cMessage* msg)
+{
+    if (msg->getArrivalGateId() == directIn) {
+        receivedFrames++;
+        sendUp(msg);
+    }
+    else {
+        BaseApplLayer::handleMessage(msg);
+    }
+}
+
+void TraceRadioDriver::handleSelfMsg(cMessage* msg)
+{
+    // a unicast frame which could not be delivered. notify the application
+    // in the same way the 802.11p MAC does
+    BaseFrame1609_4* frame = check_and_cast<BaseFrame1609_4*>(msg);
+    pendingFailures.erase(frame);
+    emit(Mac1609_4::sigRetriesExceeded, frame);
+    delete frame;
+}
+
+void TraceRadioDriver::handleUpperMsg(cMessage* msg)
+{
+    BaseFrame1609_4* frame = check_and_cast<BaseFrame1609_4*>(msg);
+    // interface selection is meaningless past the driver, as in the 802.11p MAC
+    delete frame->removeControlInfo();
+    sentFrames++;
+
+    RadioTrace& trace = RadioTrace::getInstance();
+    bool broadcast = frame->getRecipientAddress() == LAddress::L2BROADCAST();
+    int destination = broadcast ? -1 : frame->getRecipientAddress();
+    const RadioTrace::Transmission* recorded = trace.match(nodeId, destination, simTime(), matchWindow);
+    bool matched = recorded != nullptr;
+    if (!matched) {
+        // e.g., a maneuver message sent at a different time than in the
+        // recorded run. use who could hear the sender at that time
+        unmatchedFrames++;
+        recorded = trace.getNearestBroadcast(nodeId, simTime());
+    }
+
+    if (broadcast) {
+        if (recorded) {
+            for (const RadioTrace::Delivery& delivery : recorded->deliveries) deliver(frame->dup(), delivery.receiver, delivery.delay);
+        }
+        delete frame;
+        return;
+    }
+
+    if (recorded) {
+        for (const RadioTrace::Delivery& delivery : recorded->deliveries) {
+            if (delivery.receiver == destination) {
+                deliver(frame, destination, delivery.delay);
+                return;
+            }
+        }
+    }
+    lostFrames++;
+    simtime_t failureDelay = matched && recorded->failed ? recorded->failureDelay : SimTime(0);
+    pendingFailures.insert(frame);
+    scheduleAt(simTime() + failureDelay, frame);
+}
+
+void TraceRadioDriver::handleLowerMsg(cMessage* msg)
+{
+    throw cRuntimeError("TraceRadioDriver has no lower layer");
+}
+
+void TraceRadioDriver::deliver(cPacket* frame, int receiver, simtime_t delay)
+{
+    TraceRadioDriver* destination = RadioTrace::getInstance().getRadio(receiver);
+    if (!destination) {
+        // the receiver is not in the simulation anymore
+        lostFrames++;
+        delete frame;
+        return;
+    }
+    sendDirect(frame, delay, 0, destination->gate(destination->directIn));
+}
+
+} // namespace plexe
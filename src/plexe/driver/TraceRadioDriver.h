@@ -0,0 +1,95 @@
+//
+// Copyright (C) 2012-2021 Michele Segata <segata@ccs-labs.org>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#pragma once
+
+#include <set>
+
+#include "veins/base/modules/BaseApplLayer.h"
+#include "plexe/driver/PlexeRadioDriverInterface.h"
+#include "plexe/driver/RadioTrace.h"
+#include "plexe/utilities/RecyclableModule.h"
+
+namespace plexe {
+
+/**
+ * Radio that replays the frame deliveries recorded by Veins11pRadioDriver
+ * (see RadioTrace) instead of simulating MAC and PHY. The content of the
+ * frames is the one generated in the current simulation, so changes to
+ * controllers or maneuvers propagate to the other vehicles, while losses
+ * and delays are the recorded ones. The driver reports itself as an 802.11p
+ * device, so protocols and applications can use it without modifications.
+ */
+class TraceRadioDriver : public PlexeRadioDriverInterface, public veins::BaseApplLayer, public RecyclableModule {
+
+public:
+    TraceRadioDriver()
+        : nodeId(-1)
+        , directIn(-1)
+        , sentFrames(0)
+        , receivedFrames(0)
+        , lostFrames(0)
+        , unmatchedFrames(0)
+    {
+    }
+    virtual ~TraceRadioDriver();
+
+    virtual void initialize(int stage) override;
+    virtual void finish() override;
+    virtual void resetForReuse() override;
+
+    virtual bool registerNode(int nodeId) override;
+    virtual int getDeviceType() override
+    {
+        return PlexeRadioInterfaces::VEINS_11P;
+    }
+
+protected:
+    virtual void handleMessage(cMessage* msg) override;
+    virtual void handleSelfMsg(cMessage* msg) override;
+    virtual void handleUpperMsg(cMessage* msg) override;
+    virtual void handleLowerMsg(cMessage* msg) override;
+
+    /**
+     * Delivers the frame to the radio of the given vehicle after the given
+     * delay. Takes ownership of the frame
+     */
+    void deliver(cPacket* frame, int receiver, simtime_t delay);
+
+    int nodeId;
+    // maximum time between a frame and the recorded one it is replayed as
+    simtime_t matchWindow;
+
+    // gate where frames sent by other drivers arrive
+    int directIn;
+
+    // statistics
+    long sentFrames;
+    long receivedFrames;
+    long lostFrames;
+    // frames with no recorded counterpart, replayed with the connectivity
+    // of the closest recorded broadcast of the sender
+    long unmatchedFrames;
+
+    // undelivered unicast frames waiting to be reported to the application
+    std::set<cMessage*> pendingFailures;
+};
+
+} // namespace plexe
@@ -23,6 +23,8 @@
 #include "veins/modules/messages/BaseFrame1609_4_m.h"
 #include "veins/modules/mac/ieee80211p/Mac1609_4.h"
 #include "veins/base/utils/FindModule.h"
+#include "plexe/driver/RadioTrace.h"
+#include "plexe/driver/BackgroundLoad.h"
 
 #define VEH_ID_TO_MAC(x) (x + 1)
 #define MAC_TO_VEH_ID(x) (x - 1)
@@ -33,22 +35,61 @@ namespace plexe {
 
 Define_Module(plexe::Veins11pRadioDriver);
 
+void Veins11pRadioDriver::initialize(int stage)
+{
+    BaseApplLayer::initialize(stage);
+
+    if (stage == 0) {
+        // the 802.11p NIC has no hook to inject the analytical load
+        if (FindModule<BackgroundLoad*>::findGlobalModule())
+            throw cRuntimeError("BackgroundLoad is only supported by PerRadioDriver (usePerRadio = true)");
+        std::string traceFile = par("traceFile").stdstringValue();
+        recordTrace = !traceFile.empty();
+        if (recordTrace) {
+            RadioTrace::getInstance().startRecording(traceFile);
+            // unicast frames the MAC gave up on
+            findHost()->subscribe(Mac1609_4::sigRetriesExceeded, this);
+        }
+    }
+}
+
+void Veins11pRadioDriver::finish()
+{
+    if (recordTrace) RadioTrace::getInstance().flush();
+    BaseApplLayer::finish();
+}
+
+void Veins11pRadioDriver::receiveSignal(cComponent* source, simsignal_t signalID, cObject* obj, cObject* details)
+{
+    if (signalID == Mac1609_4::sigRetriesExceeded) {
+        cMessage* frame = check_and_cast<cMessage*>(obj);
+        // copies of a frame share its tree id
+        RadioTrace::getInstance().recordFailure(frame->getTreeId(), simTime());
+    }
+}
+
 void Veins11pRadioDriver::handleLowerMsg(cMessage* msg)
 {
     BaseFrame1609_4* frame = check_and_cast<BaseFrame1609_4*>(msg);
     if (frame->getRecipientAddress() != veins::LAddress::L2BROADCAST()) frame->setRecipientAddress(MAC_TO_VEH_ID(frame->getRecipientAddress()));
+    if (recordTrace) RadioTrace::getInstance().recordDelivery(frame->getTreeId(), simTime(), nodeId);
     sendUp(frame);
 }
 
 void Veins11pRadioDriver::handleUpperMsg(cMessage* msg)
 {
     BaseFrame1609_4* frame = check_and_cast<BaseFrame1609_4*>(msg);
+    if (recordTrace) {
+        bool broadcast = frame->getRecipientAddress() == veins::LAddress::L2BROADCAST();
+        RadioTrace::getInstance().recordTransmission(frame->getTreeId(), simTime(), nodeId, broadcast ? -1 : frame->getRecipientAddress(), frame->getKind(), frame->getBitLength());
+    }
     if (frame->getRecipientAddress() != veins::LAddress::L2BROADCAST()) frame->setRecipientAddress(VEH_ID_TO_MAC(frame->getRecipientAddress()));
     sendDown(frame);
 }
 
 bool Veins11pRadioDriver::registerNode(int nodeId)
 {
+    this->nodeId = nodeId;
     if (Mac1609_4* mac = FindModule<Mac1609_4*>::findSubModule(getParentModule())) {
         mac->setMACAddress(VEH_ID_TO_MAC(nodeId));
         return true;
@@ -28,7 +28,16 @@ namespace plexe {
 class Veins11pRadioDriver : public PlexeRadioDriverInterface, public veins::BaseApplLayer {
 
 public:
-    bool registerNode(int nodeId);
+    Veins11pRadioDriver()
+        : nodeId(-1)
+        , recordTrace(false)
+    {
+    }
+
+    virtual void initialize(int stage) override;
+    virtual void finish() override;
+
+    virtual bool registerNode(int nodeId) override;
     virtual int getDeviceType() override
     {
         return PlexeRadioInterfaces::VEINS_11P;
@@ -37,5 +46,12 @@ public:
 protected:
     virtual void handleLowerMsg(cMessage* msg) override;
     virtual void handleUpperMsg(cMessage* msg) override;
+
+    using veins::BaseApplLayer::receiveSignal;
+    virtual void receiveSignal(cComponent* source, simsignal_t signalID, cObject* obj, cObject* details) override;
+
+    int nodeId;
+    // whether frame deliveries are written to the radio trace
+    bool recordTrace;
 };
 } // namespace plexe
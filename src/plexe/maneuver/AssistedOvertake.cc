@@ -26,17 +26,31 @@ namespace plexe {
 AssistedOvertake::AssistedOvertake(GeneralPlatooningApp *app) :
         OvertakeManeuver(app), overtakeState(OvertakeState::IDLE), checkDistance(
                 new cMessage("checkDistance")), checkEmergency(
-                new cMessage("checkEmergency")), toTail(new cMessage("toTail")) {
+                new cMessage("checkEmergency")), toTail(new cMessage("toTail")), admittedOvertakes(
+                0), refusedOvertakes(0), completedOvertakes(0), abortedOvertakes(0), totalWaitTime(0), maxQueueLength(
+                0), lastAdmittedOvertaker(TraCIConstants::INVALID_INT_VALUE), lastCompletedOvertaker(
+                TraCIConstants::INVALID_INT_VALUE) {
+    maxConcurrentOvertakers = app->par("maxConcurrentOvertakers").intValue();
+    overtakeSlotSpacing = app->par("overtakeSlotSpacing").intValue();
+    overtakeQueueLength = app->par("overtakeQueueLength").intValue();
+    ASSERT2(maxConcurrentOvertakers > 0,
+            "maxConcurrentOvertakers must be at least 1");
+    // followers open a gap for a single overtaker at a time. with adjacent
+    // slots two overtakers would claim the same follower
+    ASSERT2(maxConcurrentOvertakers == 1 || overtakeSlotSpacing > 1,
+            "concurrent overtakers require overtakeSlotSpacing of at least 2");
 }
 
-bool AssistedOvertake::initializeOvertakeManeuver(const void *parameters) {
-    delete checkDistance;
+AssistedOvertake::~AssistedOvertake() {
+    app->cancelAndDelete(checkDistance);
     checkDistance = nullptr;
-    delete checkEmergency;
+    app->cancelAndDelete(checkEmergency);
     checkEmergency = nullptr;
-    delete toTail;
+    app->cancelAndDelete(toTail);
     toTail = nullptr;
+}
 
+bool AssistedOvertake::initializeOvertakeManeuver(const void *parameters) {
     OvertakeParameters *pars = (OvertakeParameters*) parameters;
 
     if (overtakeState == OvertakeState::IDLE) {
@@ -47,6 +61,11 @@ bool AssistedOvertake::initializeOvertakeManeuver(const void *parameters) {
             return false;
         }
 
+        // stop the timers of a previous maneuver. they are reused afterwards
+        for (cMessage *timer : { checkDistance, checkEmergency, toTail })
+            if (timer->isScheduled())
+                app->cancelEvent(timer);
+
         app->setInManeuver(true, this);
         app->setPlatoonRole(PlatoonRole::OVERTAKER);
 
@@ -89,38 +108,88 @@ void AssistedOvertake::handleOvertakeRequest(const OvertakeRequest *msg) {
     if (app->getPlatoonRole() != PlatoonRole::LEADER)
         return;
 
-    bool permission = app->isOvertakeAllowed();
-
-    // send response to the overtaker
-    std::cout << positionHelper->getId()
-            << " sending OvertakeResponse to vehicle with id "
-            << msg->getVehicleId() << " (permission to overtake: "
-            << (permission ? "permitted" : "not permitted") << ") "
-            << " -time:(" << simTime() << ") \n";
-
-    OvertakeResponse *response = createOvertakeResponse(positionHelper->getId(),
-            positionHelper->getExternalId(), msg->getPlatoonId(),
-            msg->getVehicleId(), permission);
-    app->sendUnicast(response, msg->getVehicleId());
-
-    if (!permission)
+    // request from a vehicle that is already overtaking or waiting
+    if (overtakers.find(msg->getVehicleId()) != overtakers.end())
         return;
+    for (const OvertakerData &queued : overtakeQueue) {
+        if (queued.overtakerId == msg->getVehicleId())
+            return;
+    }
 
-    app->setInManeuver(true, this);
-    app->setPlatoonRole(PlatoonRole::LEADER);
+    if (!app->isOvertakeAllowed()
+            || (int) overtakeQueue.size() >= overtakeQueueLength) {
+        std::cout << positionHelper->getId()
+                << " sending OvertakeResponse to vehicle with id "
+                << msg->getVehicleId()
+                << " (permission to overtake: not permitted) " << " -time:("
+                << simTime() << ") \n";
+        OvertakeResponse *response = createOvertakeResponse(
+                positionHelper->getId(), positionHelper->getExternalId(),
+                msg->getPlatoonId(), msg->getVehicleId(), false);
+        app->sendUnicast(response, msg->getVehicleId());
+        refusedOvertakes++;
+        return;
+    }
 
-    overtakerData.reset(new OvertakerData());
-    overtakerData->from(msg);
+    // the response is sent once the request is admitted
+    OvertakerData data;
+    data.from(msg);
+    data.requestTime = simTime();
+    overtakeQueue.push_back(data);
+    maxQueueLength = std::max(maxQueueLength, overtakeQueue.size());
 
-    overtakeState = OvertakeState::L_WAIT_POSITION;
-    std::cout << "responso positivo" << " -time:(" << simTime() << ") \n";
+    admitOvertakers();
+}
 
-    emergency = false;
+bool AssistedOvertake::canAdmitOvertaker() const {
+    // no new overtakers while an emergency is being handled
+    if (overtakeState != OvertakeState::IDLE
+            && overtakeState != OvertakeState::L_WAIT_POSITION)
+        return false;
+    if ((int) overtakers.size() >= maxConcurrentOvertakers)
+        return false;
+    // the gap slot of the newcomer must not overlap the ones of the
+    // vehicles that are still close to the tail of the platoon
+    for (const auto &overtaker : overtakers) {
+        if (overtaker.second.relativePosition
+                > BEHIND_PLATOON - overtakeSlotSpacing)
+            return false;
+    }
+    return true;
+}
 
-    relativePosition = 7;
+void AssistedOvertake::admitOvertakers() {
+    while (!overtakeQueue.empty() && canAdmitOvertaker()) {
+        OvertakerData data = overtakeQueue.front();
+        overtakeQueue.pop_front();
 
-    app->scheduleAt(simTime() + 0.5, checkEmergency);
+        simtime_t waitTime = simTime() - data.requestTime;
+        if (cOutVector *out = app->getOvertakeWaitTimeVector())
+            out->record(waitTime);
+        totalWaitTime += waitTime;
+        admittedOvertakes++;
+        lastAdmittedOvertaker = data.overtakerId;
 
+        std::cout << positionHelper->getId()
+                << " sending OvertakeResponse to vehicle with id "
+                << data.overtakerId
+                << " (permission to overtake: permitted, waited " << waitTime
+                << "s) " << " -time:(" << simTime() << ") \n";
+        OvertakeResponse *response = createOvertakeResponse(
+                positionHelper->getId(), positionHelper->getExternalId(),
+                positionHelper->getPlatoonId(), data.overtakerId, true);
+        app->sendUnicast(response, data.overtakerId);
+
+        if (overtakers.empty()) {
+            app->setInManeuver(true, this);
+            app->setPlatoonRole(PlatoonRole::LEADER);
+            overtakeState = OvertakeState::L_WAIT_POSITION;
+            emergency = false;
+            if (!checkEmergency->isScheduled())
+                app->scheduleAt(simTime() + 0.5, checkEmergency);
+        }
+        overtakers[data.overtakerId] = data;
+    }
 }
 
 void AssistedOvertake::onPlatoonBeacon(const PlatooningBeacon *pb) {
@@ -164,7 +233,9 @@ void AssistedOvertake::onPlatoonBeacon(const PlatooningBeacon *pb) {
         }
 
     } else if (overtakeState == OvertakeState::L_WAIT_POSITION
-            && app->getPlatoonRole() == PlatoonRole::LEADER) {
+            && app->getPlatoonRole() == PlatoonRole::LEADER
+            && pb->getVehicleId() >= 0
+            && pb->getVehicleId() < BEHIND_PLATOON) {
         carPositions[pb->getVehicleId()] = pb->getPositionX();
         carPositions[0] = traciPosition.x;
     }
@@ -175,6 +246,11 @@ void AssistedOvertake::onPositionAck(const PositionAck *ack) {
     if (overtakeState == OvertakeState::L_WAIT_POSITION) {
         ASSERT(app->getPlatoonRole() == PlatoonRole::LEADER);
 
+        auto overtaker = overtakers.find(ack->getVehicleId());
+        if (overtaker == overtakers.end())
+            return;
+        int &relativePosition = overtaker->second.relativePosition;
+
         double overtakerPosition = ack->getPosition();
 
         for (int i = 1; i <= 6; i++) {
@@ -187,21 +263,89 @@ void AssistedOvertake::onPositionAck(const PositionAck *ack) {
                 relativePosition = i + 1;
             }
         }
+
+        // the overtaker might have freed the slot for the next one
+        admitOvertakers();
     }
 }
 
 void AssistedOvertake::onOvertakeFinishAck(const OvertakeFinishAck *ack) {
-    if (overtakeState == OvertakeState::L_WAIT_POSITION) {
-        ASSERT(app->getPlatoonRole() == PlatoonRole::LEADER);
+    if (app->getPlatoonRole() != PlatoonRole::LEADER)
+        return;
+    if (overtakers.erase(ack->getVehicleId()) == 0)
+        return;
+    completedOvertakes++;
+    lastCompletedOvertaker = ack->getVehicleId();
+
+    if (overtakers.empty()) {
         overtakeState = OvertakeState::IDLE;
         plexeTraciVehicle->setCruiseControlDesiredSpeed(100.0 / 3.6);
+        app->setInManeuver(false, nullptr);
     }
+    admitOvertakers();
 }
 
 void AssistedOvertake::onFailedTransmissionAttempt(const ManeuverMessage *mm) {
-    throw cRuntimeError(
-            "Impossible to send this packet: %s. Maximum number of unicast retries reached",
-            mm->getName());
+    int destination = mm->getDestinationId();
+
+    if (app->getPlatoonRole() == PlatoonRole::OVERTAKER) {
+        if (!targetPlatoonData
+                || destination != targetPlatoonData->platoonLeader)
+            return;
+        std::cout << positionHelper->getId()
+                << " aborting overtake: " << mm->getName()
+                << " to the leader could not be delivered" << " -time:("
+                << simTime() << ") \n";
+        if (toTail->isScheduled())
+            app->cancelEvent(toTail);
+        targetPlatoonData.reset();
+        overtakeState = OvertakeState::IDLE;
+        abortedOvertakes++;
+        app->setPlatoonRole(PlatoonRole::NONE);
+        app->emitManeuverEvent(ManeuverEvent::ABORTED);
+        app->setInManeuver(false, nullptr);
+    } else if (app->getPlatoonRole() == PlatoonRole::LEADER) {
+        // either the overtaker or the member opening a gap for it
+        auto overtaker = std::find_if(overtakers.begin(), overtakers.end(),
+                [destination](const std::pair<const int, OvertakerData> &o) {
+                    return o.second.overtakerId == destination
+                            || o.second.tempLeaderId == destination;
+                });
+        // e.g., a refusal to a vehicle that is not overtaking
+        if (overtaker == overtakers.end())
+            return;
+        const OvertakerData &data = overtaker->second;
+        std::cout << positionHelper->getId()
+                << " dropping overtaker " << data.overtakerId << ": "
+                << mm->getName() << " to vehicle " << destination
+                << " could not be delivered" << " -time:(" << simTime()
+                << ") \n";
+        // the member that opened a gap does not need it anymore
+        if (data.tempLeaderId != 0 && data.tempLeaderId != destination) {
+            OvertakeRestart *restartF = createOvertakeRestart(
+                    positionHelper->getId(), positionHelper->getExternalId(),
+                    positionHelper->getPlatoonId(), data.tempLeaderId);
+            app->sendUnicast(restartF, data.tempLeaderId);
+        }
+        overtakers.erase(overtaker);
+        abortedOvertakes++;
+
+        if (overtakers.empty()) {
+            overtakeState = OvertakeState::IDLE;
+            plexeTraciVehicle->setCruiseControlDesiredSpeed(100.0 / 3.6);
+            app->emitManeuverEvent(ManeuverEvent::ABORTED);
+            app->setInManeuver(false, nullptr);
+        }
+        admitOvertakers();
+    } else if (app->getPlatoonRole() == PlatoonRole::FOLLOWER) {
+        if (overtakeState != OvertakeState::F_OPEN_GAP || destination != oId)
+            return;
+        // close the gap opened for the overtaker
+        plexeTraciVehicle->setCACCConstantSpacing(5);
+        if (checkDistance->isScheduled())
+            app->cancelEvent(checkDistance);
+        overtakeState = OvertakeState::IDLE;
+    }
 }
 
 void AssistedOvertake::handleOvertakeResponse(const OvertakeResponse *msg) {
@@ -254,61 +398,105 @@ void AssistedOvertake::handlePauseOrder(const PauseOrder *msg) {
 //leader lancia messaggio in caso di emergenza
 void AssistedOvertake::abortManeuver() {
     if (app->getPlatoonRole() == PlatoonRole::LEADER) {
+        app->emitManeuverEvent(ManeuverEvent::INTERRUPTED);
         overtakeState = OvertakeState::L_WAIT_JOIN;
-        if (relativePosition <= 3) {
-            plexeTraciVehicle->setCruiseControlDesiredSpeed(40.0 / 3.6);
+        for (auto &overtaker : overtakers)
+            pauseOvertaker(overtaker.second);
+    }
+}
 
-        } else if (relativePosition > 3 && relativePosition < 7) {
+void AssistedOvertake::pauseOvertaker(OvertakerData &data) {
+    if (data.relativePosition <= 3) {
+        plexeTraciVehicle->setCruiseControlDesiredSpeed(40.0 / 3.6);
 
-            tempLeaderId = relativePosition - pOffset;
+    } else if (data.relativePosition > 3
+            && data.relativePosition < BEHIND_PLATOON) {
 
-            std::cout << positionHelper->getId() << " temp leader aggiustato"
-                    << tempLeaderId << " -time:(" << simTime() << ") \n";
+        data.tempLeaderId = data.relativePosition - pOffset;
 
-            PauseOrder *msgPauseM = createPauseOrder(positionHelper->getId(),
-                    positionHelper->getExternalId(),
-                    positionHelper->getPlatoonId(), overtakerData->overtakerId,
-                    overtakerData->overtakerId, false);
+        std::cout << positionHelper->getId() << " temp leader aggiustato"
+                << data.tempLeaderId << " -time:(" << simTime() << ") \n";
 
-            app->sendUnicast(msgPauseM, overtakerData->overtakerId);
+        PauseOrder *msgPauseM = createPauseOrder(positionHelper->getId(),
+                positionHelper->getExternalId(), positionHelper->getPlatoonId(),
+                data.overtakerId, data.overtakerId, false);
 
-            PauseOrder *msgPauseF = createPauseOrder(positionHelper->getId(),
-                    positionHelper->getExternalId(),
-                    positionHelper->getPlatoonId(), tempLeaderId,
-                    overtakerData->overtakerId, false);
+        app->sendUnicast(msgPauseM, data.overtakerId);
 
-            app->sendUnicast(msgPauseF, tempLeaderId);
+        PauseOrder *msgPauseF = createPauseOrder(positionHelper->getId(),
+                positionHelper->getExternalId(), positionHelper->getPlatoonId(),
+                data.tempLeaderId, data.overtakerId, false);
 
-            std::cout << positionHelper->getId()
-                    << " invio ordine pausa overtake" << " -time:(" << simTime()
-                    << ") \n";
-        } else {
-            PauseOrder *msgPauseTail = createPauseOrder(positionHelper->getId(),
-                    positionHelper->getExternalId(),
-                    positionHelper->getPlatoonId(), overtakerData->overtakerId,
-                    overtakerData->overtakerId, true);
+        app->sendUnicast(msgPauseF, data.tempLeaderId);
 
-            app->sendUnicast(msgPauseTail, overtakerData->overtakerId);
-        }
+        std::cout << positionHelper->getId() << " invio ordine pausa overtake"
+                << " -time:(" << simTime() << ") \n";
+    } else {
+        PauseOrder *msgPauseTail = createPauseOrder(positionHelper->getId(),
+                positionHelper->getExternalId(), positionHelper->getPlatoonId(),
+                data.overtakerId, data.overtakerId, true);
+
+        app->sendUnicast(msgPauseTail, data.overtakerId);
     }
 }
 
 void AssistedOvertake::restartManeuver() {
     if (app->getPlatoonRole() == PlatoonRole::LEADER) {
+        restartOvertakers();
+        overtakeState = OvertakeState::L_WAIT_POSITION;
+        admitOvertakers();
+    }
+}
+
+void AssistedOvertake::restartOvertakers() {
+    for (auto &overtaker : overtakers) {
+        OvertakerData &data = overtaker.second;
 
         OvertakeRestart *restartM = createOvertakeRestart(
                 positionHelper->getId(), positionHelper->getExternalId(),
-                positionHelper->getPlatoonId(), overtakerData->overtakerId);
+                positionHelper->getPlatoonId(), data.overtakerId);
+
+        app->sendUnicast(restartM, data.overtakerId);
 
-        app->sendUnicast(restartM, overtakerData->overtakerId);
+        // only the members that opened a gap have to close it
+        if (data.tempLeaderId == 0)
+            continue;
 
         OvertakeRestart *restartF = createOvertakeRestart(
                 positionHelper->getId(), positionHelper->getExternalId(),
-                positionHelper->getPlatoonId(), tempLeaderId);
+                positionHelper->getPlatoonId(), data.tempLeaderId);
 
-        app->sendUnicast(restartF, tempLeaderId);
+        app->sendUnicast(restartF, data.tempLeaderId);
+        data.tempLeaderId = 0;
+    }
+}
 
-        overtakeState = OvertakeState::L_WAIT_POSITION;
+void AssistedOvertake::cancelOvertakes() {
+    if (app->getPlatoonRole() != PlatoonRole::LEADER)
+        return;
+
+    for (const OvertakerData &data : overtakeQueue) {
+        OvertakeResponse *response = createOvertakeResponse(
+                positionHelper->getId(), positionHelper->getExternalId(),
+                positionHelper->getPlatoonId(), data.overtakerId, false);
+        app->sendUnicast(response, data.overtakerId);
+        refusedOvertakes++;
+    }
+    overtakeQueue.clear();
+
+    // overtakers that were paused by an emergency go on by themselves
+    if (overtakeState == OvertakeState::L_WAIT_JOIN
+            || overtakeState == OvertakeState::L_WAIT_DANGER_END)
+        restartOvertakers();
+    overtakers.clear();
+
+    if (checkEmergency->isScheduled())
+        app->cancelEvent(checkEmergency);
+    emergency = false;
+    if (overtakeState != OvertakeState::IDLE) {
+        overtakeState = OvertakeState::IDLE;
+        plexeTraciVehicle->setCruiseControlDesiredSpeed(100.0 / 3.6);
+        app->setInManeuver(false, nullptr);
     }
 }
 
@@ -321,6 +509,10 @@ void AssistedOvertake::handleOvertakeRestart(const OvertakeRestart *msg) {
     }
     if (app->getPlatoonRole() == PlatoonRole::FOLLOWER) {
         plexeTraciVehicle->setCACCConstantSpacing(5);
+        // the overtaker no longer needs the gap
+        if (checkDistance->isScheduled())
+            app->cancelEvent(checkDistance);
+        overtakeState = OvertakeState::IDLE;
     }
 }
 
@@ -350,8 +542,9 @@ void AssistedOvertake::overtakerToTail() {
         std::cout << positionHelper->getId() << " rallenta " << " -time:("
                 << simTime() << ") \n";
 
-        toTail = new cMessage();
-
+        // a new order postpones the previous one
+        if (toTail->isScheduled())
+            app->cancelEvent(toTail);
         app->scheduleAt(simTime() + 12.0, toTail);
 
     }
@@ -362,9 +555,10 @@ void AssistedOvertake::followerOpenGap() {
     if (app->getPlatoonRole() == PlatoonRole::FOLLOWER) {
 
         plexeTraciVehicle->setCACCConstantSpacing(gap);
-        app->scheduleAt(simTime() + 0.5, checkDistance);
+        if (!checkDistance->isScheduled())
+            app->scheduleAt(simTime() + 0.5, checkDistance);
 
-        overtakeState == OvertakeState::F_OPEN_GAP;
+        overtakeState = OvertakeState::F_OPEN_GAP;
     }
 }
 
@@ -456,5 +650,69 @@ void AssistedOvertake::fakeEmergencyFinish() {
     emergency = false;
 }
 
+size_t AssistedOvertake::getMemoryFootprint() const {
+    size_t bytes = sizeof(AssistedOvertake);
+    for (cMessage *timer : { checkDistance, checkEmergency, toTail })
+        if (timer)
+            bytes += sizeof(cMessage);
+    if (targetPlatoonData)
+        bytes += sizeof(TargetPlatoonData);
+    for (const auto &overtaker : overtakers)
+        bytes += sizeof(overtaker) + 4 * sizeof(void*)
+                + overtaker.second.newFormation.capacity() * sizeof(int);
+    bytes += overtakeQueue.size() * sizeof(OvertakerData);
+    return bytes;
+}
+
+const char* AssistedOvertake::getStateName() const {
+    switch (overtakeState) {
+    case OvertakeState::IDLE:
+        return "IDLE";
+    case OvertakeState::M_WAIT_REPLY:
+        return "M_WAIT_REPLY";
+    case OvertakeState::M_OT:
+        return "M_OT";
+    case OvertakeState::M_WAIT_GAP:
+        return "M_WAIT_GAP";
+    case OvertakeState::M_MOVE_LANE:
+        return "M_MOVE_LANE";
+    case OvertakeState::M_FOLLOW:
+        return "M_FOLLOW";
+    case OvertakeState::M_WAIT_DANGER_END:
+        return "M_WAIT_DANGER_END";
+    case OvertakeState::L_DECISION:
+        return "L_DECISION";
+    case OvertakeState::L_WAIT_JOIN:
+        return "L_WAIT_JOIN";
+    case OvertakeState::L_WAIT_POSITION:
+        return "L_WAIT_POSITION";
+    case OvertakeState::L_WAIT_DANGER_END:
+        return "L_WAIT_DANGER_END";
+    case OvertakeState::F_OPEN_GAP:
+        return "F_OPEN_GAP";
+    case OvertakeState::F_CLOSE_GAP:
+        return "F_CLOSE_GAP";
+    case OvertakeState::V_FOLLOWF:
+        return "V_FOLLOWF";
+    default:
+        return "UNKNOWN";
+    }
+}
+
+void AssistedOvertake::recordStatistics() {
+    if (admittedOvertakes == 0 && refusedOvertakes == 0
+            && abortedOvertakes == 0)
+        return;
+    app->recordScalar("overtakesAdmitted", admittedOvertakes);
+    app->recordScalar("overtakesRefused", refusedOvertakes);
+    app->recordScalar("overtakesCompleted", completedOvertakes);
+    app->recordScalar("overtakesAborted", abortedOvertakes);
+    app->recordScalar("overtakesPending", overtakers.size() + overtakeQueue.size());
+    app->recordScalar("overtakeMeanWaitTime",
+            admittedOvertakes > 0 ?
+                    totalWaitTime.dbl() / admittedOvertakes : 0.0);
+    app->recordScalar("overtakeMaxQueueLength", maxQueueLength);
+}
+
 } // namespace plexe
 
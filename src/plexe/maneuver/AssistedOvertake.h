@@ -23,6 +23,8 @@
 #define ASSISTEDOVERTAKE_H_
 
 #include <algorithm>
+#include <deque>
+#include <map>
 
 #include "plexe/maneuver/OvertakeManeuver.h"
 #include "plexe/utilities/BasePositionHelper.h"
@@ -43,9 +45,7 @@ public:
      * @param app pointer to the generic application used to fetch parameters and inform it about a concluded maneuver
      */
     AssistedOvertake(GeneralPlatooningApp *app);
-    virtual ~AssistedOvertake() {
-    }
-    ;
+    virtual ~AssistedOvertake();
 
     /**
      * This method is invoked by the generic application to start the maneuver
@@ -68,6 +68,11 @@ public:
 
     virtual void handleOpenGapAck(const OpenGapAck *msg) override;
 
+    /**
+     * Aborts the part of the maneuver this vehicle plays with the
+     * destination of the undelivered message, without involving the rest
+     * of the platoon
+     */
     virtual void onFailedTransmissionAttempt(const ManeuverMessage *mm)
             override;
 
@@ -81,6 +86,24 @@ public:
 
     virtual void fakeEmergencyFinish();
 
+    virtual long getAdmittedOvertakes() const override {
+        return admittedOvertakes;
+    }
+
+    virtual long getCompletedOvertakes() const override {
+        return completedOvertakes;
+    }
+
+    virtual int getLastAdmittedOvertaker() const override {
+        return lastAdmittedOvertaker;
+    }
+
+    virtual int getLastCompletedOvertaker() const override {
+        return lastCompletedOvertaker;
+    }
+
+    virtual void cancelOvertakes() override;
+
     virtual void overtakerPause() override;
 
     virtual void changeLane() override;
@@ -91,6 +114,12 @@ public:
 
     virtual void handleJoinAck(const JoinAck *msg) override;
 
+    virtual void recordStatistics() override;
+
+    virtual size_t getMemoryFootprint() const override;
+
+    virtual const char* getStateName() const override;
+
 
 
 
@@ -105,6 +134,8 @@ protected:
     cMessage* checkEmergency;
     cMessage* toTail;
 
+    /** relative position of an overtaker that is still behind the platoon */
+    static const int BEHIND_PLATOON = 7;
 
     /** Possible states a vehicle can be in during a overtake maneuver */
     enum class OvertakeState {
@@ -151,11 +182,16 @@ protected:
         int overtakerId; ///< the id of the vehicle Overtaking the Platoon
         int overtakerLane; ///< the lane chosen for Overtakeing the Platoon
         std::vector<int> newFormation;
+        int relativePosition; ///< the platoon member the overtaker is next to
+        int tempLeaderId; ///< the member opening a gap for the overtaker
+        simtime_t requestTime; ///< when the overtake request was received
 
         /** c'tor for OvertakerData */
         OvertakerData() {
             overtakerId = TraCIConstants::INVALID_INT_VALUE;
             overtakerLane = TraCIConstants::INVALID_INT_VALUE;
+            relativePosition = BEHIND_PLATOON;
+            tempLeaderId = 0;
         }
 
         /**
@@ -176,16 +212,37 @@ protected:
     /** the data about the target platoon */
     std::unique_ptr<TargetPlatoonData> targetPlatoonData;
 
-    /** the data about the current overtaker */
-    std::unique_ptr<OvertakerData> overtakerData;
+    /** the data about the overtakers currently admitted, by vehicle id */
+    std::map<int, OvertakerData> overtakers;
 
-    double carPositions[7] = { 0 };
+    /** overtake requests waiting for a free slot, in arrival order */
+    std::deque<OvertakerData> overtakeQueue;
 
-    double distanceFromLeader = 0;
-
-    int tempLeaderId = 0;
+    /** maximum number of vehicles overtaking the platoon at the same time */
+    int maxConcurrentOvertakers;
+    /**
+     * number of platoon positions an overtaker must have advanced before
+     * the next one is admitted, so that their gap slots never overlap
+     */
+    int overtakeSlotSpacing;
+    /** maximum number of queued requests. further requests are refused */
+    int overtakeQueueLength;
+
+    /** statistics about the admission of overtakers. wait times are recorded
+     * into GeneralPlatooningApp::getOvertakeWaitTimeVector() */
+    long admittedOvertakes;
+    long refusedOvertakes;
+    long completedOvertakes;
+    /** overtakes given up because a message could not be delivered */
+    long abortedOvertakes;
+    simtime_t totalWaitTime;
+    size_t maxQueueLength;
+    int lastAdmittedOvertaker;
+    int lastCompletedOvertaker;
+
+    double carPositions[BEHIND_PLATOON] = { 0 };
 
-    int relativePosition = 7;
+    double distanceFromLeader = 0;
 
     int pOffset = 3;
 
@@ -201,6 +258,15 @@ protected:
 
     bool inPause = false;
 
+    /** whether a new overtaker can be admitted without conflicting gap slots */
+    bool canAdmitOvertaker() const;
+
+    /** grants the overtake to queued requests, as long as slots are available */
+    void admitOvertakers();
+
+    /** orders an overtaker to pause, opening a gap for it if needed */
+    void pauseOvertaker(OvertakerData &data);
+
     void followerOpenGap();
 
     void overtakerToTail();
@@ -208,6 +274,9 @@ protected:
 
     void restartManeuver();
 
+    /** orders paused overtakers to go on and their members to close the gap */
+    void restartOvertakers();
+
 };
 
 } // namespace plexe
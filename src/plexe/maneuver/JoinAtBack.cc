@@ -127,9 +127,43 @@ void JoinAtBack::onPlatoonBeacon(const PlatooningBeacon *pb) {
 }
 
 void JoinAtBack::onFailedTransmissionAttempt(const ManeuverMessage *mm) {
-    throw cRuntimeError(
-            "Impossible to send this packet: %s. Maximum number of unicast retries reached",
-            mm->getName());
+    switch (joinManeuverState) {
+    case JoinManeuverState::J_WAIT_REPLY:
+    case JoinManeuverState::J_WAIT_INFORMATION:
+    case JoinManeuverState::J_MOVE_IN_POSITION:
+    case JoinManeuverState::J_WAIT_JOIN:
+        if (mm->getDestinationId() != targetPlatoonData->platoonLeader)
+            return;
+        if (joinManeuverState == JoinManeuverState::J_MOVE_IN_POSITION
+                || joinManeuverState == JoinManeuverState::J_WAIT_JOIN) {
+            // stop approaching the platoon and drive on alone at its speed
+            plexeTraciVehicle->setCruiseControlDesiredSpeed(
+                    targetPlatoonData->platoonSpeed);
+            plexeTraciVehicle->setActiveController(ACC);
+        }
+        targetPlatoonData.reset();
+        app->setPlatoonRole(PlatoonRole::NONE);
+        break;
+    case JoinManeuverState::L_WAIT_JOINER_IN_POSITION:
+    case JoinManeuverState::L_WAIT_JOINER_TO_JOIN:
+        if (mm->getDestinationId() != joinerData->joinerId)
+            return;
+        joinerData.reset();
+        // a vehicle driving alone became leader only to grant the join
+        if (positionHelper->getPlatoonSize() == 1)
+            app->setPlatoonRole(PlatoonRole::NONE);
+        break;
+    default:
+        // the maneuver is already over, e.g., the final JoinFormationAck
+        return;
+    }
+
+    LOG << positionHelper->getId() << " aborting join maneuver: "
+               << mm->getName() << " to vehicle "
+               << mm->getDestinationId() << " could not be delivered\n";
+    joinManeuverState = JoinManeuverState::IDLE;
+    app->emitManeuverEvent(ManeuverEvent::ABORTED);
+    app->setInManeuver(false, nullptr);
 }
 
 bool JoinAtBack::processJoinRequest(const JoinPlatoonRequest *msg) {
@@ -366,19 +400,42 @@ void JoinAtBack::handleJoinFormationAck(const JoinFormationAck *msg) {
     LOG << positionHelper->getId()
                << " received JoinFormationAck. Sending UpdatePlatoonFormation to all members\n";
     // send to all vehicles in Platoon
-    for (unsigned int i = 1; i < positionHelper->getPlatoonSize(); i++) {
-        UpdatePlatoonFormation *dup = app->createUpdatePlatoonFormation(
-                positionHelper->getId(), positionHelper->getExternalId(),
-                positionHelper->getPlatoonId(), -1,
-                positionHelper->getPlatoonSpeed(), traciVehicle->getLaneIndex(),
-                joinerData->newFormation);
-        int dest = positionHelper->getMemberId(i);
-        dup->setDestinationId(dest);
-        app->sendUnicast(dup, dest);
-    }
+    app->sendPlatoonFormationUpdate();
 
     joinManeuverState = JoinManeuverState::IDLE;
     app->setInManeuver(false, nullptr);
 }
 
+size_t JoinAtBack::getMemoryFootprint() const {
+    size_t bytes = sizeof(JoinAtBack);
+    if (targetPlatoonData)
+        bytes += sizeof(TargetPlatoonData)
+                + targetPlatoonData->newFormation.capacity() * sizeof(int);
+    if (joinerData)
+        bytes += sizeof(JoinerData)
+                + joinerData->newFormation.capacity() * sizeof(int);
+    return bytes;
+}
+
+const char* JoinAtBack::getStateName() const {
+    switch (joinManeuverState) {
+    case JoinManeuverState::IDLE:
+        return "IDLE";
+    case JoinManeuverState::J_WAIT_REPLY:
+        return "J_WAIT_REPLY";
+    case JoinManeuverState::J_WAIT_INFORMATION:
+        return "J_WAIT_INFORMATION";
+    case JoinManeuverState::J_MOVE_IN_POSITION:
+        return "J_MOVE_IN_POSITION";
+    case JoinManeuverState::J_WAIT_JOIN:
+        return "J_WAIT_JOIN";
+    case JoinManeuverState::L_WAIT_JOINER_IN_POSITION:
+        return "L_WAIT_JOINER_IN_POSITION";
+    case JoinManeuverState::L_WAIT_JOINER_TO_JOIN:
+        return "L_WAIT_JOINER_TO_JOIN";
+    default:
+        return "UNKNOWN";
+    }
+}
+
 } // namespace plexe
@@ -67,9 +67,14 @@ public:
     /**
      * This method is invoked by the generic application when a failed transmission occurred, indicating the packet for which transmission has failed
      * The manuever must not free the memory of the message, as this might be needed by other maneuvers as well.
+     * If the message was meant for the other party of the maneuver in progress, the maneuver is aborted.
      */
     virtual void onFailedTransmissionAttempt(const ManeuverMessage* mm) override;
 
+    virtual size_t getMemoryFootprint() const override;
+
+    virtual const char* getStateName() const override;
+
     /**
      * Handles a JoinPlatoonRequest in the context of this application
      *
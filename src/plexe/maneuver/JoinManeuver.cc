@@ -31,26 +31,51 @@ JoinManeuver::JoinManeuver(GeneralPlatooningApp* app)
 
 void JoinManeuver::onManeuverMessage(const ManeuverMessage* mm)
 {
-    if (const MergePlatoonRequest* msg = dynamic_cast<const MergePlatoonRequest*>(mm)) {
-        handleMergePlatoonRequest(msg);
+    switch (mm->getMessageType()) {
+    case MMT_MERGE_PLATOON_REQUEST:
+        handleMergePlatoonRequest(static_cast<const MergePlatoonRequest*>(mm));
+        break;
+    case MMT_JOIN_PLATOON_REQUEST:
+        handleJoinPlatoonRequest(static_cast<const JoinPlatoonRequest*>(mm));
+        break;
+    case MMT_JOIN_PLATOON_RESPONSE:
+        handleJoinPlatoonResponse(static_cast<const JoinPlatoonResponse*>(mm));
+        break;
+    case MMT_MOVE_TO_POSITION:
+        handleMoveToPosition(static_cast<const MoveToPosition*>(mm));
+        break;
+    case MMT_MOVE_TO_POSITION_ACK:
+        handleMoveToPositionAck(static_cast<const MoveToPositionAck*>(mm));
+        break;
+    case MMT_JOIN_FORMATION:
+        handleJoinFormation(static_cast<const JoinFormation*>(mm));
+        break;
+    case MMT_JOIN_FORMATION_ACK:
+        handleJoinFormationAck(static_cast<const JoinFormationAck*>(mm));
+        break;
+    default:
+        break;
     }
-    else if (const JoinPlatoonRequest* msg = dynamic_cast<const JoinPlatoonRequest*>(mm)) {
-        handleJoinPlatoonRequest(msg);
-    }
-    else if (const JoinPlatoonResponse* msg = dynamic_cast<const JoinPlatoonResponse*>(mm)) {
-        handleJoinPlatoonResponse(msg);
-    }
-    else if (const MoveToPosition* msg = dynamic_cast<const MoveToPosition*>(mm)) {
-        handleMoveToPosition(msg);
-    }
-    else if (const MoveToPositionAck* msg = dynamic_cast<const MoveToPositionAck*>(mm)) {
-        handleMoveToPositionAck(msg);
-    }
-    else if (const JoinFormation* msg = dynamic_cast<const JoinFormation*>(mm)) {
-        handleJoinFormation(msg);
-    }
-    else if (const JoinFormationAck* msg = dynamic_cast<const JoinFormationAck*>(mm)) {
-        handleJoinFormationAck(msg);
+}
+
+bool JoinManeuver::handlesMessageType(int type) const
+{
+    return isJoinMessageType(type);
+}
+
+bool JoinManeuver::isJoinMessageType(int type)
+{
+    switch (type) {
+    case MMT_MERGE_PLATOON_REQUEST:
+    case MMT_JOIN_PLATOON_REQUEST:
+    case MMT_JOIN_PLATOON_RESPONSE:
+    case MMT_MOVE_TO_POSITION:
+    case MMT_MOVE_TO_POSITION_ACK:
+    case MMT_JOIN_FORMATION:
+    case MMT_JOIN_FORMATION_ACK:
+        return true;
+    default:
+        return false;
     }
 }
 
@@ -52,6 +52,13 @@ public:
     virtual ~JoinManeuver(){};
 
     virtual void onManeuverMessage(const ManeuverMessage* mm) override;
+    virtual bool handlesMessageType(int type) const override;
+
+    /**
+     * Returns whether join maneuvers handle messages with the given type
+     * tag. Used to create maneuvers lazily, before an instance exists
+     */
+    static bool isJoinMessageType(int type);
 
 protected:
     /**
@@ -62,6 +62,18 @@ public:
      */
     virtual void onManeuverMessage(const ManeuverMessage* mm) = 0;
 
+    /**
+     * Returns whether the maneuver handles messages with the given type tag.
+     * Used by the generic application to forward messages only to the
+     * maneuvers interested in them. By default, a maneuver receives all messages
+     *
+     * @param type the ManeuverMessageType of the message
+     */
+    virtual bool handlesMessageType(int type) const
+    {
+        return true;
+    }
+
     /**
      * This method is invoked by the generic application when a beacon message is received
      * The maneuver must not free the memory of the message, as this might be needed by other maneuvers as well.
@@ -84,6 +96,30 @@ public:
         return false;
     }
 
+    /**
+     * Invoked by the GeneralPlatooningApp at the end of the simulation to let the maneuver record its statistics
+     */
+    virtual void recordStatistics()
+    {
+    }
+
+    /**
+     * Returns the estimated memory used by the maneuver, including its timers
+     * and state (see MemoryFootprint)
+     */
+    virtual size_t getMemoryFootprint() const
+    {
+        return sizeof(Maneuver);
+    }
+
+    /**
+     * Returns the name of the state the maneuver is in (see MessageTracker)
+     */
+    virtual const char* getStateName() const
+    {
+        return "UNKNOWN";
+    }
+
 protected:
     GeneralPlatooningApp* app;
     BasePositionHelper* positionHelper;
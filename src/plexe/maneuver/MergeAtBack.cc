@@ -32,7 +32,7 @@ MergeAtBack::MergeAtBack(GeneralPlatooningApp* app)
 
 MergeAtBack::~MergeAtBack()
 {
-    delete checkDistance;
+    app->cancelAndDelete(checkDistance);
     checkDistance = nullptr;
 }
 
@@ -119,15 +119,18 @@ void MergeAtBack::handleJoinFormationAck(const JoinFormationAck* msg)
     positionHelper->setPlatoonFormation(joinerData->newFormation);
 
     // send to all vehicles in Platoon
-    for (unsigned int i = 1; i < positionHelper->getPlatoonSize(); i++) {
-        UpdatePlatoonFormation* dup = app->createUpdatePlatoonFormation(positionHelper->getId(), positionHelper->getExternalId(), positionHelper->getPlatoonId(), -1, positionHelper->getPlatoonSpeed(), traciVehicle->getLaneIndex(), joinerData->newFormation);
-        int dest = positionHelper->getMemberId(i);
-        dup->setDestinationId(dest);
-        app->sendUnicast(dup, dest);
-    }
+    app->sendPlatoonFormationUpdate();
 
     joinManeuverState = JoinManeuverState::IDLE;
     app->setInManeuver(false, nullptr);
 }
 
+size_t MergeAtBack::getMemoryFootprint() const
+{
+    size_t bytes = JoinAtBack::getMemoryFootprint() - sizeof(JoinAtBack) + sizeof(MergeAtBack);
+    bytes += oldFormation.capacity() * sizeof(int);
+    if (checkDistance) bytes += sizeof(cMessage);
+    return bytes;
+}
+
 } // namespace plexe
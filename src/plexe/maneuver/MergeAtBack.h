@@ -77,6 +77,8 @@ public:
 
     virtual bool handleSelfMsg(cMessage* msg) override;
 
+    virtual size_t getMemoryFootprint() const override;
+
 protected:
     // store the old formation this vehicle is leader for to communicate it to the leader of the platoon we are merging with
     std::vector<int> oldFormation;
@@ -28,23 +28,54 @@ OvertakeManeuver::OvertakeManeuver(GeneralPlatooningApp *app) :
 }
 
 void OvertakeManeuver::onManeuverMessage(const ManeuverMessage *mm) {
-    if (const OvertakeRequest *msg = dynamic_cast<const OvertakeRequest*>(mm)) {
-        handleOvertakeRequest(msg);
-    } else if (const OvertakeResponse *msg =
-            dynamic_cast<const OvertakeResponse*>(mm)) {
-        handleOvertakeResponse(msg);
-    } else if (const PositionAck *msg = dynamic_cast<const PositionAck*>(mm)) {
-        onPositionAck(msg);
-    } else if (const PauseOrder *msg = dynamic_cast<const PauseOrder*>(mm)) {
-        handlePauseOrder (msg);
-    } else if (const OpenGapAck *msg = dynamic_cast<const OpenGapAck*>(mm)) {
-        handleOpenGapAck (msg);
-    } else if (const OvertakeRestart *msg = dynamic_cast<const OvertakeRestart*>(mm)) {
-        handleOvertakeRestart (msg);
-    }   else if (const JoinAck *msg = dynamic_cast<const JoinAck*>(mm)) {
-        handleJoinAck (msg);
+    switch (mm->getMessageType()) {
+    case MMT_OVERTAKE_REQUEST:
+        handleOvertakeRequest(static_cast<const OvertakeRequest*>(mm));
+        break;
+    case MMT_OVERTAKE_RESPONSE:
+        handleOvertakeResponse(static_cast<const OvertakeResponse*>(mm));
+        break;
+    case MMT_POSITION_ACK:
+        onPositionAck(static_cast<const PositionAck*>(mm));
+        break;
+    case MMT_PAUSE_ORDER:
+        handlePauseOrder(static_cast<const PauseOrder*>(mm));
+        break;
+    case MMT_OPEN_GAP_ACK:
+        handleOpenGapAck(static_cast<const OpenGapAck*>(mm));
+        break;
+    case MMT_OVERTAKE_RESTART:
+        handleOvertakeRestart(static_cast<const OvertakeRestart*>(mm));
+        break;
+    case MMT_JOIN_ACK:
+        handleJoinAck(static_cast<const JoinAck*>(mm));
+        break;
+    case MMT_OVERTAKE_FINISH_ACK:
+        onOvertakeFinishAck(static_cast<const OvertakeFinishAck*>(mm));
+        break;
+    default:
+        break;
     }
+}
+
+bool OvertakeManeuver::handlesMessageType(int type) const {
+    return isOvertakeMessageType(type);
+}
 
+bool OvertakeManeuver::isOvertakeMessageType(int type) {
+    switch (type) {
+    case MMT_OVERTAKE_REQUEST:
+    case MMT_OVERTAKE_RESPONSE:
+    case MMT_POSITION_ACK:
+    case MMT_PAUSE_ORDER:
+    case MMT_OPEN_GAP_ACK:
+    case MMT_OVERTAKE_RESTART:
+    case MMT_JOIN_ACK:
+    case MMT_OVERTAKE_FINISH_ACK:
+        return true;
+    default:
+        return false;
+    }
 }
 
 OvertakeResponse* OvertakeManeuver::createOvertakeResponse(int vehicleId,
@@ -54,6 +54,13 @@ public:
     ;
 
     virtual void onManeuverMessage(const ManeuverMessage *mm) override;
+    virtual bool handlesMessageType(int type) const override;
+
+    /**
+     * Returns whether overtake maneuvers handle messages with the given type
+     * tag. Used to create maneuvers lazily, before an instance exists
+     */
+    static bool isOvertakeMessageType(int type);
 
     virtual void changeLane() = 0;
 
@@ -61,6 +68,25 @@ public:
 
     virtual void fakeEmergencyFinish() = 0;
 
+    /** number of overtakes admitted and completed so far by a leader */
+    virtual long getAdmittedOvertakes() const = 0;
+    virtual long getCompletedOvertakes() const = 0;
+
+    /**
+     * ids of the last overtaker admitted and of the last one that completed
+     * the overtake, or TraCIConstants::INVALID_INT_VALUE if none
+     */
+    virtual int getLastAdmittedOvertaker() const = 0;
+    virtual int getLastCompletedOvertaker() const = 0;
+
+    /**
+     * Invoked on a leader to give up the overtakes in progress, e.g., when
+     * they take too long. Queued requests are refused, paused overtakers
+     * are restarted and the members close their gaps. Overtakes finishing
+     * afterwards are not counted as completed
+     */
+    virtual void cancelOvertakes() = 0;
+
 protected:
     OvertakeRequest* createOvertakeRequest(int vehicleId,
             std::string externalId, int platoonId, int destinationID);
@@ -96,7 +96,10 @@ void CommandInterface::Vehicle::setLeaderVehicleData(double controllerAccelerati
 {
     ParBuffer buf;
     buf << speed << acceleration << positionX << positionY << time << controllerAcceleration;
-    veinsVehicle().setParameter(PAR_LEADER_SPEED_AND_ACCELERATION, buf.str());
+    if (cifc->deferCommands)
+        cifc->deferParameter(nodeId, PAR_LEADER_SPEED_AND_ACCELERATION, buf.str());
+    else
+        veinsVehicle().setParameter(PAR_LEADER_SPEED_AND_ACCELERATION, buf.str());
 }
 
 void CommandInterface::Vehicle::setPlatoonLeaderData(double speed, double acceleration, double positionX, double positionY, double time)
@@ -109,7 +112,10 @@ void CommandInterface::Vehicle::setFrontVehicleData(double controllerAcceleratio
 {
     ParBuffer buf;
     buf << speed << acceleration << positionX << positionY << time << controllerAcceleration;
-    veinsVehicle().setParameter(PAR_PRECEDING_SPEED_AND_ACCELERATION, buf.str());
+    if (cifc->deferCommands)
+        cifc->deferParameter(nodeId, PAR_PRECEDING_SPEED_AND_ACCELERATION, buf.str());
+    else
+        veinsVehicle().setParameter(PAR_PRECEDING_SPEED_AND_ACCELERATION, buf.str());
 }
 
 void CommandInterface::Vehicle::getVehicleData(double& speed, double& acceleration, double& controllerAcceleration, double& positionX, double& positionY, double& time)
@@ -130,11 +136,19 @@ void CommandInterface::Vehicle::getVehicleData(VEHICLE_DATA* data)
 
 void CommandInterface::Vehicle::setCruiseControlDesiredSpeed(double desiredSpeed)
 {
-    veinsVehicle().setParameter(PAR_CC_DESIRED_SPEED, desiredSpeed);
+    if (cifc->deferCommands) {
+        ParBuffer buf;
+        buf << desiredSpeed;
+        cifc->deferParameter(nodeId, PAR_CC_DESIRED_SPEED, buf.str());
+    }
+    else {
+        veinsVehicle().setParameter(PAR_CC_DESIRED_SPEED, desiredSpeed);
+    }
 }
 
 const double CommandInterface::Vehicle::getCruiseControlDesiredSpeed()
 {
+    cifc->sendDeferredParameters();
     double desiredSpeed;
     veinsVehicle().getParameter(PAR_CC_DESIRED_SPEED, desiredSpeed);
     return desiredSpeed;
@@ -195,7 +209,43 @@ void CommandInterface::Vehicle::setFixedAcceleration(int activate, double accele
 {
     ParBuffer buf;
     buf << activate << acceleration;
-    veinsVehicle().setParameter(PAR_FIXED_ACCELERATION, buf.str());
+    if (cifc->deferCommands)
+        cifc->deferParameter(nodeId, PAR_FIXED_ACCELERATION, buf.str());
+    else
+        veinsVehicle().setParameter(PAR_FIXED_ACCELERATION, buf.str());
+}
+
+void CommandInterface::Vehicle::queueCruiseControlDesiredSpeed(double desiredSpeed)
+{
+    ParBuffer buf;
+    buf << desiredSpeed;
+    cifc->queueParameter(nodeId, PAR_CC_DESIRED_SPEED, buf.str());
+}
+
+void CommandInterface::Vehicle::queueFixedAcceleration(int activate, double acceleration)
+{
+    ParBuffer buf;
+    buf << activate << acceleration;
+    cifc->queueParameter(nodeId, PAR_FIXED_ACCELERATION, buf.str());
+}
+
+void CommandInterface::Vehicle::queueParameter(const std::string& parameter, double value)
+{
+    ParBuffer buf;
+    buf << value;
+    cifc->queueParameter(nodeId, parameter, buf.str());
+}
+
+void CommandInterface::Vehicle::queueParameter(const std::string& parameter, int value)
+{
+    ParBuffer buf;
+    buf << value;
+    cifc->queueParameter(nodeId, parameter, buf.str());
+}
+
+void CommandInterface::Vehicle::queueParameter(const std::string& parameter, const std::string& value)
+{
+    cifc->queueParameter(nodeId, parameter, value);
 }
 
 bool CommandInterface::Vehicle::isCrashed()
@@ -284,11 +334,26 @@ void CommandInterface::Vehicle::setVehicleData(const struct VEHICLE_DATA* data)
 {
     ParBuffer buf;
     buf << data->index << data->speed << data->acceleration << data->positionX << data->positionY << data->time << data->length << data->u << data->speedX << data->speedY << data->angle;
-    veinsVehicle().setParameter(CC_PAR_VEHICLE_DATA, buf.str());
+    if (cifc->deferCommands)
+        cifc->deferParameter(nodeId, CC_PAR_VEHICLE_DATA, buf.str(), data->index);
+    else
+        veinsVehicle().setParameter(CC_PAR_VEHICLE_DATA, buf.str());
+}
+
+void CommandInterface::Vehicle::queueVehicleData(const struct VEHICLE_DATA* data)
+{
+    ParBuffer buf;
+    buf << data->index << data->speed << data->acceleration << data->positionX << data->positionY << data->time << data->length << data->u << data->speedX << data->speedY << data->angle;
+    // a deferred value for the same member would otherwise be sent after this one
+    if (cifc->deferCommands)
+        cifc->deferParameter(nodeId, CC_PAR_VEHICLE_DATA, buf.str(), data->index);
+    else
+        cifc->queueParameter(nodeId, CC_PAR_VEHICLE_DATA, buf.str());
 }
 
 void CommandInterface::Vehicle::getStoredVehicleData(struct VEHICLE_DATA* data, int index)
 {
+    cifc->sendDeferredParameters();
     ParBuffer inBuf;
     std::string v;
     inBuf << CC_PAR_VEHICLE_DATA << index;
@@ -352,6 +417,16 @@ unsigned int CommandInterface::Vehicle::getLanesCount()
     return (unsigned int) v;
 }
 
+void CommandInterface::Vehicle::remove()
+{
+    uint8_t variableId = REMOVE;
+    uint8_t type = TYPE_BYTE;
+    uint8_t reason = REMOVE_VAPORIZED;
+    TraCIBuffer buf = cifc->connection->query(CMD_SET_VEHICLE_VARIABLE, TraCIBuffer() << variableId << nodeId << type << reason);
+    ASSERT(buf.eof());
+    cifc->laneChanges.erase(nodeId);
+}
+
 void CommandInterface::Vehicle::setLaneChangeAction(int action)
 {
     std::cout << "setLaneChangeAction API is deprecated. Please remove it from your code\n";
@@ -366,6 +441,17 @@ void CommandInterface::Vehicle::setLaneChangeAction(int action)
     ASSERT(buf.eof());
 }
 
+void CommandInterface::addRoute(const std::string& routeId, const std::vector<std::string>& edges)
+{
+    uint8_t variableId = ADD;
+    uint8_t type = TYPE_STRINGLIST;
+    TraCIBuffer buffer;
+    buffer << variableId << routeId << type << static_cast<int32_t>(edges.size());
+    for (const std::string& edge : edges) buffer << edge;
+    TraCIBuffer buf = connection->query(CMD_SET_ROUTE_VARIABLE, buffer);
+    ASSERT(buf.eof());
+}
+
 void CommandInterface::executePlexeTimestep()
 {
     std::vector<PlexeLaneChanges::iterator> satisfied;
@@ -398,6 +484,72 @@ void CommandInterface::executePlexeTimestep()
     for (int i = 0; i < satisfied.size(); i++) laneChanges.erase(satisfied[i]);
 }
 
+void CommandInterface::queueParameter(const std::string& nodeId, const std::string& parameter, const std::string& value)
+{
+    uint8_t variableId = VAR_PARAMETER;
+    uint8_t type = TYPE_COMPOUND;
+    int count = 2;
+    queuedCommands += veins::makeTraCICommand(CMD_SET_VEHICLE_VARIABLE, TraCIBuffer() << variableId << nodeId << type << count << static_cast<uint8_t>(TYPE_STRING) << parameter << static_cast<uint8_t>(TYPE_STRING) << value);
+    nQueuedCommands++;
+}
+
+void CommandInterface::sendQueuedParameters()
+{
+    if (nQueuedCommands == 0) return;
+
+    connection->sendMessage(queuedCommands);
+    // SUMO answers with one status response per command, in order
+    TraCIBuffer response(connection->receiveMessage());
+    for (int i = 0; i < nQueuedCommands; i++) {
+        uint8_t cmdLength;
+        response >> cmdLength;
+        uint8_t commandResp;
+        response >> commandResp;
+        ASSERT(commandResp == CMD_SET_VEHICLE_VARIABLE);
+        uint8_t result;
+        response >> result;
+        std::string description;
+        response >> description;
+        if (result != RTYPE_OK) throw cRuntimeError("Queued TraCI command %d of %d failed: %s", i + 1, nQueuedCommands, description.c_str());
+    }
+    ASSERT(response.eof());
+
+    queuedCommands.clear();
+    nQueuedCommands = 0;
+}
+
+void CommandInterface::setDeferCommands(bool defer)
+{
+    if (!defer) sendDeferredParameters();
+    deferCommands = defer;
+}
+
+void CommandInterface::deferParameter(const std::string& nodeId, const std::string& parameter, const std::string& value, int index)
+{
+    nDeferredCommands++;
+    std::string key = nodeId + " " + parameter;
+    if (index >= 0) key += " " + std::to_string(index);
+    auto deferred = deferredIndex.find(key);
+    if (deferred != deferredIndex.end()) {
+        // the older value would be overwritten before the next step anyway
+        deferredParameters[deferred->second].value = value;
+        nCoalescedCommands++;
+        return;
+    }
+    deferredIndex[key] = deferredParameters.size();
+    deferredParameters.push_back({nodeId, parameter, value});
+}
+
+void CommandInterface::sendDeferredParameters()
+{
+    if (deferredParameters.empty()) return;
+
+    for (const DeferredParameter& deferred : deferredParameters) queueParameter(deferred.nodeId, deferred.parameter, deferred.value);
+    deferredParameters.clear();
+    deferredIndex.clear();
+    sendQueuedParameters();
+}
+
 void CommandInterface::__changeLane(std::string veh, int current, int direction, bool safe)
 {
     if (safe) {
@@ -27,6 +27,7 @@
 #include <veins/modules/mobility/traci/TraCICommandInterface.h>
 
 #include <map>
+#include <vector>
 
 namespace veins {
 class TraCIConnection;
@@ -148,6 +149,29 @@ public:
          */
         void setFixedAcceleration(int activate, double acceleration);
 
+        /**
+         * Same as setCruiseControlDesiredSpeed() and setFixedAcceleration(),
+         * but the command is queued and sent together with all the other
+         * queued commands with CommandInterface::sendQueuedParameters()
+         */
+        void queueCruiseControlDesiredSpeed(double desiredSpeed);
+        void queueFixedAcceleration(int activate, double acceleration);
+
+        /**
+         * Queues the setting of a generic parameter. Like the other queue
+         * methods, the command is sent with sendQueuedParameters()
+         */
+        void queueParameter(const std::string& parameter, double value);
+        void queueParameter(const std::string& parameter, int value);
+        void queueParameter(const std::string& parameter, const std::string& value);
+
+        /**
+         * Same as setVehicleData(), but the command is queued. While
+         * commands are deferred, it is deferred like setVehicleData()
+         * instead, and sent by sendDeferredParameters()
+         */
+        void queueVehicleData(const struct plexe::VEHICLE_DATA* data);
+
         /**
          * Returns whether a vehicle has crashed or not
          *
@@ -276,6 +300,11 @@ public:
          */
         unsigned int getLanesCount();
 
+        /**
+         * Removes the vehicle from the simulation
+         */
+        void remove();
+
         veins::TraCICommandInterface::Vehicle veinsVehicle()
         {
             return {cifc->veinsCommandInterface, nodeId};
@@ -305,6 +334,64 @@ public:
 
     void executePlexeTimestep();
 
+    /**
+     * Adds a route made of the given edges, which can then be assigned to
+     * vehicles being inserted
+     */
+    void addRoute(const std::string& routeId, const std::vector<std::string>& edges);
+
+    /**
+     * Returns true if some lane changes are still being performed by
+     * executePlexeTimestep()
+     */
+    bool hasPendingLaneChanges() const
+    {
+        return !laneChanges.empty();
+    }
+
+    /**
+     * Queues a parameter to be set on a vehicle. Queued parameters are sent
+     * to SUMO in a single TraCI message by sendQueuedParameters(), saving
+     * one round trip per command
+     */
+    void queueParameter(const std::string& nodeId, const std::string& parameter, const std::string& value);
+
+    /**
+     * Sends all queued parameters in a single TraCI message
+     */
+    void sendQueuedParameters();
+
+    /**
+     * Enables or disables the deferral of the data fed to the controllers
+     * every step (leader, front and platoon vehicle data, desired speed and
+     * fixed acceleration). A deferred command replaces any earlier deferred
+     * command for the same vehicle and parameter, and all of them are sent
+     * in a single message by sendDeferredParameters(). SUMO reads these
+     * parameters only when computing the next step, so sending them right
+     * before the step does not change the simulation
+     */
+    void setDeferCommands(bool defer);
+    bool isDeferringCommands() const
+    {
+        return deferCommands;
+    }
+
+    /**
+     * Sends all deferred commands. Getters reading a deferrable parameter
+     * call this first, so that they never see a stale value
+     */
+    void sendDeferredParameters();
+
+    // number of deferred commands and of those replaced by a later one
+    long getDeferredCommands() const
+    {
+        return nDeferredCommands;
+    }
+    long getCoalescedCommands() const
+    {
+        return nCoalescedCommands;
+    }
+
     Vehicle vehicle(const std::string& nodeId)
     {
         return {this, nodeId};
@@ -322,9 +409,32 @@ private:
 
     void __changeLane(std::string veh, int current, int direction, bool safe = true);
 
+    /**
+     * Defers the setting of a parameter. index distinguishes values of the
+     * same parameter that do not replace each other (e.g., the data of
+     * different platoon members)
+     */
+    void deferParameter(const std::string& nodeId, const std::string& parameter, const std::string& value, int index = -1);
+
     veins::TraCICommandInterface* veinsCommandInterface;
     veins::TraCIConnection* connection;
     PlexeLaneChanges laneChanges;
+    // commands waiting to be sent by sendQueuedParameters()
+    std::string queuedCommands;
+    int nQueuedCommands = 0;
+
+    struct DeferredParameter {
+        std::string nodeId;
+        std::string parameter;
+        std::string value;
+    };
+    bool deferCommands = false;
+    // deferred commands, in the order they were first issued
+    std::vector<DeferredParameter> deferredParameters;
+    // position of each deferred command, by vehicle, parameter and index
+    std::map<std::string, size_t> deferredIndex;
+    long nDeferredCommands = 0;
+    long nCoalescedCommands = 0;
 };
 
 } // namespace traci
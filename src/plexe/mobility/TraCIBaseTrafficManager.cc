@@ -19,6 +19,7 @@
 //
 
 #include "plexe/mobility/TraCIBaseTrafficManager.h"
+#include "plexe/utilities/EventProfiler.h"
 
 using namespace veins;
 
@@ -59,6 +60,7 @@ void TraCIBaseTrafficManager::initialize(int stage)
 
 void TraCIBaseTrafficManager::handleMessage(cMessage* msg)
 {
+    PROFILE_EVENT("handleMessage", msg);
     if (msg->isSelfMessage()) {
         handleSelfMsg(msg);
     }
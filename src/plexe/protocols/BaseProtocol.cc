@@ -20,13 +20,16 @@
 
 #include "plexe/protocols/BaseProtocol.h"
 
+#include <algorithm>
+
 #include "veins/modules/mac/ieee80211p/Mac1609_4.h"
 #include "veins/base/utils/FindModule.h"
 #include "veins/modules/messages/BaseFrame1609_4_m.h"
 
 #include "plexe/PlexeManager.h"
-#include "plexe/driver/Veins11pRadioDriver.h"
 #include "plexe/messages/PlexeInterfaceControlInfo_m.h"
+#include "plexe/utilities/EventProfiler.h"
+#include "plexe/utilities/LevelOfDetailManager.h"
 
 using namespace veins;
 
@@ -50,6 +53,8 @@ void BaseProtocol::initialize(int stage)
         busyTime = SimTime(0);
         seq_n = 0;
         recordData = 0;
+        fullDetail = true;
+        suspendedBeaconTime = -1;
 
         // get gates
         lowerControlIn = findGate("lowerControlIn");
@@ -76,25 +81,23 @@ void BaseProtocol::initialize(int stage)
         // priority of platooning message
         priority = par("priority");
         ASSERT2(priority >= 0 && priority <= 7, "priority value must be between 0 and 7");
+        // leader-aggregated dissemination of platoon state
+        aggregatePlatoonState = par("aggregatePlatoonState").boolValue();
+        memberStateSize = par("memberStateSize");
+        useQuantileSketches = par("useQuantileSketches").boolValue();
+        sketchAccuracy = par("sketchAccuracy").doubleValue();
+        leaderDelaySketch = QuantileSketch(sketchAccuracy);
+        frontDelaySketch = QuantileSketch(sketchAccuracy);
 
         // init messages for scheduleAt
         sendBeacon = new cMessage("sendBeacon");
-        recordData = new cMessage("recordData");
-
-        // set names for output vectors
-        // own id
-        nodeIdOut.setName("nodeId");
-        // channel busy time
-        busyTimeOut.setName("busyTime");
-        // mac layer collisions
-        collisionsOut.setName("collisions");
+
+        // output vectors
+        leanProfile = par("leanProfile").boolValue();
+        if (!leanProfile) getVectors();
         // delay metrics
         lastLeaderMsgTime = SimTime(-1);
         lastFrontMsgTime = SimTime(-1);
-        leaderDelayIdOut.setName("leaderDelayId");
-        frontDelayIdOut.setName("frontDelayId");
-        leaderDelayOut.setName("leaderDelay");
-        frontDelayOut.setName("frontDelay");
 
         // subscribe to signals for channel busy state and collisions
         findHost()->subscribe(veins::Mac1609_4::sigChannelBusy, this);
@@ -102,7 +105,14 @@ void BaseProtocol::initialize(int stage)
 
         // init statistics collection. round to second
         SimTime rounded = SimTime(floor(simTime().dbl() + 1), SIMTIME_S);
-        scheduleAt(rounded, recordData);
+        TimerService* timerService = TimerService::get();
+        if (timerService) {
+            recordDataTimer = timerService->addTimer(this, "recordData", rounded, SimTime(1, SIMTIME_S), [this]() { recordChannelData(); });
+        }
+        else {
+            recordData = new cMessage("recordData");
+            scheduleAt(rounded, recordData);
+        }
     }
 
     if (stage == 1) {
@@ -113,7 +123,7 @@ void BaseProtocol::initialize(int stage)
         ASSERT(traci);
         traciVehicle = mobility->getVehicleCommandInterface();
         ASSERT(traciVehicle);
-        auto plexe = FindModule<PlexeManager*>::findGlobalModule();
+        auto plexe = PlexeManager::get();
         ASSERT(plexe);
         plexeTraci = plexe->getCommandInterface();
         plexeTraciVehicle.reset(new traci::CommandInterface::Vehicle(plexeTraci, mobility->getExternalId()));
@@ -123,54 +133,183 @@ void BaseProtocol::initialize(int stage)
         // this is the id of the vehicle. used also as network address
         myId = positionHelper->getId();
         length = traciVehicle->getLength();
-        if (Veins11pRadioDriver* driver = FindModule<Veins11pRadioDriver*>::findSubModule(getParentModule())) {
-            driver->registerNode(myId);
+        // bind all radio drivers to our id
+        for (int i = 0; i < gateSize("radiosOut"); i++) {
+            PlexeRadioDriverInterface* radio = check_and_cast<PlexeRadioDriverInterface*>(gate("radiosOut", i)->getNextGate()->getOwnerModule());
+            radio->registerNode(myId);
+        }
+
+        if (LevelOfDetailManager* lod = LevelOfDetailManager::get()) {
+            lod->registerVehicle(this, positionHelper, mobility);
+            levelOfDetail = true;
         }
     }
 }
 
+void BaseProtocol::finish()
+{
+    if (useQuantileSketches) {
+        leaderDelaySketch.recordScalars(this, "leaderDelay");
+        frontDelaySketch.recordScalars(this, "frontDelay");
+    }
+    BaseApplLayer::finish();
+}
+
+BaseProtocol::OutputVectors* BaseProtocol::getVectors()
+{
+    // vectors are kept when the module is reused for another vehicle
+    if (vectors || vectorsChecked) return vectors.get();
+    vectorsChecked = true;
+    if (leanProfile && !isVectorRecordingEnabled(this, {"nodeId", "busyTime", "collisions", "leaderDelayId", "frontDelayId", "leaderDelay", "frontDelay"})) return nullptr;
+
+    vectors.reset(new OutputVectors());
+    // set names for output vectors
+    // own id
+    vectors->nodeIdOut.setName("nodeId");
+    // channel busy time
+    vectors->busyTimeOut.setName("busyTime");
+    // mac layer collisions
+    vectors->collisionsOut.setName("collisions");
+    // delay metrics
+    vectors->leaderDelayIdOut.setName("leaderDelayId");
+    vectors->frontDelayIdOut.setName("frontDelayId");
+    vectors->leaderDelayOut.setName("leaderDelay");
+    vectors->frontDelayOut.setName("frontDelay");
+    return vectors.get();
+}
+
+size_t BaseProtocol::getMemoryFootprint() const
+{
+    size_t bytes = sizeof(BaseProtocol);
+    if (vectors) bytes += sizeof(OutputVectors);
+    if (sendBeacon) bytes += sizeof(cMessage);
+    if (recordData) bytes += sizeof(cMessage);
+    bytes += mapFootprint(radioOuts) + mapFootprint(knownBeacons) + mapFootprint(memberStates);
+    bytes += mapFootprint(connections) + mapFootprint(apps);
+    for (const auto& app : apps) bytes += vectorFootprint(app.second);
+    bytes += leaderDelaySketch.getMemoryFootprint() + frontDelaySketch.getMemoryFootprint();
+    return bytes;
+}
+
+void BaseProtocol::addDelaySample(QuantileSketch& sketch, const char* name, simtime_t delay)
+{
+    sketch.add(delay.dbl());
+    if (positionHelper->getPlatoonId() >= 0) PlexeManager::get()->getPlatoonSketch(positionHelper->getPlatoonId(), name, sketchAccuracy).add(delay.dbl());
+}
+
 BaseProtocol::~BaseProtocol()
 {
     cancelAndDelete(sendBeacon);
     sendBeacon = nullptr;
     cancelAndDelete(recordData);
     recordData = nullptr;
+    // the service might have been deleted first at the end of the simulation
+    if (recordDataTimer >= 0 && TimerService::get()) TimerService::get()->removeTimer(recordDataTimer);
+    recordDataTimer = -1;
+    if (levelOfDetail && LevelOfDetailManager::get()) LevelOfDetailManager::get()->unregisterVehicle(myId);
+    levelOfDetail = false;
+}
+
+void BaseProtocol::resetForReuse()
+{
+    cancelAndDelete(sendBeacon);
+    sendBeacon = nullptr;
+    cancelAndDelete(recordData);
+    recordData = nullptr;
+    if (recordDataTimer >= 0) TimerService::get()->removeTimer(recordDataTimer);
+    recordDataTimer = -1;
+    if (levelOfDetail) LevelOfDetailManager::get()->unregisterVehicle(myId);
+    levelOfDetail = false;
+
+    // applications register again when they are initialized
+    for (auto& connection : connections) {
+        if (connection.second->getType() == cGate::OUTPUT)
+            connection.second->disconnect();
+        else
+            connection.first->disconnect();
+    }
+    connections.clear();
+    apps.clear();
+    usedGates = 0;
+
+    radioOuts.clear();
+    knownBeacons.clear();
+    memberStates.clear();
+    leaderDelaySketch.clear();
+    frontDelaySketch.clear();
 }
 
 void BaseProtocol::handleSelfMsg(cMessage* msg)
 {
 
     if (msg == recordData) {
+        recordChannelData();
+        scheduleAt(simTime() + SimTime(1, SIMTIME_S), recordData);
+    }
+}
 
-        // if channel is currently busy, we have to split the amount of time between
-        // this period and the successive. so we just compute the channel busy time
-        // up to now, and then reset the "startBusy" timer to now
-        if (channelBusy) {
-            busyTime += simTime() - startBusy;
-            startBusy = simTime();
-        }
+void BaseProtocol::recordChannelData()
+{
+    // if channel is currently busy, we have to split the amount of time between
+    // this period and the successive. so we just compute the channel busy time
+    // up to now, and then reset the "startBusy" timer to now
+    if (channelBusy) {
+        busyTime += simTime() - startBusy;
+        startBusy = simTime();
+    }
 
-        // time for writing statistics
+    // time for writing statistics
+    if (OutputVectors* out = getVectors()) {
         // node id
-        nodeIdOut.record(myId);
+        out->nodeIdOut.record(myId);
         // record busy time for this period
-        busyTimeOut.record(busyTime);
+        out->busyTimeOut.record(busyTime);
         // record collisions for this period
-        collisionsOut.record(nCollisions);
-
-        // and reset counter
-        busyTime = SimTime(0);
-        nCollisions = 0;
-
-        scheduleAt(simTime() + SimTime(1, SIMTIME_S), recordData);
+        out->collisionsOut.record(nCollisions);
     }
+
+    // and reset counter
+    busyTime = SimTime(0);
+    nCollisions = 0;
 }
 
 void BaseProtocol::sendPlatooningMessage(int destinationAddress, enum PlexeRadioInterfaces interfaces)
 {
+    if (!fullDetail) return;
     sendTo(createBeacon(destinationAddress).release(), interfaces);
 }
 
+void BaseProtocol::setFullDetail(bool detailed)
+{
+    Enter_Method_Silent();
+    if (detailed == fullDetail) return;
+    fullDetail = detailed;
+
+    if (!fullDetail) {
+        // remember the phase of the beacon timer
+        suspendedBeaconTime = -1;
+        if (sendBeacon->isScheduled()) {
+            suspendedBeaconTime = sendBeacon->getArrivalTime();
+            cancelEvent(sendBeacon);
+        }
+        return;
+    }
+
+    if (suspendedBeaconTime >= 0 && !sendBeacon->isScheduled()) {
+        // the first beacon after now with the same phase as before
+        simtime_t next = suspendedBeaconTime;
+        if (next < simTime() && beaconingInterval > 0) {
+            int64_t beacons = ((simTime() - next).raw() + beaconingInterval.raw() - 1) / beaconingInterval.raw();
+            next += beaconingInterval * beacons;
+        }
+        scheduleAt(std::max(next, simTime()), sendBeacon);
+    }
+    suspendedBeaconTime = -1;
+    // the time without beacons is not a delay of the network
+    lastLeaderMsgTime = SimTime(-1);
+    lastFrontMsgTime = SimTime(-1);
+}
+
 void BaseProtocol::sendTo(BaseFrame1609_4* frame, enum PlexeRadioInterfaces interfaces)
 {
     for (auto interface : radioOuts) {
@@ -196,8 +335,19 @@ std::unique_ptr<BaseFrame1609_4> BaseProtocol::createBeacon(int destinationAddre
     wsm->setChannelNumber(static_cast<int>(Channel::cch));
     wsm->setUserPriority(priority);
 
-    // create platooning beacon with data about the car
-    PlatooningBeacon* pkt = new PlatooningBeacon();
+    // create platooning beacon with data about the car. when aggregating,
+    // the leader also includes the data about all platoon members
+    PlatooningBeacon* pkt;
+    int nMembers = 0;
+    if (aggregatePlatoonState && positionHelper->isLeader()) {
+        PlatoonStateBeacon* psb = new PlatoonStateBeacon();
+        fillMemberStates(psb);
+        nMembers = psb->getMembersArraySize();
+        pkt = psb;
+    }
+    else {
+        pkt = new PlatooningBeacon();
+    }
     pkt->setControllerAcceleration(data.u);
     pkt->setAcceleration(data.acceleration);
     pkt->setSpeed(data.speed);
@@ -211,14 +361,34 @@ std::unique_ptr<BaseFrame1609_4> BaseProtocol::createBeacon(int destinationAddre
     pkt->setSpeedY(data.speedY);
     pkt->setAngle(data.angle);
     pkt->setKind(BEACON_TYPE);
-    pkt->setByteLength(packetSize);
+    pkt->setByteLength(packetSize + nMembers * memberStateSize);
     pkt->setSequenceNumber(seq_n++);
+    pkt->setFormationVersion(positionHelper->getFormationVersion());
+    if (positionHelper->getPlatoonId() >= 0) {
+        pkt->setPlatoonId(positionHelper->getPlatoonId());
+        pkt->setPlatoonPosition(positionHelper->getPosition());
+        pkt->setPlatoonLane(positionHelper->getPlatoonLane());
+    }
 
     wsm->encapsulate(pkt);
 
     return wsm;
 }
 
+void BaseProtocol::fillMemberStates(PlatoonStateBeacon* beacon)
+{
+    const std::vector<int>& formation = positionHelper->getPlatoonFormation();
+    beacon->setMembersArraySize(formation.size());
+    int n = 0;
+    for (int member : formation) {
+        if (member == myId) continue;
+        auto state = memberStates.find(member);
+        if (state == memberStates.end()) continue;
+        beacon->setMembers(n++, state->second);
+    }
+    beacon->setMembersArraySize(n);
+}
+
 bool BaseProtocol::isDuplicated(const PlatooningBeacon* beacon)
 {
     auto sequenceNumber = knownBeacons.find(beacon->getVehicleId());
@@ -231,6 +401,7 @@ void BaseProtocol::receiveSignal(cComponent* source, simsignal_t signalID, bool
 {
 
     Enter_Method_Silent();
+    PROFILE_SIGNAL(signalID);
     if (signalID == veins::Mac1609_4::sigChannelBusy) {
         if (v && !channelBusy) {
             // channel turned busy, was idle before
@@ -255,6 +426,7 @@ void BaseProtocol::receiveSignal(cComponent* source, simsignal_t signalID, bool
 
 void BaseProtocol::handleMessage(cMessage* msg)
 {
+    PROFILE_EVENT("handleMessage", msg);
     if (msg->getArrivalGateId() >= minUpperId && msg->getArrivalGateId() <= maxUpperId)
         handleUpperMsg(msg);
     else if (msg->getArrivalGateId() >= minUpperControlId && msg->getArrivalGateId() <= maxUpperControlId)
@@ -283,22 +455,44 @@ void BaseProtocol::handleLowerMsg(cMessage* msg)
         }
         knownBeacons[epkt->getVehicleId()] = epkt->getSequenceNumber();
 
+        // the leader keeps track of the last state of its members
+        if (aggregatePlatoonState && positionHelper->isLeader() && positionHelper->isInSamePlatoon(epkt->getVehicleId())) {
+            MemberState& state = memberStates[epkt->getVehicleId()];
+            state.vehicleId = epkt->getVehicleId();
+            state.controllerAcceleration = epkt->getControllerAcceleration();
+            state.acceleration = epkt->getAcceleration();
+            state.speed = epkt->getSpeed();
+            state.positionX = epkt->getPositionX();
+            state.positionY = epkt->getPositionY();
+            state.time = epkt->getTime();
+            state.length = epkt->getLength();
+            state.speedX = epkt->getSpeedX();
+            state.speedY = epkt->getSpeedY();
+            state.angle = epkt->getAngle();
+        }
+
         // invoke messageReceived() method of subclass
         messageReceived(epkt, frame);
 
         if (positionHelper->getLeaderId() == epkt->getVehicleId()) {
             // check if this is at least the second message we have received
             if (lastLeaderMsgTime.dbl() > 0) {
-                leaderDelayOut.record(simTime() - lastLeaderMsgTime);
-                leaderDelayIdOut.record(myId);
+                if (OutputVectors* out = getVectors()) {
+                    out->leaderDelayOut.record(simTime() - lastLeaderMsgTime);
+                    out->leaderDelayIdOut.record(myId);
+                }
+                if (useQuantileSketches) addDelaySample(leaderDelaySketch, "leaderDelay", simTime() - lastLeaderMsgTime);
             }
             lastLeaderMsgTime = simTime();
         }
         if (positionHelper->getFrontId() == epkt->getVehicleId()) {
             // check if this is at least the second message we have received
             if (lastFrontMsgTime.dbl() > 0) {
-                frontDelayOut.record(simTime() - lastFrontMsgTime);
-                frontDelayIdOut.record(myId);
+                if (OutputVectors* out = getVectors()) {
+                    out->frontDelayOut.record(simTime() - lastFrontMsgTime);
+                    out->frontDelayIdOut.record(myId);
+                }
+                if (useQuantileSketches) addDelaySample(frontDelaySketch, "frontDelay", simTime() - lastFrontMsgTime);
             }
             lastFrontMsgTime = simTime();
         }
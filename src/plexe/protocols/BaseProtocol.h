@@ -26,10 +26,15 @@
 #include "veins/modules/messages/BaseFrame1609_4_m.h"
 
 #include "plexe/messages/PlatooningBeacon_m.h"
+#include "plexe/messages/PlatoonStateBeacon_m.h"
 #include "plexe/mobility/CommandInterface.h"
 #include "plexe/utilities/BasePositionHelper.h"
+#include "plexe/utilities/MemoryFootprint.h"
+#include "plexe/utilities/QuantileSketch.h"
 
 #include "plexe/driver/PlexeRadioDriverInterface.h"
+#include "plexe/utilities/RecyclableModule.h"
+#include "plexe/utilities/TimerService.h"
 
 #include <memory>
 #include <tuple>
@@ -41,7 +46,7 @@ namespace plexe {
 
 using veins::BaseFrame1609_4;
 
-class BaseProtocol : public veins::BaseApplLayer {
+class BaseProtocol : public veins::BaseApplLayer, public RecyclableModule, public MemoryFootprint {
 
 private:
     // amount of time channel has been observed busy during the last "statisticsPeriod" seconds
@@ -57,14 +62,35 @@ private:
     SimTime lastLeaderMsgTime;
     SimTime lastFrontMsgTime;
 
-    // own id for statistics
-    cOutVector nodeIdOut;
+    struct OutputVectors {
+        // own id for statistics
+        cOutVector nodeIdOut;
 
-    // output vectors for busy time and collisions
-    cOutVector busyTimeOut, collisionsOut;
+        // output vectors for busy time and collisions
+        cOutVector busyTimeOut, collisionsOut;
 
-    // output vector for delays
-    cOutVector leaderDelayIdOut, frontDelayIdOut, leaderDelayOut, frontDelayOut;
+        // output vector for delays
+        cOutVector leaderDelayIdOut, frontDelayIdOut, leaderDelayOut, frontDelayOut;
+    };
+    std::unique_ptr<OutputVectors> vectors;
+
+    // if true, output vectors are only allocated when first recorded, and
+    // only if their recording is enabled
+    bool leanProfile;
+    // true once it is known whether output vectors are recorded
+    bool vectorsChecked;
+
+    // returns the output vectors, or nullptr if none of them is recorded
+    OutputVectors* getVectors();
+
+    // if true, delays are also summarized by quantile sketches, per vehicle
+    // and per platoon, recorded as scalars at the end of the simulation
+    bool useQuantileSketches;
+    double sketchAccuracy;
+    QuantileSketch leaderDelaySketch, frontDelaySketch;
+
+    // adds a delay sample to a sketch of this vehicle and of its platoon
+    void addDelaySample(QuantileSketch& sketch, const char* name, simtime_t delay);
 
     // map of radio interfaces from radio ids
     std::map<int, cGate*> radioOuts;
@@ -75,6 +101,12 @@ private:
     // indicates whether a beacon has already been received or not
     bool isDuplicated(const PlatooningBeacon* beacon);
 
+    // last known state of each platoon member, collected by the leader when aggregating
+    std::map<int, MemberState> memberStates;
+
+    // fills the aggregated beacon with the state of all known platoon members
+    void fillMemberStates(PlatoonStateBeacon* beacon);
+
 protected:
     // determines position and role of each vehicle
     BasePositionHelper* positionHelper;
@@ -92,6 +124,17 @@ protected:
     int priority;
     // packet size of the platooning message
     int packetSize;
+    // if true, the leader embeds the state of all members into its beacons
+    bool aggregatePlatoonState;
+    // additional bytes per member in aggregated beacons
+    int memberStateSize;
+
+    // false while the LevelOfDetailManager runs the vehicle in auto-feed
+    bool fullDetail;
+    // registered with the LevelOfDetailManager
+    bool levelOfDetail;
+    // expiration of the beacon timer when beaconing was stopped, or -1
+    simtime_t suspendedBeaconTime;
 
     // input/output gates from/to upper layer
     int upperControlIn, upperControlOut, lowerLayerIn, lowerLayerOut;
@@ -122,6 +165,11 @@ protected:
     // messages for scheduleAt
     cMessage* sendBeacon;
     cMessage* recordData;
+    // id of the recordData timer when using the TimerService, -1 otherwise
+    int recordDataTimer;
+
+    // records busy time and collisions for the last period and resets them
+    void recordChannelData();
 
     /**
      * NB: this method must be overridden by inheriting classes, BUT THEY MUST invoke the super class
@@ -212,11 +260,52 @@ public:
     {
         sendBeacon = nullptr;
         recordData = nullptr;
+        recordDataTimer = -1;
         usedGates = 0;
+        aggregatePlatoonState = false;
+        memberStateSize = 0;
+        fullDetail = true;
+        levelOfDetail = false;
+        useQuantileSketches = false;
+        sketchAccuracy = 0.01;
+        leanProfile = false;
+        vectorsChecked = false;
     }
     virtual ~BaseProtocol();
 
     virtual void initialize(int stage) override;
+    virtual void finish() override;
+
+    /**
+     * Frees timers, disconnects the registered applications and forgets
+     * about known beacons and platoon members
+     */
+    virtual void resetForReuse() override;
+
+    /** override from MemoryFootprint */
+    virtual size_t getMemoryFootprint() const override;
+
+    /**
+     * Returns true if the leader disseminates the state of the whole
+     * platoon in its beacons, so that members do not need to feed the
+     * controller with the data of every single beacon they receive
+     */
+    bool isAggregatingPlatoonState() const
+    {
+        return aggregatePlatoonState;
+    }
+
+    /**
+     * Stops or restarts beaconing. While beaconing is stopped, the vehicle
+     * is fed by SUMO (see LevelOfDetailManager). When restarted, beacons
+     * keep the sequence numbers and the phase they had before
+     */
+    void setFullDetail(bool detailed);
+
+    bool isFullDetail() const
+    {
+        return fullDetail;
+    }
 
     // register a higher level application by its id
     void registerApplication(int applicationId, InputGate* appInputGate, OutputGate* appOutputGate, ControlInputGate* appControlInputGate, ControlOutputGate* appControlOutputGate);
@@ -70,6 +70,15 @@ AccelerateAndBrakeScenario::~AccelerateAndBrakeScenario()
     startBrakingMsg = nullptr;
 }
 
+void AccelerateAndBrakeScenario::resetForReuse()
+{
+    cancelAndDelete(startAccelerationMsg);
+    startAccelerationMsg = nullptr;
+    cancelAndDelete(startBrakingMsg);
+    startBrakingMsg = nullptr;
+    BaseScenario::resetForReuse();
+}
+
 void AccelerateAndBrakeScenario::handleSelfMsg(cMessage* msg)
 {
     BaseScenario::handleSelfMsg(msg);
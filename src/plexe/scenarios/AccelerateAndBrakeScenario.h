@@ -62,6 +62,7 @@ public:
         appl = 0;
     }
     virtual ~AccelerateAndBrakeScenario();
+    virtual void resetForReuse();
 
 protected:
     virtual void handleSelfMsg(cMessage* msg);
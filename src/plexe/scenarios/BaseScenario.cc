@@ -24,6 +24,7 @@
 
 #include "plexe/PlexeManager.h"
 #include "plexe/utilities/DynamicPositionManager.h"
+#include "plexe/utilities/EventProfiler.h"
 
 using namespace veins;
 
@@ -92,7 +93,7 @@ void BaseScenario::initialize(int stage)
         ASSERT(traci);
         traciVehicle = mobility->getVehicleCommandInterface();
         ASSERT(traciVehicle);
-        auto plexe = FindModule<PlexeManager*>::findGlobalModule();
+        auto plexe = PlexeManager::get();
         ASSERT(plexe);
         plexeTraci = plexe->getCommandInterface();
         plexeTraciVehicle.reset(new traci::CommandInterface::Vehicle(plexeTraci, mobility->getExternalId()));
@@ -103,17 +104,20 @@ void BaseScenario::initialize(int stage)
 
         // set the active controller
         if (positionHelper->isLeader()) {
-            plexeTraciVehicle->setActiveController(ACC);
-            plexeTraciVehicle->setACCHeadwayTime(leaderHeadway);
+            plexeTraciVehicle->queueParameter(PAR_ACTIVE_CONTROLLER, ACC);
+            plexeTraciVehicle->queueParameter(PAR_ACC_HEADWAY_TIME, leaderHeadway);
         }
         else {
-            plexeTraciVehicle->setActiveController(controller);
-            plexeTraciVehicle->setACCHeadwayTime(accHeadway);
+            plexeTraciVehicle->queueParameter(PAR_ACTIVE_CONTROLLER, controller);
+            plexeTraciVehicle->queueParameter(PAR_ACC_HEADWAY_TIME, accHeadway);
         }
+        plexeTraciVehicle->queueParameter(PAR_USE_PREDICTION, usePrediction ? 1 : 0);
+        // apply the whole controller configuration in a single message
+        plexeTraci->sendQueuedParameters();
+
         // set the current lane
         plexeTraciVehicle->setFixedLane(positionHelper->getPlatoonLane());
         traciVehicle->setSpeedMode(0);
-        plexeTraciVehicle->usePrediction(usePrediction);
 
         if (positionHelper->getId() == 0) traci->guiView("View #0").trackVehicle(mobility->getExternalId());
 
@@ -137,31 +141,49 @@ double BaseScenario::getTargetDistance(double speed)
     }
 }
 
+void BaseScenario::handleMessage(cMessage* msg)
+{
+    PROFILE_EVENT("handleMessage", msg);
+    BaseApplLayer::handleMessage(msg);
+}
+
 void BaseScenario::handleSelfMsg(cMessage* msg)
 {
 }
 
+void BaseScenario::resetForReuse()
+{
+    // controllers are configured again by initialize()
+}
+
 void BaseScenario::initializeControllers()
 {
+    // all parameters are queued and sent to SUMO in a single message by
+    // initialize(), instead of paying one round trip per parameter
     // engine lag
-    traciVehicle->setParameter(CC_PAR_ENGINE_TAU, engineTau);
-    traciVehicle->setParameter(CC_PAR_UMIN, uMin);
-    traciVehicle->setParameter(CC_PAR_UMAX, uMax);
+    plexeTraciVehicle->queueParameter(CC_PAR_ENGINE_TAU, engineTau);
+    plexeTraciVehicle->queueParameter(CC_PAR_UMIN, uMin);
+    plexeTraciVehicle->queueParameter(CC_PAR_UMAX, uMax);
     // PATH's CACC parameters
-    plexeTraciVehicle->setPathCACCParameters(caccOmegaN, caccXi, caccC1, caccSpacing);
+    if (caccOmegaN >= 0) plexeTraciVehicle->queueParameter(CC_PAR_CACC_OMEGA_N, caccOmegaN);
+    if (caccXi >= 0) plexeTraciVehicle->queueParameter(CC_PAR_CACC_XI, caccXi);
+    if (caccC1 >= 0) plexeTraciVehicle->queueParameter(CC_PAR_CACC_C1, caccC1);
+    if (caccSpacing >= 0) plexeTraciVehicle->queueParameter(PAR_CACC_SPACING, caccSpacing);
     // Ploeg's parameters
-    plexeTraciVehicle->setPloegCACCParameters(ploegKp, ploegKd, ploegH);
+    if (ploegKp >= 0) plexeTraciVehicle->queueParameter(CC_PAR_PLOEG_KP, ploegKp);
+    if (ploegKd >= 0) plexeTraciVehicle->queueParameter(CC_PAR_PLOEG_KD, ploegKd);
+    if (ploegH >= 0) plexeTraciVehicle->queueParameter(CC_PAR_PLOEG_H, ploegH);
     // flatbed's parameters
-    traciVehicle->setParameter(CC_PAR_FLATBED_KA, flatbedKa);
-    traciVehicle->setParameter(CC_PAR_FLATBED_KV, flatbedKv);
-    traciVehicle->setParameter(CC_PAR_FLATBED_KP, flatbedKp);
-    traciVehicle->setParameter(CC_PAR_FLATBED_H, flatbedH);
-    traciVehicle->setParameter(CC_PAR_FLATBED_D, flatbedD);
+    plexeTraciVehicle->queueParameter(CC_PAR_FLATBED_KA, flatbedKa);
+    plexeTraciVehicle->queueParameter(CC_PAR_FLATBED_KV, flatbedKv);
+    plexeTraciVehicle->queueParameter(CC_PAR_FLATBED_KP, flatbedKp);
+    plexeTraciVehicle->queueParameter(CC_PAR_FLATBED_H, flatbedH);
+    plexeTraciVehicle->queueParameter(CC_PAR_FLATBED_D, flatbedD);
     // consensus parameters
-    traciVehicle->setParameter(CC_PAR_VEHICLE_POSITION, positionHelper->getPosition());
-    traciVehicle->setParameter(CC_PAR_PLATOON_SIZE, positionHelper->getPlatoonSize());
+    plexeTraciVehicle->queueParameter(CC_PAR_VEHICLE_POSITION, positionHelper->getPosition());
+    plexeTraciVehicle->queueParameter(CC_PAR_PLATOON_SIZE, positionHelper->getPlatoonSize());
     // use of controller acceleration
-    plexeTraciVehicle->useControllerAcceleration(useControllerAcceleration);
+    plexeTraciVehicle->queueParameter(PAR_USE_CONTROLLER_ACCELERATION, useControllerAcceleration ? 1 : 0);
 
     VEHICLE_DATA vehicleData;
     // initialize own vehicle data
@@ -177,19 +199,18 @@ void BaseScenario::initializeControllers()
         vehicleData.speed = 200;
         vehicleData.time = simTime().dbl();
         vehicleData.u = 0;
-        plexeTraciVehicle->setVehicleData(&vehicleData);
+        plexeTraciVehicle->queueVehicleData(&vehicleData);
     }
 
     if (useRealisticEngine) {
         int engineModel = CC_ENGINE_MODEL_REALISTIC;
-        // the order is important
+        // the order is important, and it is kept within the queue
         // 1. let sumo instantiate the realistic engine model
-        traciVehicle->setParameter(CC_PAR_VEHICLE_ENGINE_MODEL, engineModel);
+        plexeTraciVehicle->queueParameter(CC_PAR_VEHICLE_ENGINE_MODEL, engineModel);
         // 2. tell the realistic engine model the location of the parameters file
-        traciVehicle->setParameter(CC_PAR_VEHICLES_FILE, vehicleFile);
+        plexeTraciVehicle->queueParameter(CC_PAR_VEHICLES_FILE, vehicleFile);
         // 3. tell the realistic engine model which vehicle (in the specified parameters file) to use
-        traciVehicle->setParameter(CC_PAR_VEHICLE_MODEL, vehicleType);
-
+        plexeTraciVehicle->queueParameter(CC_PAR_VEHICLE_MODEL, vehicleType);
     }
 }
 
@@ -26,10 +26,11 @@
 
 #include "plexe/utilities/BasePositionHelper.h"
 #include "plexe/mobility/CommandInterface.h"
+#include "plexe/utilities/RecyclableModule.h"
 
 namespace plexe {
 
-class BaseScenario : public veins::BaseApplLayer {
+class BaseScenario : public veins::BaseApplLayer, public RecyclableModule {
 
 public:
     virtual void initialize(int stage) override;
@@ -109,7 +110,12 @@ public:
 
     int numInitStages() const override { return 3; }
 
+    /** override from RecyclableModule */
+    virtual void resetForReuse() override;
+
 protected:
+    // override handleMessage to account the time spent in each event
+    virtual void handleMessage(cMessage* msg) override;
     virtual void handleSelfMsg(cMessage* msg) override;
 };
 
@@ -72,6 +72,13 @@ BrakingScenario::~BrakingScenario()
     changeSpeed = nullptr;
 }
 
+void BrakingScenario::resetForReuse()
+{
+    cancelAndDelete(changeSpeed);
+    changeSpeed = nullptr;
+    BaseScenario::resetForReuse();
+}
+
 void BrakingScenario::handleSelfMsg(cMessage* msg)
 {
     BaseScenario::handleSelfMsg(msg);
@@ -56,6 +56,7 @@ public:
         appl = 0;
     }
     virtual ~BrakingScenario();
+    virtual void resetForReuse();
 
 protected:
     virtual void handleSelfMsg(cMessage* msg);
@@ -20,6 +20,8 @@
 
 #include "plexe/scenarios/JoinManeuverScenario.h"
 
+#include "plexe/utilities/LevelOfDetailManager.h"
+
 namespace plexe {
 
 Define_Module(JoinManeuverScenario);
@@ -29,6 +31,15 @@ void JoinManeuverScenario::initialize(int stage)
 
     BaseScenario::initialize(stage);
 
+    if (stage == 0) {
+        discoverPlatoon = par("discoverPlatoon").boolValue();
+        discoveryLane = par("discoveryLane");
+        discoveryRange = par("discoveryRange").doubleValue();
+        // platoons in auto-feed do not beacon, so they cannot be discovered
+        if (discoverPlatoon && LevelOfDetailManager::get())
+            throw cRuntimeError("discoverPlatoon cannot be used with enableLevelOfDetail: platoons in auto-feed do not beacon");
+    }
+
     if (stage == 2) {
         app = FindModule<GeneralPlatooningApp*>::findSubModule(getParentModule());
         prepareManeuverCars(0);
@@ -87,13 +98,31 @@ JoinManeuverScenario::~JoinManeuverScenario()
     startManeuver = nullptr;
 }
 
+void JoinManeuverScenario::resetForReuse()
+{
+    cancelAndDelete(startManeuver);
+    startManeuver = nullptr;
+    BaseScenario::resetForReuse();
+}
+
 void JoinManeuverScenario::handleSelfMsg(cMessage* msg)
 {
 
     // this takes car of feeding data into CACC and reschedule the self message
     BaseScenario::handleSelfMsg(msg);
 
-    if (msg == startManeuver) app->startJoinManeuver(0, 0, -1);
+    if (msg == startManeuver) {
+        if (!discoverPlatoon) {
+            app->startJoinManeuver(0, 0, -1);
+            return;
+        }
+        int platoonId, leaderId;
+        if (app->findPlatoonAhead(discoveryLane, discoveryRange, platoonId, leaderId))
+            app->startJoinManeuver(platoonId, leaderId, -1);
+        else
+            // no platoon in sight yet, try again later
+            scheduleAt(simTime() + SimTime(1), startManeuver);
+    }
 }
 
 } // namespace plexe
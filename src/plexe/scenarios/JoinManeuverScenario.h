@@ -35,6 +35,11 @@ protected:
     // pointer to protocol
     GeneralPlatooningApp* app;
 
+    // whether the platoon is discovered through the neighbor table
+    bool discoverPlatoon;
+    int discoveryLane;
+    double discoveryRange;
+
 public:
     static const int MANEUVER_TYPE = 12347;
 
@@ -48,6 +53,7 @@ public:
         app = nullptr;
     }
     virtual ~JoinManeuverScenario();
+    virtual void resetForReuse() override;
 
 protected:
     virtual void handleSelfMsg(cMessage* msg) override;
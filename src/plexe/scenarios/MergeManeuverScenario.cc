@@ -70,6 +70,13 @@ MergeManeuverScenario::~MergeManeuverScenario()
     startManeuver = nullptr;
 }
 
+void MergeManeuverScenario::resetForReuse()
+{
+    cancelAndDelete(startManeuver);
+    startManeuver = nullptr;
+    BaseScenario::resetForReuse();
+}
+
 void MergeManeuverScenario::handleSelfMsg(cMessage* msg)
 {
 
@@ -47,6 +47,7 @@ public:
         app = nullptr;
     }
     virtual ~MergeManeuverScenario();
+    virtual void resetForReuse() override;
 
 protected:
     virtual void handleSelfMsg(cMessage* msg) override;
@@ -20,6 +20,8 @@
 
 #include "OvertakeManeuverScenario.h"
 
+#include "plexe/utilities/LevelOfDetailManager.h"
+
 namespace plexe {
 
 Define_Module(OvertakeManeuverScenario);
@@ -28,6 +30,33 @@ void OvertakeManeuverScenario::initialize(int stage) {
 
     BaseScenario::initialize(stage);
     timeEmergency  = par("timeEmergency").doubleValue();
+    emergencyDuration = par("emergencyDuration").doubleValue();
+
+    if (stage == 0) {
+        nTrials = par("nTrials");
+        emergencyDelayMin = par("emergencyDelayMin").doubleValue();
+        emergencyDelayMax = par("emergencyDelayMax").doubleValue();
+        trialTimeout = par("trialTimeout").doubleValue();
+        discoverPlatoon = par("discoverPlatoon").boolValue();
+        discoveryLane = par("discoveryLane");
+        discoveryRange = par("discoveryRange").doubleValue();
+        // platoons in auto-feed do not beacon, so they cannot be discovered
+        if (discoverPlatoon && LevelOfDetailManager::get())
+            throw cRuntimeError(
+                    "discoverPlatoon cannot be used with enableLevelOfDetail: platoons in auto-feed do not beacon");
+        currentTrial = 0;
+        completedTrials = 0;
+        trialRunning = false;
+        // vectors are named once and kept when the module is reused, as
+        // renaming a vector that already recorded data is an error
+        if (!vectorsNamed) {
+            trialDurationOut.setName("trialDuration");
+            trialEmergencyDelayOut.setName("trialEmergencyDelay");
+            trialCompletedOut.setName("trialCompleted");
+            trialInterruptedOut.setName("trialInterrupted");
+            vectorsNamed = true;
+        }
+    }
 
     if (stage == 2) {
         app = FindModule<GeneralPlatooningApp*>::findSubModule(
@@ -58,8 +87,20 @@ void OvertakeManeuverScenario::prepareManeuverCars(int platoonLane) {
 
         emergencyOn = new cMessage();
         emergencyOff = new cMessage();
-        scheduleAt(SimTime(timeEmergency), emergencyOn); //prova per interrompere manovra
-        scheduleAt(SimTime(timeEmergency + 20), emergencyOff); //prova per interrompere manovra
+        if (nTrials > 1) {
+            // emergencies are scheduled when each trial starts
+            trafficManager = FindModule<OvertakeTrafficManager*>::findGlobalModule();
+            if (!trafficManager)
+                throw cRuntimeError("Running several overtake trials requires an OvertakeTrafficManager");
+            // the overtaker of each trial is inserted when the previous one ends
+            trafficManager->controlOvertakerInsertion();
+            admittedBeforeTrial = app->getAdmittedOvertakes();
+            checkTrial = new cMessage("checkTrial");
+            scheduleAt(simTime() + SimTime(0.1), checkTrial);
+        } else {
+            scheduleAt(SimTime(timeEmergency), emergencyOn); //prova per interrompere manovra
+            scheduleAt(SimTime(timeEmergency) + emergencyDuration, emergencyOff); //prova per interrompere manovra
+        }
 
         break;
     }
@@ -78,8 +119,9 @@ void OvertakeManeuverScenario::prepareManeuverCars(int platoonLane) {
         break;
     }
 
-    case 8: {
-        // this is the car which will overtake
+    default: {
+        // vehicles inserted after the platoons are the ones which will overtake
+        if (positionHelper->getId() < 8) break;
         plexeTraciVehicle->setCruiseControlDesiredSpeed(130.0 / 3.6);
         plexeTraciVehicle->setActiveController(ACC);
         plexeTraciVehicle->setFixedLane(platoonLane);
@@ -93,6 +135,63 @@ void OvertakeManeuverScenario::prepareManeuverCars(int platoonLane) {
     }
 }
 
+void OvertakeManeuverScenario::updateTrial() {
+    if (!trialRunning) {
+        // the trial starts when the leader admits the overtaker
+        if (app->getAdmittedOvertakes() == admittedBeforeTrial)
+            return;
+        trialRunning = true;
+        trialOvertaker = app->getLastAdmittedOvertaker();
+        trialStart = simTime();
+        trialEmergencyDelay = uniform(emergencyDelayMin, emergencyDelayMax);
+        scheduleAt(trialStart + trialEmergencyDelay, emergencyOn);
+        scheduleAt(trialStart + trialEmergencyDelay + emergencyDuration,
+                emergencyOff);
+        return;
+    }
+
+    // only the overtaker of this trial counts, not the ones of timed out trials
+    bool completed = app->getLastCompletedOvertaker() == trialOvertaker;
+    if (completed || simTime() - trialStart >= trialTimeout)
+        endTrial(completed);
+}
+
+void OvertakeManeuverScenario::endTrial(bool completed) {
+    trialDurationOut.record(simTime() - trialStart);
+    trialEmergencyDelayOut.record(trialEmergencyDelay);
+    trialCompletedOut.record(completed ? 1 : 0);
+    // whether the emergency started before the overtake ended
+    bool emergencyStarted = !emergencyOn->isScheduled();
+    trialInterruptedOut.record(emergencyStarted ? 1 : 0);
+    if (completed)
+        completedTrials++;
+
+    // the next overtaker must find no emergency going on. an emergency
+    // that never started must not be cleared, or a spurious hazard end
+    // would be reported
+    if (emergencyStarted && emergencyOff->isScheduled())
+        app->emergency(false);
+    cancelEvent(emergencyOn);
+    cancelEvent(emergencyOff);
+    // a timed out overtake must not leak into the next trial
+    if (!completed)
+        app->cancelOvertakes();
+
+    trialRunning = false;
+    admittedBeforeTrial = app->getAdmittedOvertakes();
+    currentTrial++;
+    if (currentTrial < nTrials)
+        trafficManager->insertOvertaker();
+}
+
+void OvertakeManeuverScenario::finish() {
+    if (nTrials > 1 && positionHelper->getId() == 0) {
+        recordScalar("trials", currentTrial);
+        recordScalar("completedTrials", completedTrials);
+    }
+    BaseScenario::finish();
+}
+
 OvertakeManeuverScenario::~OvertakeManeuverScenario() {
     cancelAndDelete(startManeuver);
     startManeuver = nullptr;
@@ -100,16 +199,40 @@ OvertakeManeuverScenario::~OvertakeManeuverScenario() {
     emergencyOn = nullptr;
     cancelAndDelete (emergencyOff);
     emergencyOff = nullptr;
+    cancelAndDelete(checkTrial);
+    checkTrial = nullptr;
 
 }
 
+void OvertakeManeuverScenario::resetForReuse() {
+    cancelAndDelete(startManeuver);
+    startManeuver = nullptr;
+    cancelAndDelete(emergencyOn);
+    emergencyOn = nullptr;
+    cancelAndDelete(emergencyOff);
+    emergencyOff = nullptr;
+    cancelAndDelete(checkTrial);
+    checkTrial = nullptr;
+    trafficManager = nullptr;
+    BaseScenario::resetForReuse();
+}
+
 void OvertakeManeuverScenario::handleSelfMsg(cMessage *msg) {
     // this takes car of feeding data into CACC and reschedule the self message
     BaseScenario::handleSelfMsg(msg);
 
     if (msg == startManeuver) {
         std::cout << "starting maneuver" << " -time:(" << simTime() << ") \n"; //debugc
-        app->startOvertakeManeuver(0, 0);
+        if (!discoverPlatoon) {
+            app->startOvertakeManeuver(0, 0);
+        } else {
+            int platoonId, leaderId;
+            if (app->findPlatoonAhead(discoveryLane, discoveryRange, platoonId, leaderId))
+                app->startOvertakeManeuver(platoonId, leaderId);
+            else
+                // no platoon in sight yet, try again later
+                scheduleAt(simTime() + SimTime(1), startManeuver);
+        }
     }
 
     if (msg == emergencyOn) {
@@ -124,6 +247,12 @@ void OvertakeManeuverScenario::handleSelfMsg(cMessage *msg) {
         app->emergency(false);
     }
 
+    if (msg == checkTrial) {
+        updateTrial();
+        if (currentTrial < nTrials)
+            scheduleAt(simTime() + SimTime(0.1), checkTrial);
+    }
+
 }
 
 } // namespace plexe
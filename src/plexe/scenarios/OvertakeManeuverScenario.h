@@ -25,6 +25,7 @@
 #include "plexe/scenarios/BaseScenario.h"
 #include "plexe/apps/GeneralPlatooningApp.h"
 #include "plexe/messages/ManeuverMessage_m.h"
+#include "plexe/traffic/OvertakeTrafficManager.h"
 
 namespace plexe {
 
@@ -35,6 +36,12 @@ protected:
     cMessage* startManeuver;
     // pointer to protocol
     GeneralPlatooningApp* app;
+
+    // whether the platoon is discovered through the neighbor table
+    bool discoverPlatoon;
+    int discoveryLane;
+    double discoveryRange;
+
     // message used to abort the overtake
 
     cMessage* emergencyOn;
@@ -42,11 +49,39 @@ protected:
     cMessage* emergencyOff;
 
     int timeEmergency;
+    simtime_t emergencyDuration;
+
+    // multi-trial mode: the leader runs nTrials overtakes in a row, each
+    // with an emergency injected at a random delay after the overtaker is
+    // admitted. a new overtaker is inserted when the previous trial ends
+    int nTrials;
+    int currentTrial;
+    int completedTrials;
+    bool trialRunning;
+    simtime_t trialStart;
+    simtime_t trialEmergencyDelay;
+    double emergencyDelayMin;
+    double emergencyDelayMax;
+    simtime_t trialTimeout;
+    // admitted overtakes of the leader when the current trial was set up
+    long admittedBeforeTrial;
+    // id of the vehicle overtaking in the current trial
+    int trialOvertaker;
+    cMessage* checkTrial;
+    OvertakeTrafficManager* trafficManager;
+
+    // per-trial results, one sample per trial in trial order
+    cOutVector trialDurationOut;
+    cOutVector trialEmergencyDelayOut;
+    cOutVector trialCompletedOut;
+    cOutVector trialInterruptedOut;
+    bool vectorsNamed;
 
 public:
     static const int MANEUVER_TYPE = 12347;
 
     virtual void initialize(int stage) override;
+    virtual void finish() override;
 
 private:
 public:
@@ -55,16 +90,29 @@ public:
         startManeuver = nullptr;
         emergencyOff = nullptr;
         emergencyOn = nullptr;
+        checkTrial = nullptr;
 
         app = nullptr;
+        trafficManager = nullptr;
+        nTrials = 1;
+        currentTrial = 0;
+        completedTrials = 0;
+        trialRunning = false;
+        vectorsNamed = false;
     }
     virtual ~OvertakeManeuverScenario();
+    virtual void resetForReuse() override;
 
 protected:
     virtual void handleSelfMsg(cMessage* msg) override;
 
     void prepareManeuverCars(int platoonLane);
     void setupFormation();
+
+    // checks whether the current trial started or ended
+    void updateTrial();
+    // records the outcome of the current trial and sets up the next one
+    void endTrial(bool completed);
 };
 
 } // namespace plexe
@@ -0,0 +1,151 @@
+//
+// Copyright (C) 2012-2021 Michele Segata <segata@ccs-labs.org>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include "plexe/scenarios/RingJoinScenario.h"
+
+#include "plexe/utilities/DynamicPositionManager.h"
+
+namespace plexe {
+
+Define_Module(RingJoinScenario);
+
+void RingJoinScenario::initialize(int stage)
+{
+
+    BaseScenario::initialize(stage);
+
+    if (stage == 0) {
+        platooningVType = par("platooningVType").stdstringValue();
+        joinRetryInterval = SimTime(par("joinRetryInterval").doubleValue());
+        joinTimeout = SimTime(par("joinTimeout").doubleValue());
+        memberStay = SimTime(par("memberStay").doubleValue());
+    }
+
+    if (stage == 2) {
+        app = FindModule<GeneralPlatooningApp*>::findSubModule(getParentModule());
+        trafficManager = FindModule<RingTrafficManager*>::findGlobalModule();
+        if (!trafficManager) throw cRuntimeError("RingJoinScenario requires a RingTrafficManager");
+
+        plexeTraciVehicle->setFixedLane(traciVehicle->getLaneIndex());
+        if (positionHelper->getPlatoonSize() == 1) {
+            // a visitor. drive alone until joining a platoon
+            plexeTraciVehicle->setCruiseControlDesiredSpeed(mobility->getSpeed());
+            app->setPlatoonRole(PlatoonRole::NONE);
+            insertTime = simTime();
+            startManeuver = new cMessage("startManeuver");
+            scheduleAt(simTime() + joinRetryInterval, startManeuver);
+        }
+        else if (positionHelper->isLeader()) {
+            plexeTraciVehicle->setCruiseControlDesiredSpeed(mobility->getSpeed());
+            // joiners approach the platoon at this speed
+            positionHelper->setPlatoonSpeed(mobility->getSpeed());
+            positionHelper->setPlatoonLane(traciVehicle->getLaneIndex());
+            app->setPlatoonRole(PlatoonRole::LEADER);
+            initialPlatoonSize = positionHelper->getPlatoonSize();
+            dropMember = new cMessage("dropMember");
+            scheduleAt(simTime() + memberStay, dropMember);
+        }
+        else {
+            plexeTraciVehicle->setCruiseControlDesiredSpeed(mobility->getSpeed() + 10);
+            app->setPlatoonRole(PlatoonRole::FOLLOWER);
+        }
+    }
+}
+
+RingJoinScenario::~RingJoinScenario()
+{
+    cancelAndDelete(startManeuver);
+    startManeuver = nullptr;
+    cancelAndDelete(dropMember);
+    dropMember = nullptr;
+}
+
+void RingJoinScenario::resetForReuse()
+{
+    cancelAndDelete(startManeuver);
+    startManeuver = nullptr;
+    cancelAndDelete(dropMember);
+    dropMember = nullptr;
+    initialPlatoonSize = 0;
+    BaseScenario::resetForReuse();
+}
+
+void RingJoinScenario::handleSelfMsg(cMessage* msg)
+{
+
+    // this takes car of feeding data into CACC and reschedule the self message
+    BaseScenario::handleSelfMsg(msg);
+
+    if (msg == startManeuver) {
+        // joined: the leader will drop us later on
+        if (app->getPlatoonRole() == PlatoonRole::FOLLOWER) return;
+        if (!app->isInManeuver()) {
+            if (simTime() - insertTime >= joinTimeout) {
+                // no platoon accepted us
+                removeVehicle(positionHelper->getId());
+                return;
+            }
+            joinPlatoon();
+        }
+        scheduleAt(simTime() + joinRetryInterval, startManeuver);
+    }
+
+    if (msg == dropMember) {
+        // do not drop anybody in the middle of a join
+        if (!app->isInManeuver() && positionHelper->getPlatoonSize() > initialPlatoonSize) dropTailMember();
+        scheduleAt(simTime() + memberStay, dropMember);
+    }
+}
+
+void RingJoinScenario::joinPlatoon()
+{
+    // spread the visitors over the platoons inserted by the traffic manager
+    int platoonId = positionHelper->getId() % trafficManager->getPlatoonCount();
+    int leaderId = DynamicPositionManager::getInstance().getMemberId(platoonId, 0);
+    app->startJoinManeuver(platoonId, leaderId, -1);
+}
+
+void RingJoinScenario::dropTailMember()
+{
+    std::vector<int> formation = positionHelper->getPlatoonFormation();
+    int tailId = formation.back();
+    formation.pop_back();
+    positionHelper->setPlatoonFormation(formation);
+    app->sendPlatoonFormationUpdate();
+    removeVehicle(tailId);
+}
+
+void RingJoinScenario::removeVehicle(int vehicleId)
+{
+    // forget the platoon the visitor was inserted with
+    DynamicPositionManager& positions = DynamicPositionManager::getInstance();
+    int platoonId = positions.getPlatoonId(vehicleId);
+    positions.removeVehicleFromPlatoon(vehicleId);
+    positions.removePlatoon(platoonId);
+
+    // the vehicle leaves the simulation as if it reached its destination.
+    // queued commands for the vehicle would fail once it is gone
+    std::stringstream ss;
+    ss << platooningVType << "." << vehicleId;
+    plexeTraci->sendDeferredParameters();
+    plexeTraci->vehicle(ss.str()).remove();
+}
+
+} // namespace plexe
@@ -0,0 +1,88 @@
+//
+// Copyright (C) 2012-2021 Michele Segata <segata@ccs-labs.org>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#ifndef RINGJOINSCENARIO_H_
+#define RINGJOINSCENARIO_H_
+
+#include "plexe/scenarios/BaseScenario.h"
+#include "plexe/apps/GeneralPlatooningApp.h"
+#include "plexe/traffic/RingTrafficManager.h"
+
+namespace plexe {
+
+/**
+ * Scenario for long runs on the ring. The platoons inserted by the
+ * RingTrafficManager drive around the ring, while the vehicles it inserts
+ * alone (visitors) join one of them at the back. The leaders drop their
+ * tail visitor after a while and the visitor leaves the simulation, so
+ * that vehicles keep entering and leaving and maneuvers keep starting
+ * during the whole run.
+ */
+class RingJoinScenario : public BaseScenario {
+
+protected:
+    // pointer to the application
+    GeneralPlatooningApp* app;
+    RingTrafficManager* trafficManager;
+
+    // sumo vehicle type for platooning cars
+    std::string platooningVType;
+    SimTime joinRetryInterval;
+    SimTime joinTimeout;
+    SimTime memberStay;
+
+    // visitors: starts a join maneuver, or retries it if it failed
+    cMessage* startManeuver;
+    // leaders: drops the visitor at the tail of the platoon
+    cMessage* dropMember;
+    // size of the platoon of a leader before any visitor joined it
+    int initialPlatoonSize;
+    // when the visitor entered the simulation
+    simtime_t insertTime;
+
+public:
+    virtual void initialize(int stage) override;
+
+    RingJoinScenario()
+    {
+        app = nullptr;
+        trafficManager = nullptr;
+        startManeuver = nullptr;
+        dropMember = nullptr;
+        initialPlatoonSize = 0;
+    }
+    virtual ~RingJoinScenario();
+    virtual void resetForReuse() override;
+
+protected:
+    virtual void handleSelfMsg(cMessage* msg) override;
+
+    // visitors: joins the platoon assigned to this vehicle
+    void joinPlatoon();
+    // leaders: removes the visitor at the tail from the platoon and from
+    // the simulation
+    void dropTailMember();
+    // removes a vehicle from the simulation
+    void removeVehicle(int vehicleId);
+};
+
+} // namespace plexe
+
+#endif
@@ -57,6 +57,14 @@ void SimpleScenario::initialize(int stage) {
 
 }
 
+void SimpleScenario::resetForReuse() {
+    cancelAndDelete(msgstart);
+    msgstart = nullptr;
+    cancelAndDelete(msgcheckposition);
+    msgcheckposition = nullptr;
+    BaseScenario::resetForReuse();
+}
+
 void SimpleScenario::handleSelfMsg(cMessage *msg) {
     if (msg == msgstart) {
         plexeTraciVehicle->setCACCConstantSpacing(15);
@@ -30,6 +30,7 @@ class SimpleScenario: public BaseScenario {
 public:
     virtual void initialize(int stage);
     virtual void handleSelfMsg(cMessage *msg);
+    virtual void resetForReuse();
 
 protected:
     // leader average speed
@@ -48,6 +49,8 @@ private:
 public:
     SimpleScenario()
     : leaderSpeed(0)
+    , msgstart(nullptr)
+    , msgcheckposition(nullptr)
     , appl(nullptr) {};
 }
 ;
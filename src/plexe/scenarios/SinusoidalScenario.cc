@@ -20,6 +20,8 @@
 
 #include "plexe/scenarios/SinusoidalScenario.h"
 
+#include "plexe/utilities/TimerService.h"
+
 namespace plexe {
 
 Define_Module(SinusoidalScenario);
@@ -43,12 +45,13 @@ void SinusoidalScenario::initialize(int stage)
 
         if (positionHelper->getId() < nLanes) {
             // setup oscillation message, only if i'm part of the first leaders
-            changeSpeed = new cMessage("changeSpeed");
-            if (simTime() > startOscillating) {
-                startOscillating = simTime();
-                scheduleAt(simTime(), changeSpeed);
+            if (simTime() > startOscillating) startOscillating = simTime();
+            TimerService* timerService = TimerService::get();
+            if (timerService) {
+                changeSpeedTimer = timerService->addTimer(this, "changeSpeed", startOscillating, SimTime(0.1), [this]() { updateDesiredSpeed(); });
             }
             else {
+                changeSpeed = new cMessage("changeSpeed");
                 scheduleAt(startOscillating, changeSpeed);
             }
             // set base cruising speed
@@ -66,15 +69,32 @@ SinusoidalScenario::~SinusoidalScenario()
 {
     cancelAndDelete(changeSpeed);
     changeSpeed = nullptr;
+    // the service might have been deleted first at the end of the simulation
+    if (changeSpeedTimer >= 0 && TimerService::get()) TimerService::get()->removeTimer(changeSpeedTimer);
+    changeSpeedTimer = -1;
+}
+
+void SinusoidalScenario::resetForReuse()
+{
+    cancelAndDelete(changeSpeed);
+    changeSpeed = nullptr;
+    if (changeSpeedTimer >= 0) TimerService::get()->removeTimer(changeSpeedTimer);
+    changeSpeedTimer = -1;
+    BaseScenario::resetForReuse();
 }
 
 void SinusoidalScenario::handleSelfMsg(cMessage* msg)
 {
     BaseScenario::handleSelfMsg(msg);
     if (msg == changeSpeed) {
-        plexeTraciVehicle->setCruiseControlDesiredSpeed(leaderSpeed + oscillationAmplitude * sin(2 * M_PI * (simTime() - startOscillating).dbl() * leaderOscillationFrequency));
+        updateDesiredSpeed();
         scheduleAt(simTime() + SimTime(0.1), changeSpeed);
     }
 }
 
+void SinusoidalScenario::updateDesiredSpeed()
+{
+    plexeTraciVehicle->setCruiseControlDesiredSpeed(leaderSpeed + oscillationAmplitude * sin(2 * M_PI * (simTime() - startOscillating).dbl() * leaderOscillationFrequency));
+}
+
 } // namespace plexe
@@ -41,6 +41,8 @@ protected:
     int nLanes;
     // message used to tell the leader to continuously change its desired speed
     cMessage* changeSpeed;
+    // id of the changeSpeed timer when using the TimerService, -1 otherwise
+    int changeSpeedTimer;
     // start oscillation time
     SimTime startOscillating;
 
@@ -52,12 +54,16 @@ public:
         leaderSpeed = 0;
         nLanes = 0;
         changeSpeed = nullptr;
+        changeSpeedTimer = -1;
         startOscillating = SimTime(0);
     }
     virtual ~SinusoidalScenario();
+    virtual void resetForReuse();
 
 protected:
     virtual void handleSelfMsg(cMessage* msg);
+    // sets the desired speed of the leader for the current time
+    void updateDesiredSpeed();
 };
 
 } // namespace plexe
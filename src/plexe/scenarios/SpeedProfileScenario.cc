@@ -0,0 +1,85 @@
+//
+// Copyright (C) 2012-2021 Michele Segata <segata@ccs-labs.org>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include "plexe/scenarios/SpeedProfileScenario.h"
+
+namespace plexe {
+
+Define_Module(SpeedProfileScenario);
+
+void SpeedProfileScenario::initialize(int stage)
+{
+
+    BaseScenario::initialize(stage);
+
+    if (stage == 2) {
+        leaderSpeed = par("leaderSpeed").doubleValue() / 3.6;
+        followerDesiredSpeed = par("followerDesiredSpeed").doubleValue() / 3.6;
+
+        if (positionHelper->isLeader()) {
+            std::string type = par("profileType").stdstringValue();
+            SpeedProfilePlayer::ProfileType profileType;
+            if (type == "speed")
+                profileType = SpeedProfilePlayer::SPEED;
+            else if (type == "acceleration")
+                profileType = SpeedProfilePlayer::ACCELERATION;
+            else
+                throw cRuntimeError("Invalid profile type %s", type.c_str());
+
+            std::string unit = par("profileSpeedUnit").stdstringValue();
+            double scale;
+            if (unit == "mps")
+                scale = 1;
+            else if (unit == "kmph")
+                scale = 1 / 3.6;
+            else
+                throw cRuntimeError("Invalid profile speed unit %s", unit.c_str());
+            if (profileType == SpeedProfilePlayer::ACCELERATION) scale = 1;
+
+            SpeedProfilePlayer& player = SpeedProfilePlayer::getInstance();
+            const SpeedProfile* profile = player.loadProfile(par("profile").stdstringValue(), scale);
+            simtime_t start = std::max(simTime(), SimTime(par("profileStart").doubleValue()));
+            externalId = mobility->getExternalId();
+            player.addVehicle(plexeTraci, externalId, profile, profileType, start, par("loopProfile").boolValue());
+            playing = true;
+
+            // cruise at the base speed until the profile starts
+            plexeTraciVehicle->setCruiseControlDesiredSpeed(leaderSpeed);
+        }
+        else {
+            plexeTraciVehicle->setCruiseControlDesiredSpeed(followerDesiredSpeed);
+        }
+    }
+}
+
+SpeedProfileScenario::~SpeedProfileScenario()
+{
+    if (playing) SpeedProfilePlayer::getInstance().removeVehicle(externalId);
+}
+
+void SpeedProfileScenario::resetForReuse()
+{
+    if (playing) SpeedProfilePlayer::getInstance().removeVehicle(externalId);
+    playing = false;
+    externalId.clear();
+    BaseScenario::resetForReuse();
+}
+
+} // namespace plexe
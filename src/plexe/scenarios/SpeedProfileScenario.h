@@ -0,0 +1,65 @@
+//
+// Copyright (C) 2012-2021 Michele Segata <segata@ccs-labs.org>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#ifndef SPEEDPROFILESCENARIO_H_
+#define SPEEDPROFILESCENARIO_H_
+
+#include "plexe/scenarios/BaseScenario.h"
+#include "plexe/utilities/SpeedProfilePlayer.h"
+
+namespace plexe {
+
+/**
+ * Lets platoon leaders follow a speed or acceleration trace, e.g., a drive
+ * cycle such as WLTP or NEDC or a recorded log. The trace is played by the
+ * SpeedProfilePlayer, which updates all leaders with a single TraCI message
+ * per SUMO step
+ */
+class SpeedProfileScenario : public BaseScenario {
+
+public:
+    virtual void initialize(int stage) override;
+
+protected:
+    // leader speed before the profile starts
+    double leaderSpeed;
+    // desired speed of followers, which should be higher than any speed in
+    // the profile to let them stay connected to their leader
+    double followerDesiredSpeed;
+    // whether this vehicle is playing a profile
+    bool playing;
+    // SUMO id of the vehicle, kept as the mobility might be gone when the
+    // vehicle is removed from the player
+    std::string externalId;
+
+public:
+    SpeedProfileScenario()
+    {
+        leaderSpeed = 0;
+        followerDesiredSpeed = 0;
+        playing = false;
+    }
+    virtual ~SpeedProfileScenario();
+    virtual void resetForReuse() override;
+};
+
+} // namespace plexe
+
+#endif
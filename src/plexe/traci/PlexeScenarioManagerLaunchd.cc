@@ -0,0 +1,346 @@
+//
+// Copyright (C) 2012-2021 Michele Segata <segata@ccs-labs.org>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include "plexe/traci/PlexeScenarioManagerLaunchd.h"
+
+#include "plexe/PlexeManager.h"
+#include "plexe/mobility/CommandInterface.h"
+#include "plexe/utilities/PlatoonKpi.h"
+#include "plexe/utilities/RecyclableModule.h"
+
+#include <veins/modules/mobility/traci/TraCIMobility.h>
+
+namespace plexe {
+
+Define_Module(PlexeScenarioManagerLaunchd);
+
+PlexeScenarioManagerLaunchd::~PlexeScenarioManagerLaunchd()
+{
+    if (recycleModules) getEnvir()->removeLifecycleListener(this);
+}
+
+void PlexeScenarioManagerLaunchd::initialize(int stage)
+{
+    TraCIScenarioManagerLaunchd::initialize(stage);
+
+    if (stage != 1) return;
+
+    adaptiveUpdateInterval = par("adaptiveUpdateInterval").boolValue();
+    if (adaptiveUpdateInterval) {
+        activeUpdateInterval = updateInterval;
+        idleUpdateInterval = par("idleUpdateInterval");
+        activityHoldTime = par("activityHoldTime");
+        // idle steps must fall on the grid of SUMO steps
+        if (idleUpdateInterval < activeUpdateInterval || idleUpdateInterval.raw() % activeUpdateInterval.raw() != 0) throw cRuntimeError("idleUpdateInterval must be a multiple of updateInterval");
+        idleMode = false;
+        lastStep = -1;
+        lastActivity = simTime();
+        activeTime = 0;
+        idleTime = 0;
+        activeSteps = 0;
+        idleSteps = 0;
+        updateIntervalOut.setName("updateInterval");
+        updateIntervalOut.record(updateInterval);
+
+        auto maneuverEvent = [this](veins::SignalPayload<cObject*> payload) { onManeuverEvent(payload.p); };
+        signalManager.subscribeCallback(getSystemModule(), PlatoonKpi::maneuverEventSignal, maneuverEvent);
+        auto timestep = [this](veins::SignalPayload<simtime_t const&>) { adaptUpdateInterval(); };
+        signalManager.subscribeCallback(this, traciTimestepEndSignal, timestep);
+    }
+
+    recycleModules = par("recycleModules").boolValue();
+    maxPooledModules = par("maxPooledModules");
+    if (!recycleModules) return;
+
+    // the choice of equipped vehicles is done when building a new module
+    if (par("penetrationRate").doubleValue() < 1) throw cRuntimeError("Module recycling requires penetrationRate = 1");
+    pooledModules = 0;
+    recycledModules = 0;
+    unrecyclableModules = 0;
+    getEnvir()->addLifecycleListener(this);
+}
+
+void PlexeScenarioManagerLaunchd::finish()
+{
+    if (recycleModules) {
+        recordScalar("recycledModules", recycledModules);
+        recordScalar("unrecyclableModules", unrecyclableModules);
+    }
+    if (adaptiveUpdateInterval) {
+        recordScalar("activeTime", activeTime);
+        recordScalar("idleTime", idleTime);
+        recordScalar("activeSteps", activeSteps);
+        recordScalar("idleSteps", idleSteps);
+    }
+    TraCIScenarioManagerLaunchd::finish();
+}
+
+void PlexeScenarioManagerLaunchd::lifecycleEvent(SimulationLifecycleEventType eventType, cObject* details)
+{
+    // parked modules have already been finished when their vehicle left
+    if (eventType == LF_PRE_NETWORK_FINISH) clearPool();
+}
+
+void PlexeScenarioManagerLaunchd::removeVehicle(const std::string& nodeId)
+{
+    Enter_Method_Silent();
+    traci::CommandInterface* cifc = PlexeManager::get()->getCommandInterface();
+    // deferred commands for the vehicle would fail once it is gone
+    cifc->sendDeferredParameters();
+    cifc->vehicle(nodeId).remove();
+    // the arrival reported by the next step finds no module to delete
+    deleteManagedModule(nodeId);
+}
+
+void PlexeScenarioManagerLaunchd::onManeuverEvent(const cObject* obj)
+{
+    const ManeuverEvent* event = check_and_cast<const ManeuverEvent*>(obj);
+    switch (event->type) {
+    case ManeuverEvent::STARTED: {
+        maneuveringVehicles.insert(event->vehicleId);
+        break;
+    }
+    case ManeuverEvent::ENDED: {
+        maneuveringVehicles.erase(event->vehicleId);
+        break;
+    }
+    case ManeuverEvent::HAZARD: {
+        hazardVehicles.insert(event->vehicleId);
+        break;
+    }
+    case ManeuverEvent::HAZARD_CLEARED: {
+        hazardVehicles.erase(event->vehicleId);
+        break;
+    }
+    case ManeuverEvent::REMOVED: {
+        maneuveringVehicles.erase(event->vehicleId);
+        hazardVehicles.erase(event->vehicleId);
+        break;
+    }
+    default:
+        break;
+    }
+    if (idleMode && isActive()) expediteNextStep();
+}
+
+bool PlexeScenarioManagerLaunchd::isActive() const
+{
+    if (!maneuveringVehicles.empty() || !hazardVehicles.empty()) return true;
+    // lane changes are processed one lane per step
+    PlexeManager* plexeManager = PlexeManager::get();
+    return plexeManager && plexeManager->getCommandInterface() && plexeManager->getCommandInterface()->hasPendingLaneChanges();
+}
+
+void PlexeScenarioManagerLaunchd::adaptUpdateInterval()
+{
+    // called at the end of each step, before the next one is scheduled
+    if (lastStep >= 0) {
+        if (idleMode) {
+            idleTime += simTime() - lastStep;
+            idleSteps++;
+        }
+        else {
+            activeTime += simTime() - lastStep;
+            activeSteps++;
+        }
+    }
+    lastStep = simTime();
+
+    bool idle;
+    if (isActive()) {
+        lastActivity = simTime();
+        idle = false;
+    }
+    else {
+        idle = simTime() - lastActivity >= activityHoldTime;
+    }
+    if (idle == idleMode) return;
+
+    idleMode = idle;
+    updateInterval = idleMode ? idleUpdateInterval : activeUpdateInterval;
+    updateIntervalOut.record(updateInterval);
+}
+
+void PlexeScenarioManagerLaunchd::expediteNextStep()
+{
+    Enter_Method_Silent();
+    idleMode = false;
+    lastActivity = simTime();
+    updateInterval = activeUpdateInterval;
+    updateIntervalOut.record(updateInterval);
+
+    // during a step, the next one is scheduled with the new interval
+    if (!executeOneTimestepTrigger->isScheduled()) return;
+
+    // the first step after the last one which is not in the past
+    simtime_t next = lastStep + activeUpdateInterval;
+    if (next < simTime()) {
+        int64_t steps = ((simTime() - next).raw() + activeUpdateInterval.raw() - 1) / activeUpdateInterval.raw();
+        next += activeUpdateInterval * steps;
+    }
+    if (next >= executeOneTimestepTrigger->getArrivalTime()) return;
+    cancelEvent(executeOneTimestepTrigger);
+    scheduleAt(next, executeOneTimestepTrigger);
+}
+
+void PlexeScenarioManagerLaunchd::addModule(std::string nodeId, std::string type, std::string name, std::string displayString, const veins::Coord& position, std::string road_id, double speed, veins::Heading heading, veins::VehicleSignalSet signals, double length, double height, double width)
+{
+    auto parked = pool.find(type + "/" + name);
+    if (!recycleModules || parked == pool.end() || parked->second.empty()) {
+        TraCIScenarioManagerLaunchd::addModule(nodeId, type, name, displayString, position, road_id, speed, heading, signals, length, height, width);
+        return;
+    }
+
+    if (hosts.find(nodeId) != hosts.end()) throw cRuntimeError("tried adding duplicate module");
+
+    ParkedModule reused = parked->second.back();
+    parked->second.pop_back();
+    pooledModules--;
+    recycledModules++;
+    cModule* mod = reused.module;
+
+    // the mobility module is bound to the SUMO vehicle, so build a new one
+    cModule* mobility = reused.mobilityType->create(reused.mobilityName.c_str(), mod);
+    mobility->finalizeParameters();
+    mobility->buildInside();
+    mobility->scheduleStart(simTime());
+
+    preInitializeModule(mod, nodeId, position, road_id, speed, heading, signals);
+    emit(traciModulePreInitSignal, mod);
+
+    // initialize all submodules again, stage by stage
+    for (int stage = 0;; stage++) {
+        bool moreStages = false;
+        for (cModule::SubmoduleIterator it(mod); !it.end(); ++it) {
+            if ((*it)->callInitialize(stage)) moreStages = true;
+        }
+        if (!moreStages) break;
+    }
+
+    hosts[nodeId] = mod;
+    check_and_cast<veins::TraCIMobility*>(mobility)->changePosition();
+    emit(traciModuleAddedSignal, mod);
+}
+
+void PlexeScenarioManagerLaunchd::deleteManagedModule(std::string nodeId)
+{
+    cModule* mod = getManagedModule(nodeId);
+    if (recycleModules && mod && !isRecyclable(mod)) {
+        unrecyclableModules++;
+        if (unrecyclableModules == 1) EV_WARN << "module " << mod->getFullPath() << " cannot be recycled. PlatoonCar modules require usePerRadio = true\n";
+    }
+    if (!recycleModules || !mod || pooledModules >= maxPooledModules || !isRecyclable(mod)) {
+        TraCIScenarioManagerLaunchd::deleteManagedModule(nodeId);
+        return;
+    }
+
+    emit(traciModuleRemovedSignal, mod);
+    hosts.erase(nodeId);
+    mod->callFinish();
+    park(mod);
+}
+
+bool PlexeScenarioManagerLaunchd::isRecyclable(cModule* mod) const
+{
+    int mobilityModules = 0;
+    for (cModule::SubmoduleIterator it(mod); !it.end(); ++it) {
+        cModule* submodule = *it;
+        if (dynamic_cast<veins::TraCIMobility*>(submodule))
+            mobilityModules++;
+        else if (!submodule->isSimple() || !dynamic_cast<RecyclableModule*>(submodule))
+            return false;
+    }
+    return mobilityModules == 1;
+}
+
+void PlexeScenarioManagerLaunchd::park(cModule* mod)
+{
+    cancelPendingEvents(mod);
+    unsubscribeSubmodules(mod);
+
+    cModule* mobility = nullptr;
+    for (cModule::SubmoduleIterator it(mod); !it.end(); ++it) {
+        RecyclableModule* recyclable = dynamic_cast<RecyclableModule*>(*it);
+        if (recyclable) {
+            cContextSwitcher context(*it);
+            recyclable->resetForReuse();
+        }
+        else {
+            mobility = *it;
+        }
+    }
+    ASSERT(mobility);
+
+    ParkedModule parked;
+    parked.module = mod;
+    parked.mobilityType = mobility->getModuleType();
+    parked.mobilityName = mobility->getName();
+    mobility->deleteModule();
+
+    pool[std::string(mod->getModuleType()->getFullName()) + "/" + mod->getName()].push_back(parked);
+    pooledModules++;
+}
+
+void PlexeScenarioManagerLaunchd::cancelPendingEvents(cModule* mod)
+{
+    // collect the events first, as removing them reorders the event set
+    cFutureEventSet* fes = getSimulation()->getFES();
+    std::vector<cMessage*> events;
+    for (int i = 0; i < fes->getLength(); i++) {
+        cMessage* msg = dynamic_cast<cMessage*>(fes->get(i));
+        if (msg && msg->getArrivalModule() && msg->getArrivalModule()->getParentModule() == mod) events.push_back(msg);
+    }
+    for (cMessage* msg : events) {
+        if (msg->isSelfMessage()) {
+            // timers are freed by the modules owning them
+            check_and_cast<cSimpleModule*>(msg->getArrivalModule())->cancelEvent(msg);
+        }
+        else {
+            // frames travelling towards the vehicle
+            delete fes->remove(msg);
+        }
+    }
+}
+
+void PlexeScenarioManagerLaunchd::unsubscribeSubmodules(cModule* mod)
+{
+    std::vector<cComponent*> sources = {mod};
+    for (cModule::SubmoduleIterator it(mod); !it.end(); ++it) sources.push_back(*it);
+
+    for (cComponent* source : sources) {
+        for (simsignal_t signal : source->getLocalListenedSignals()) {
+            for (cIListener* listener : source->getLocalSignalListeners(signal)) {
+                cModule* subscriber = dynamic_cast<cModule*>(listener);
+                if (subscriber && subscriber->getParentModule() == mod) source->unsubscribe(signal, listener);
+            }
+        }
+    }
+}
+
+void PlexeScenarioManagerLaunchd::clearPool()
+{
+    for (auto& modules : pool) {
+        for (ParkedModule& parked : modules.second) parked.module->deleteModule();
+    }
+    pool.clear();
+    pooledModules = 0;
+}
+
+} // namespace plexe
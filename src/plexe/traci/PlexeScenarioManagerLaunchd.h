@@ -0,0 +1,159 @@
+//
+// Copyright (C) 2012-2021 Michele Segata <segata@ccs-labs.org>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#pragma once
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "plexe/plexe.h"
+
+#include <veins/modules/mobility/traci/TraCIScenarioManagerLaunchd.h>
+#include <veins/modules/utility/SignalManager.h>
+
+namespace plexe {
+
+/**
+ * Scenario manager that can recycle vehicle modules. When recycling is
+ * enabled, a vehicle leaving the simulation is not destroyed but parked,
+ * provided that all its submodules implement the RecyclableModule
+ * interface (the mobility module excluded). When a new vehicle of the same
+ * module type enters the simulation, a parked module is initialized again
+ * instead of building a new one, saving the construction of the whole
+ * compound module. Only the mobility module is rebuilt, as it is bound to
+ * the SUMO vehicle.
+ *
+ * Vehicles using the Veins 802.11p NIC are never recycled, as the NIC
+ * modules cannot be reset. Use the PER radio driver (usePerRadio) to enable
+ * recycling of PlatoonCar modules. A warning is logged for the first
+ * vehicle that cannot be recycled, and their number is recorded as the
+ * unrecyclableModules scalar. Recycling cannot be used together with
+ * vehicle obstacle shadowing. Note that the results of a recycled module are
+ * recorded under the same module path for every vehicle it hosted.
+ *
+ * The manager can also adapt the interval between two TraCI steps to the
+ * activity of the vehicles (adaptiveUpdateInterval). SUMO is synchronized
+ * every updateInterval while a vehicle is in a maneuver, a hazard is
+ * signaled or a lane change is being performed by the CommandInterface, and
+ * every idleUpdateInterval otherwise. SUMO keeps simulating with its own
+ * step length in between, but it only receives commands and reports
+ * positions at each synchronization, so idle phases are less accurate:
+ * CACCs are fed with beacon data up to idleUpdateInterval late, which adds
+ * to the communication delay seen by the controllers, and beacons and
+ * radio distances use positions and speeds up to idleUpdateInterval old.
+ * Results that depend on these delays, e.g., string stability metrics, can
+ * thus differ from a run with a fixed interval. Activity is tracked through
+ * the maneuver events of GeneralPlatooningApp (see
+ * PlatoonKpi::maneuverEventSignal).
+ */
+class PlexeScenarioManagerLaunchd : public veins::TraCIScenarioManagerLaunchd, public cISimulationLifecycleListener {
+
+public:
+    PlexeScenarioManagerLaunchd()
+        : recycleModules(false)
+        , maxPooledModules(0)
+        , pooledModules(0)
+        , recycledModules(0)
+        , unrecyclableModules(0)
+        , adaptiveUpdateInterval(false)
+        , idleMode(false)
+    {
+    }
+    virtual ~PlexeScenarioManagerLaunchd();
+
+    virtual void initialize(int stage) override;
+    virtual void finish() override;
+
+    virtual void lifecycleEvent(SimulationLifecycleEventType eventType, cObject* details) override;
+
+    /**
+     * Removes a vehicle from SUMO and deletes (or parks) its module right
+     * away, instead of waiting for the next step to report it as arrived
+     */
+    void removeVehicle(const std::string& nodeId);
+
+protected:
+    virtual void addModule(std::string nodeId, std::string type, std::string name, std::string displayString, const veins::Coord& position, std::string road_id = "", double speed = -1, veins::Heading heading = veins::Heading::nan, veins::VehicleSignalSet signals = {veins::VehicleSignal::undefined}, double length = 0, double height = 0, double width = 0) override;
+    virtual void deleteManagedModule(std::string nodeId) override;
+
+    // returns true if all submodules of the vehicle can be reset
+    bool isRecyclable(cModule* mod) const;
+    // resets a vehicle which left the simulation and stores it in the pool
+    void park(cModule* mod);
+    // removes all events directed to the submodules of a vehicle
+    void cancelPendingEvents(cModule* mod);
+    // unsubscribes the submodules of a vehicle from the signals of the vehicle
+    void unsubscribeSubmodules(cModule* mod);
+    // deletes all parked modules
+    void clearPool();
+
+    // tracks the vehicles in a maneuver and the signaled hazards
+    void onManeuverEvent(const cObject* obj);
+    // returns true if SUMO must be synchronized every updateInterval
+    bool isActive() const;
+    // chooses the interval until the next step, called at the end of a step
+    void adaptUpdateInterval();
+    // moves the next step to the next multiple of updateInterval
+    void expediteNextStep();
+
+    // a parked vehicle and the type of the mobility module to build for it
+    typedef struct {
+        cModule* module;
+        cModuleType* mobilityType;
+        std::string mobilityName;
+    } ParkedModule;
+
+    bool recycleModules;
+    int maxPooledModules;
+
+    // parked modules, by module type and name
+    std::map<std::string, std::vector<ParkedModule>> pool;
+    int pooledModules;
+
+    // statistics
+    long recycledModules;
+    // vehicles destroyed because some of their submodules cannot be reset
+    long unrecyclableModules;
+
+    bool adaptiveUpdateInterval;
+    // intervals between two steps during activity and when idle
+    simtime_t activeUpdateInterval;
+    simtime_t idleUpdateInterval;
+    // how long to keep the active interval after the last activity
+    simtime_t activityHoldTime;
+    bool idleMode;
+    simtime_t lastStep;
+    simtime_t lastActivity;
+    // vehicles in a maneuver and leaders signaling a hazard, by vehicle id
+    std::set<int> maneuveringVehicles;
+    std::set<int> hazardVehicles;
+    veins::SignalManager signalManager;
+
+    // statistics
+    cOutVector updateIntervalOut;
+    simtime_t activeTime;
+    simtime_t idleTime;
+    long activeSteps;
+    long idleSteps;
+};
+
+} // namespace plexe
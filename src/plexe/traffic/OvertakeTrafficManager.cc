@@ -30,6 +30,8 @@ void OvertakeTrafficManager::initialize(int stage)
     PlatoonsTrafficManager::initialize(stage);
 
     if (stage == 0) {
+        nOvertakers = par("nOvertakers").intValue();
+        overtakerInsertInterval = SimTime(par("overtakerInsertInterval").doubleValue());
         insertOvertakerMessage = new cMessage("");
         scheduleAt(platoonInsertTime + SimTime(5), insertOvertakerMessage);
     }
@@ -41,16 +43,26 @@ void OvertakeTrafficManager::handleSelfMsg(cMessage* msg)
 
     if (msg == insertOvertakerMessage) {
         insertOvertaker();
+        insertedOvertakers++;
+        if (!insertionControlled && insertedOvertakers < nOvertakers) scheduleAt(simTime() + overtakerInsertInterval, insertOvertakerMessage);
     }
 }
 
 void OvertakeTrafficManager::insertOvertaker()
 {
+    Enter_Method_Silent();
     automated.position = 0;
     automated.lane = 0;
     addVehicleToQueue(0, automated);
 }
 
+void OvertakeTrafficManager::controlOvertakerInsertion()
+{
+    Enter_Method_Silent();
+    insertionControlled = true;
+    if (insertedOvertakers > 0 && insertOvertakerMessage->isScheduled()) cancelEvent(insertOvertakerMessage);
+}
+
 OvertakeTrafficManager::~OvertakeTrafficManager()
 {
     cancelAndDelete(insertOvertakerMessage);
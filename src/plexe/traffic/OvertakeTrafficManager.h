@@ -34,13 +34,36 @@ public:
         : PlatoonsTrafficManager()
     {
         insertOvertakerMessage = 0;
+        nOvertakers = 0;
+        insertedOvertakers = 0;
+        insertionControlled = false;
     }
     virtual ~OvertakeTrafficManager();
 
+    /**
+     * Inserts a new overtaker at the beginning of the road, behind the
+     * platoons. Can be called by other modules, e.g., by scenarios running
+     * several overtake trials in the same simulation
+     */
+    void insertOvertaker();
+
+    /**
+     * Stops inserting overtakers after the first one, leaving further
+     * insertions to the caller of insertOvertaker()
+     */
+    void controlOvertakerInsertion();
+
 protected:
     cMessage* insertOvertakerMessage;
 
-    void insertOvertaker();
+    // number of overtakers to insert
+    int nOvertakers;
+    // number of overtakers inserted so far
+    int insertedOvertakers;
+    // time between the insertion of two overtakers
+    SimTime overtakerInsertInterval;
+    // whether overtakers after the first are inserted by another module
+    bool insertionControlled;
 
     void insertHumans();
 
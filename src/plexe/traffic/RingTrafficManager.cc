@@ -37,6 +37,12 @@ void RingTrafficManager::initialize(int stage)
     platoonInsertHeadway = par("platoonInsertHeadway").doubleValue();
     platoonLeaderHeadway = par("platoonLeaderHeadway").doubleValue();
     platooningVType = par("platooningVType").stdstringValue();
+
+    if (stage == 0) {
+        visitorInsertInterval = SimTime(par("visitorInsertInterval").doubleValue());
+        visitorLane = par("visitorLane");
+        insertVisitorMessage = new cMessage("insertVisitor");
+    }
 }
 
 void RingTrafficManager::scenarioLoaded()
@@ -100,6 +106,38 @@ void RingTrafficManager::scenarioLoaded()
             injectedPlatoons++;
         }
     }
+
+    if (visitorInsertInterval > 0) scheduleAt(simTime() + visitorInsertInterval, insertVisitorMessage);
+}
+
+void RingTrafficManager::handleSelfMsg(cMessage* msg)
+{
+
+    TraCIBaseTrafficManager::handleSelfMsg(msg);
+
+    if (msg == insertVisitorMessage) {
+        insertVisitor();
+        scheduleAt(simTime() + visitorInsertInterval, insertVisitorMessage);
+    }
+}
+
+void RingTrafficManager::insertVisitor()
+{
+    struct Vehicle visitor;
+    visitor.id = findVehicleTypeIndex("vtypeauto");
+    visitor.lane = visitorLane;
+    visitor.position = 0;
+    visitor.speed = platoonInsertSpeed->doubleValue() / 3.6;
+    addVehicleToQueue(0, visitor);
+    positions.addVehicleToPlatoon(injectedCars, 0, injectedPlatoons);
+    injectedCars++;
+    injectedPlatoons++;
+}
+
+RingTrafficManager::~RingTrafficManager()
+{
+    cancelAndDelete(insertVisitorMessage);
+    insertVisitorMessage = nullptr;
 }
 
 } // namespace plexe
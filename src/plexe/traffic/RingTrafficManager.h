@@ -33,18 +33,27 @@ public:
     virtual void initialize(int stage);
     virtual void scenarioLoaded();
 
+    /** number of platoons inserted at the beginning of the simulation */
+    int getPlatoonCount() const
+    {
+        return nPlatoons;
+    }
+
     RingTrafficManager()
         : platoonSize(0)
         , nPlatoons(0)
         , injectedCars(0)
         , injectedPlatoons(0)
+        , insertVisitorMessage(nullptr)
     {
         platoonInsertDistance = 0;
         platoonInsertHeadway = 0;
         platoonInsertSpeed = 0;
         platoonLeaderHeadway = 0;
         nLanes = 0;
+        visitorLane = 0;
     }
+    virtual ~RingTrafficManager();
 
 protected:
     cPar* platoonSize;
@@ -62,6 +71,17 @@ protected:
     // sumo vehicle type of platooning cars
     std::string platooningVType;
     cPar* platoonInsertSpeed;
+    // time between the insertion of two vehicles driving alone. 0 disables
+    // the insertion
+    SimTime visitorInsertInterval;
+    // lane where vehicles driving alone are inserted
+    int visitorLane;
+    cMessage* insertVisitorMessage;
+
+    // inserts a vehicle driving alone, as a platoon of its own
+    void insertVisitor();
+
+    virtual void handleSelfMsg(cMessage* msg);
 
     typedef struct {
         int size;
@@ -22,6 +22,8 @@
 
 #include <iostream>
 
+#include "veins/modules/mobility/traci/TraCIScenarioManager.h"
+
 using namespace veins;
 
 namespace plexe {
@@ -48,12 +50,14 @@ void BasePositionHelper::initialize(int stage)
         traci = mobility->getCommandInterface();
         traciVehicle = mobility->getVehicleCommandInterface();
         myId = getIdFromExternalId(getExternalId());
+        // coloring is only useful when SUMO has a graphical user interface
+        colorVehicles = !mobility->getManager()->par("ignoreGuiCommands").boolValue();
     }
 
     if (stage == 1) {
-        formation = positions.getPlatoonFormation(myId);
-        position = positions.getPosition(myId);
         platoonId = positions.getPlatoonId(myId);
+        formation = positions.getSharedFormation(platoonId, positions.getPlatoonFormation(myId));
+        position = positions.getPosition(myId);
         PlatoonInfo info = positions.getPlatoonInformation(platoonId);
         platoonSpeed = info.speed;
         platoonLane = info.lane;
@@ -73,20 +77,31 @@ int BasePositionHelper::numInitStages() const
     return 2;
 }
 
+void BasePositionHelper::resetForReuse()
+{
+    leaderId = INVALID_PLATOON_ID;
+    frontId = INVALID_PLATOON_ID;
+    backId = INVALID_PLATOON_ID;
+    formationVersion = 0;
+    formation = std::make_shared<const PlatoonFormation>(std::vector<int>());
+    coloredPlatoonId = INVALID_PLATOON_ID;
+}
+
 void BasePositionHelper::setVariablesAfterFormationChange()
 {
-    memberToPosition.clear();
-    for (int i = 0; i < formation.size(); i++)
-        memberToPosition[formation[i]] = i;
     position = getMemberPosition(myId);
-    leaderId = formation[0];
-    frontId = isLeader() ? -1 : formation[position - 1];
-    backId = isLast() ? -1 : formation[position + 1];
+    leaderId = formation->getMemberId(0);
+    frontId = isLeader() ? -1 : formation->getMemberId(position - 1);
+    backId = isLast() ? -1 : formation->getMemberId(position + 1);
     colorVehicle();
 }
 
 void BasePositionHelper::colorVehicle()
 {
+    // the color only depends on the platoon, so there is no need to set it
+    // again when only the formation changes
+    if (!colorVehicles || platoonId == coloredPlatoonId) return;
+    coloredPlatoonId = platoonId;
     if (platoonId == -1)
         traciVehicle->setColor(veins::TraCIColor::fromTkColor("white"));
     else
@@ -120,7 +135,7 @@ bool BasePositionHelper::isLeader() const
 
 bool BasePositionHelper::isLast() const
 {
-    return position == formation.size() - 1;
+    return position == formation->size() - 1;
 }
 
 int BasePositionHelper::getFrontId() const
@@ -138,19 +153,12 @@ int BasePositionHelper::getBackId() const
 
 int BasePositionHelper::getMemberId(const int position) const
 {
-    if (position < formation.size())
-        return formation[position];
-    else
-        return -1;
+    return formation->getMemberId(position);
 }
 
 int BasePositionHelper::getMemberPosition(const int vehicleId) const
 {
-    auto i = memberToPosition.find(vehicleId);
-    if (i == memberToPosition.end())
-        return -1;
-    else
-        return i->second;
+    return formation->getPosition(vehicleId);
 }
 
 int BasePositionHelper::getPlatoonId() const
@@ -175,7 +183,7 @@ bool BasePositionHelper::isInSamePlatoon(const int vehicleId) const
 
 int BasePositionHelper::getPlatoonSize() const
 {
-    return formation.size();
+    return formation->size();
 }
 
 void BasePositionHelper::setId(const int id)
@@ -185,6 +193,8 @@ void BasePositionHelper::setId(const int id)
 
 void BasePositionHelper::setPlatoonId(const int id)
 {
+    // formation versions are meaningful within a platoon only
+    if (id != platoonId) formationVersion = 0;
     platoonId = id;
     colorVehicle();
 }
@@ -201,12 +211,14 @@ void BasePositionHelper::setPlatoonSpeed(double speed)
 
 const std::vector<int>& BasePositionHelper::getPlatoonFormation() const
 {
-    return formation;
+    return formation->getMembers();
 }
 
 void BasePositionHelper::setPlatoonFormation(const std::vector<int>& formation)
 {
-    this->formation = formation;
+    // members of the same platoon share the formation object, which is
+    // built only by the first of them
+    this->formation = positions.getSharedFormation(platoonId, formation);
     setVariablesAfterFormationChange();
 }
 
@@ -219,9 +231,9 @@ void BasePositionHelper::dumpVehicleData() const
     std::cout << "\tBack ID         : " << backId << "\n";
     std::cout << "\tPlatoon speed   : " << platoonSpeed << " (m/s)\n";
     std::cout << "\tPlatoon lane    : " << platoonLane << "\n";
-    std::cout << "\tPlatoon size    : " << formation.size() << "\n";
+    std::cout << "\tPlatoon size    : " << formation->size() << "\n";
     std::cout << "\tStored formation: ";
-    for (auto& v : formation)
+    for (auto& v : formation->getMembers())
         std::cout << v << " ";
     std::cout << "\n";
 }
@@ -22,6 +22,7 @@
 #define BASEPOSITIONHELPER_H_
 
 #include "plexe/utilities/DynamicPositionManager.h"
+#include "plexe/utilities/RecyclableModule.h"
 #include <string>
 #include "veins/modules/mobility/traci/TraCIMobility.h"
 
@@ -29,12 +30,15 @@
 
 namespace plexe {
 
-class BasePositionHelper : public cSimpleModule {
+class BasePositionHelper : public cSimpleModule, public RecyclableModule {
 
 public:
     virtual void initialize(int stage) override;
     virtual int numInitStages() const override;
 
+    /** override from RecyclableModule */
+    virtual void resetForReuse() override;
+
     /**
      * Returns the traci external id of this car
      */
@@ -145,6 +149,23 @@ public:
      */
     virtual void setPlatoonFormation(const std::vector<int>& formation);
 
+    /**
+     * Returns the version of the formation, as assigned by the leader
+     * when disseminating it. 0 means unversioned
+     */
+    virtual int getFormationVersion() const
+    {
+        return formationVersion;
+    }
+
+    /**
+     * Sets the version of the formation
+     */
+    virtual void setFormationVersion(int version)
+    {
+        formationVersion = version;
+    }
+
     /**
      * Writes a dump of the variables of this vehicle for debug purposes
      */
@@ -171,16 +192,20 @@ protected:
     int platoonLane;
     // speed of the platoon
     double platoonSpeed;
+    // version of the formation
+    int formationVersion;
 
     /** Stores the IDs of vehicles currently in the platoon.
-     * The values' order corresponds to that of the platoon.
+     * The values' order corresponds to that of the platoon. The object is
+     * shared with the other members having the same view of the platoon,
+     * and it also maps the IDs of the vehicles to their position.
      */
-    std::vector<int> formation;
+    std::shared_ptr<const PlatoonFormation> formation;
 
-    /** Maps the IDs of the vehicles to their position in the formation.
-     * This is useful to search for members without going through the complete formation vector.
-     */
-    std::map<int, int> memberToPosition;
+    // whether to color vehicles depending on their platoon
+    bool colorVehicles;
+    // platoon id the vehicle has been colored for
+    int coloredPlatoonId;
 
     // used to retrieve the initial formation setup
     DynamicPositionManager& positions;
@@ -202,6 +227,10 @@ public:
         , platoonId(INVALID_PLATOON_ID)
         , platoonLane(-1)
         , platoonSpeed(-1)
+        , formationVersion(0)
+        , formation(std::make_shared<const PlatoonFormation>(std::vector<int>()))
+        , colorVehicles(true)
+        , coloredPlatoonId(INVALID_PLATOON_ID)
         , positions(DynamicPositionManager::getInstance())
     {
     }
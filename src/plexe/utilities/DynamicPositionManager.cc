@@ -57,6 +57,15 @@ void DynamicPositionManager::removeVehicleFromPlatoon(const int vehicleId)
     }
 }
 
+void DynamicPositionManager::removePlatoon(const int platoonId)
+{
+    platoons.erase(platoonId);
+    positions.erase(platoonId);
+    information.erase(platoonId);
+    sharedFormations.erase(platoonId);
+    // formation versions are kept in case the platoon id is used again
+}
+
 void DynamicPositionManager::printPlatoons()
 {
     for (auto i = platoons.begin(); i != platoons.end(); i++) {
@@ -123,4 +132,26 @@ int DynamicPositionManager::getMemberId(int platoonId, int position) const
     return platoons.find(platoonId)->second.find(position)->second;
 }
 
+std::shared_ptr<const PlatoonFormation> DynamicPositionManager::getSharedFormation(int platoonId, const std::vector<int>& members)
+{
+    std::shared_ptr<const PlatoonFormation>& formation = sharedFormations[platoonId];
+    if (!formation || formation->getMembers() != members) formation = std::make_shared<const PlatoonFormation>(members);
+    return formation;
+}
+
+int DynamicPositionManager::nextFormationVersion(int platoonId)
+{
+    return ++formationVersions[platoonId];
+}
+
+void DynamicPositionManager::clear()
+{
+    platoons.clear();
+    positions.clear();
+    vehToPlatoons.clear();
+    information.clear();
+    sharedFormations.clear();
+    formationVersions.clear();
+}
+
 } // namespace plexe
@@ -22,8 +22,11 @@
 #define DYNAMICPOSITIONMANAGER_H_
 
 #include <map>
+#include <memory>
 #include <vector>
 
+#include "plexe/utilities/PlatoonFormation.h"
+
 namespace plexe {
 
 // platoon information
@@ -46,6 +49,10 @@ class DynamicPositionManager {
     typedef std::map<int, Position> Positions;
     // map from platoon id to information
     typedef std::map<int, PlatoonInfo> PlatoonInformation;
+    // map from platoon id to the last formation shared by its members
+    typedef std::map<int, std::shared_ptr<const PlatoonFormation>> SharedFormations;
+    // map from platoon id to the last formation version it used
+    typedef std::map<int, int> FormationVersions;
 
 public:
     void addVehicleToPlatoon(const int vehicleId, const int position, const int platoonId);
@@ -54,6 +61,8 @@ public:
     {
         removeVehicleFromPlatoon(vehicleId);
     }
+    /** forgets a platoon that no longer exists, e.g., whose members left */
+    void removePlatoon(const int platoonId);
     void printPlatoons();
     void setPlatoonInformation(int platoonId, const PlatoonInfo& info);
     PlatoonInfo getPlatoonInformation(int platoonId) const;
@@ -62,6 +71,23 @@ public:
     int getPosition(int vehicleId) const;
     int getMemberId(int platoonId, const int position) const;
 
+    /**
+     * Returns a formation object with the given members. Vehicles of the
+     * same platoon setting the same formation get the same object, so that
+     * the formation is built only once per update instead of once per member
+     */
+    std::shared_ptr<const PlatoonFormation> getSharedFormation(int platoonId, const std::vector<int>& members);
+
+    /**
+     * Returns a new formation version for the given platoon. Versions keep
+     * increasing when the platoon changes leader or is removed, so that
+     * members never mistake an old formation for the current one
+     */
+    int nextFormationVersion(int platoonId);
+
+    /** forgets all platoons and formation versions, e.g., when a new run starts */
+    void clear();
+
     static DynamicPositionManager& getInstance();
 
 private:
@@ -74,6 +100,8 @@ public:
     Positions positions;
     VehicleToPlatoon vehToPlatoons;
     PlatoonInformation information;
+    SharedFormations sharedFormations;
+    FormationVersions formationVersions;
 };
 
 } // namespace plexe
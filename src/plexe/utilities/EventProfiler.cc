@@ -0,0 +1,112 @@
+//
+// Copyright (C) 2012-2021 Michele Segata <segata@ccs-labs.org>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include "plexe/utilities/EventProfiler.h"
+
+#include <algorithm>
+#include <map>
+
+using namespace omnetpp;
+
+namespace plexe {
+
+EventProfiler& EventProfiler::getInstance()
+{
+    static EventProfiler instance;
+    return instance;
+}
+
+EventProfiler::Scope::Scope(const cObject* module, const char* handler, const cMessage* msg)
+    : active(EventProfiler::getInstance().isEnabled())
+    , parent(nullptr)
+{
+    if (!active) return;
+    open(std::string(module->getClassName()) + ";" + handler + ";" + EventProfiler::getEventName(msg));
+}
+
+EventProfiler::Scope::Scope(const cObject* module, const char* handler, const char* event)
+    : active(EventProfiler::getInstance().isEnabled())
+    , parent(nullptr)
+{
+    if (!active) return;
+    open(std::string(module->getClassName()) + ";" + handler + ";" + (event ? event : "unknown"));
+}
+
+void EventProfiler::Scope::open(std::string event)
+{
+    EventProfiler& profiler = EventProfiler::getInstance();
+    parent = profiler.current;
+    key = parent ? parent->key + ";" + event : event;
+    children = Clock::duration::zero();
+    profiler.current = this;
+    start = Clock::now();
+}
+
+EventProfiler::Scope::~Scope()
+{
+    if (!active) return;
+    Clock::duration elapsed = Clock::now() - start;
+    EventProfiler& profiler = EventProfiler::getInstance();
+    profiler.current = parent;
+    if (parent) parent->children += elapsed;
+    profiler.record(key, elapsed - children);
+}
+
+void EventProfiler::record(const std::string& key, Clock::duration elapsed)
+{
+    Sample& sample = samples[key];
+    sample.count++;
+    sample.time += elapsed;
+}
+
+std::string EventProfiler::getEventName(const cMessage* msg)
+{
+    const cObject* obj = msg;
+    if (msg->isPacket()) {
+        const cPacket* enc = static_cast<const cPacket*>(msg)->getEncapsulatedPacket();
+        if (enc) obj = enc;
+    }
+    const char* name = obj->getName();
+    std::string event = (name && name[0]) ? name : obj->getClassName();
+    // ';' and ' ' are separators in the folded stack format
+    std::replace(event.begin(), event.end(), ';', '_');
+    std::replace(event.begin(), event.end(), ' ', '_');
+    return event;
+}
+
+void EventProfiler::writeTimes(std::ostream& out) const
+{
+    // sort keys so that outputs of different runs can be diffed
+    std::map<std::string, Sample> sorted(samples.begin(), samples.end());
+    for (const auto& sample : sorted) {
+        long us = std::chrono::duration_cast<std::chrono::microseconds>(sample.second.time).count();
+        out << sample.first << " " << us << "\n";
+    }
+}
+
+void EventProfiler::writeCounts(std::ostream& out) const
+{
+    std::map<std::string, Sample> sorted(samples.begin(), samples.end());
+    for (const auto& sample : sorted) {
+        out << sample.first << " " << sample.second.count << "\n";
+    }
+}
+
+} // namespace plexe
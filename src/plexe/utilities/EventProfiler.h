@@ -0,0 +1,137 @@
+//
+// Copyright (C) 2012-2021 Michele Segata <segata@ccs-labs.org>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#ifndef EVENTPROFILER_H_
+#define EVENTPROFILER_H_
+
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+
+#include "plexe/plexe.h"
+
+namespace plexe {
+
+/**
+ * Accumulates the number of events and the wall clock time spent by Plexe
+ * modules in their event handlers. Samples are keyed by module class,
+ * handler and event (message name, encapsulated packet type or signal name)
+ * and can be written in the folded stack format used by flame graph tools.
+ * Scopes opened while another one is active, e.g., a signal emitted while
+ * handling a message, are keyed below the enclosing scope, and each scope
+ * only records the time not spent in its children, so that the times of
+ * all keys add up to the profiled wall clock time. When disabled, the cost
+ * of a profiled handler is a single branch.
+ */
+class EventProfiler {
+
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    // accumulated statistics for a single module/handler/event triple
+    typedef struct {
+        unsigned long count;
+        Clock::duration time;
+    } Sample;
+
+    /**
+     * RAII helper measuring the time spent within its scope. Use it
+     * through the PROFILE_EVENT and PROFILE_SIGNAL macros
+     */
+    class Scope {
+    public:
+        Scope(const omnetpp::cObject* module, const char* handler, const omnetpp::cMessage* msg);
+        Scope(const omnetpp::cObject* module, const char* handler, const char* event);
+        ~Scope();
+
+    private:
+        void open(std::string event);
+
+        bool active;
+        std::string key;
+        Clock::time_point start;
+        // enclosing scope, if any, and time spent in nested scopes
+        Scope* parent;
+        Clock::duration children;
+    };
+
+    static EventProfiler& getInstance();
+
+    void setEnabled(bool enabled)
+    {
+        this->enabled = enabled;
+    }
+    bool isEnabled() const
+    {
+        return enabled;
+    }
+
+    /**
+     * Adds a sample for the given folded stack key
+     */
+    void record(const std::string& key, Clock::duration elapsed);
+
+    /**
+     * Writes one line per key in folded stack format, weighted by the wall
+     * clock time in microseconds spent in the key outside nested scopes
+     */
+    void writeTimes(std::ostream& out) const;
+
+    /**
+     * Writes one line per key in folded stack format, weighted by number
+     * of events
+     */
+    void writeCounts(std::ostream& out) const;
+
+    /**
+     * Removes all samples collected so far
+     */
+    void clear()
+    {
+        samples.clear();
+    }
+
+    /**
+     * Returns a human readable name for the event carried by a message:
+     * the name of the message itself or, for frames, the name or type of
+     * the encapsulated packet
+     */
+    static std::string getEventName(const omnetpp::cMessage* msg);
+
+private:
+    EventProfiler()
+        : enabled(false)
+        , current(nullptr)
+    {
+    }
+
+    bool enabled;
+    // innermost active scope
+    Scope* current;
+    std::unordered_map<std::string, Sample> samples;
+};
+
+} // namespace plexe
+
+#define PROFILE_EVENT(handler, msg) plexe::EventProfiler::Scope profilerScope_(this, handler, msg)
+#define PROFILE_SIGNAL(signalID) plexe::EventProfiler::Scope profilerScope_(this, "receiveSignal", omnetpp::cComponent::getSignalName(signalID))
+
+#endif
@@ -0,0 +1,443 @@
+//
+// Copyright (C) 2012-2021 Michele Segata <segata@ccs-labs.org>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include "plexe/utilities/LevelOfDetailManager.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <list>
+#include <sstream>
+
+#include "plexe/PlexeManager.h"
+#include "plexe/mobility/CommandInterface.h"
+#include "plexe/protocols/BaseProtocol.h"
+#include "plexe/traci/PlexeScenarioManagerLaunchd.h"
+#include "plexe/utilities/BasePositionHelper.h"
+#include "plexe/utilities/DynamicPositionManager.h"
+#include "plexe/utilities/PlatoonKpi.h"
+
+#include <veins/modules/mobility/traci/TraCIMobility.h>
+
+namespace plexe {
+
+Define_Module(LevelOfDetailManager);
+
+LevelOfDetailManager* LevelOfDetailManager::instance = nullptr;
+
+LevelOfDetailManager::~LevelOfDetailManager()
+{
+    if (instance == this) instance = nullptr;
+    cancelAndDelete(update);
+}
+
+void LevelOfDetailManager::initialize()
+{
+    instance = this;
+    updateInterval = par("updateInterval");
+    detailRange = par("detailRange").doubleValue();
+    releaseRange = par("releaseRange").doubleValue();
+    if (releaseRange < detailRange) throw cRuntimeError("releaseRange must not be smaller than detailRange");
+
+    // regions are given as "from:to" intervals separated by spaces
+    regions.clear();
+    std::istringstream in(par("regionsOfInterest").stdstringValue());
+    std::string region;
+    while (in >> region) {
+        double from, to;
+        char separator;
+        std::istringstream fields(region);
+        if (!(fields >> from >> separator >> to) || separator != ':' || to < from) throw cRuntimeError("Invalid region of interest %s", region.c_str());
+        regions.push_back(std::make_pair(from, to));
+    }
+
+    aggregatePlatoons = par("aggregatePlatoons").boolValue();
+    aggregateRange = par("aggregateRange").doubleValue();
+    if (aggregatePlatoons) {
+        if (aggregateRange < releaseRange) throw cRuntimeError("aggregateRange must not be smaller than releaseRange");
+        // followers are removed together with their modules right away
+        manager = dynamic_cast<PlexeScenarioManagerLaunchd*>(veins::TraCIScenarioManagerAccess().get());
+        if (!manager) throw cRuntimeError("Platoon aggregation requires useLaunchd = true");
+    }
+
+    vehicles.clear();
+    maneuveringVehicles.clear();
+    hazardVehicles.clear();
+    aggregates.clear();
+    aggregatedVehicles.clear();
+    expandedRoutes.clear();
+    switches = 0;
+    aggregations = 0;
+    expansions = 0;
+    droppedFollowers = 0;
+    detailedVehiclesOut.setName("detailedVehicles");
+    autoFeedVehiclesOut.setName("autoFeedVehicles");
+    aggregatedVehiclesOut.setName("aggregatedVehicles");
+
+    auto maneuverEvent = [this](veins::SignalPayload<cObject*> payload) { onManeuverEvent(payload.p); };
+    signalManager.subscribeCallback(getSystemModule(), PlatoonKpi::maneuverEventSignal, maneuverEvent);
+
+    update = new cMessage("update");
+    scheduleAt(simTime() + updateInterval, update);
+}
+
+void LevelOfDetailManager::finish()
+{
+    recordScalar("switches", switches);
+    if (aggregatePlatoons) {
+        recordScalar("aggregations", aggregations);
+        recordScalar("expansions", expansions);
+        recordScalar("droppedFollowers", droppedFollowers);
+    }
+    // vehicles are deleted after the connection to SUMO is closed, so they
+    // must not unregister anymore
+    if (instance == this) instance = nullptr;
+}
+
+LevelOfDetailManager* LevelOfDetailManager::get()
+{
+    return instance;
+}
+
+void LevelOfDetailManager::registerVehicle(BaseProtocol* protocol, BasePositionHelper* positionHelper, veins::TraCIMobility* mobility)
+{
+    Vehicle vehicle;
+    vehicle.protocol = protocol;
+    vehicle.positionHelper = positionHelper;
+    vehicle.mobility = mobility;
+    vehicle.externalId = mobility->getExternalId();
+    vehicle.detailed = true;
+    vehicles[positionHelper->getId()] = vehicle;
+}
+
+void LevelOfDetailManager::unregisterVehicle(int vehicleId)
+{
+    auto removed = vehicles.find(vehicleId);
+    if (removed == vehicles.end()) return;
+
+    // followers removed by the aggregation of their platoon
+    if (aggregatedVehicles.find(vehicleId) != aggregatedVehicles.end()) {
+        vehicles.erase(removed);
+        return;
+    }
+    // the leader of an aggregated platoon was removed before its followers
+    // could be inserted again, so they are gone too
+    for (auto aggregated = aggregates.begin(); aggregated != aggregates.end(); aggregated++) {
+        if (aggregated->second.leaderId != vehicleId) continue;
+        EV_WARN << "Leader " << vehicleId << " removed while aggregated, dropping " << aggregated->second.members.size() << " followers\n";
+        for (auto& member : aggregated->second.members) {
+            aggregatedVehicles.erase(member.first);
+            DynamicPositionManager::getInstance().removeVehicleFromPlatoon(member.first);
+        }
+        droppedFollowers += aggregated->second.members.size();
+        aggregates.erase(aggregated);
+        break;
+    }
+    std::string externalId = removed->second.externalId;
+    bool detailed = removed->second.detailed;
+    vehicles.erase(removed);
+    if (detailed) return;
+
+    // SUMO cannot feed the followers with the data of a vehicle which is
+    // gone, so simulate them fully until the next update
+    for (auto& vehicle : vehicles) {
+        if (vehicle.second.fedLeader == externalId || vehicle.second.fedFront == externalId) setDetailed(vehicle.second, true);
+    }
+}
+
+void LevelOfDetailManager::onManeuverEvent(const cObject* obj)
+{
+    Enter_Method_Silent();
+    const ManeuverEvent* event = check_and_cast<const ManeuverEvent*>(obj);
+    switch (event->type) {
+    case ManeuverEvent::STARTED: {
+        maneuveringVehicles.insert(event->vehicleId);
+        break;
+    }
+    case ManeuverEvent::ENDED: {
+        maneuveringVehicles.erase(event->vehicleId);
+        break;
+    }
+    case ManeuverEvent::HAZARD: {
+        hazardVehicles.insert(event->vehicleId);
+        break;
+    }
+    case ManeuverEvent::HAZARD_CLEARED: {
+        hazardVehicles.erase(event->vehicleId);
+        break;
+    }
+    case ManeuverEvent::REMOVED: {
+        maneuveringVehicles.erase(event->vehicleId);
+        hazardVehicles.erase(event->vehicleId);
+        break;
+    }
+    default:
+        break;
+    }
+    // the platoons involved need the network right away, while switching
+    // back to auto-feed can wait for the next update
+    if (event->type == ManeuverEvent::STARTED || event->type == ManeuverEvent::HAZARD) updateLevels();
+}
+
+void LevelOfDetailManager::handleMessage(cMessage* msg)
+{
+    ASSERT(msg == update);
+    updateLevels();
+    scheduleAt(simTime() + updateInterval, update);
+}
+
+void LevelOfDetailManager::updateLevels()
+{
+    std::vector<veins::Coord> activePoints;
+    for (const std::set<int>* active : {&maneuveringVehicles, &hazardVehicles}) {
+        for (int vehicleId : *active) {
+            auto vehicle = vehicles.find(vehicleId);
+            if (vehicle != vehicles.end()) activePoints.push_back(vehicle->second.mobility->getPositionAt(simTime()));
+        }
+    }
+
+    // group vehicles by platoon. the others are always fully simulated
+    std::map<int, std::vector<int>> platoons;
+    for (auto& vehicle : vehicles) {
+        int platoonId = vehicle.second.positionHelper->getPlatoonId();
+        if (platoonId >= 0)
+            platoons[platoonId].push_back(vehicle.first);
+        else
+            setDetailed(vehicle.second, true);
+    }
+
+    for (auto& platoon : platoons) {
+        const std::vector<int>& members = platoon.second;
+        std::vector<veins::Coord> positions;
+        for (int member : members) positions.push_back(vehicles[member].mobility->getPositionAt(simTime()));
+
+        auto aggregated = aggregates.find(platoon.first);
+        if (aggregated != aggregates.end()) {
+            for (auto& member : aggregated->second.members) {
+                veins::Coord position;
+                getAggregatedPosition(member.first, position);
+                positions.push_back(position);
+            }
+            double distance = getDistance(positions, activePoints);
+            Vehicle& leader = vehicles[aggregated->second.leaderId];
+            if (distance <= detailRange || leader.mobility->getVehicleCommandInterface()->getLaneIndex() != aggregated->second.lane || isOnLastEdge(leader)) expand(platoon.first);
+            continue;
+        }
+
+        double distance = getDistance(positions, activePoints);
+        bool mixed = false;
+        for (int member : members) mixed = mixed || vehicles[member].detailed != vehicles[members.front()].detailed;
+
+        if (distance <= detailRange || (mixed && distance <= releaseRange))
+            setDetailed(members, true);
+        else if (distance > releaseRange || !vehicles[members.front()].detailed)
+            // also updates the vehicles fed to members in auto-feed
+            setDetailed(members, false);
+
+        Aggregate aggregate;
+        if (aggregatePlatoons && distance > aggregateRange && !vehicles[members.front()].detailed && canAggregate(members, aggregate)) this->aggregate(platoon.first, aggregate);
+    }
+
+    long detailedVehicles = 0;
+    for (auto& vehicle : vehicles) {
+        if (vehicle.second.detailed) detailedVehicles++;
+    }
+    detailedVehiclesOut.record(detailedVehicles);
+    autoFeedVehiclesOut.record(vehicles.size() - detailedVehicles);
+    if (aggregatePlatoons) aggregatedVehiclesOut.record(aggregatedVehicles.size());
+}
+
+double LevelOfDetailManager::getDistance(const std::vector<veins::Coord>& positions, const std::vector<veins::Coord>& activePoints) const
+{
+    double distance = std::numeric_limits<double>::infinity();
+    for (const veins::Coord& position : positions) {
+        for (const veins::Coord& point : activePoints) distance = std::min(distance, position.distance(point));
+        for (const auto& region : regions) {
+            if (position.x < region.first)
+                distance = std::min(distance, region.first - position.x);
+            else if (position.x > region.second)
+                distance = std::min(distance, position.x - region.second);
+            else
+                return 0;
+        }
+    }
+    return distance;
+}
+
+void LevelOfDetailManager::setDetailed(const std::vector<int>& members, bool detailed)
+{
+    if (!detailed) {
+        // followers can only be fed with the data of simulated vehicles
+        for (int member : members) {
+            BasePositionHelper* positionHelper = vehicles[member].positionHelper;
+            if (positionHelper->isLeader()) continue;
+            if (vehicles.find(positionHelper->getLeaderId()) == vehicles.end() || vehicles.find(positionHelper->getFrontId()) == vehicles.end()) {
+                detailed = true;
+                break;
+            }
+        }
+    }
+
+    for (int member : members) {
+        Vehicle& vehicle = vehicles[member];
+        if (detailed || vehicle.positionHelper->isLeader()) {
+            setDetailed(vehicle, detailed);
+        }
+        else {
+            const std::string& leader = vehicles[vehicle.positionHelper->getLeaderId()].externalId;
+            const std::string& front = vehicles[vehicle.positionHelper->getFrontId()].externalId;
+            setDetailed(vehicle, false, leader, front);
+        }
+    }
+}
+
+void LevelOfDetailManager::setDetailed(Vehicle& vehicle, bool detailed, const std::string& leader, const std::string& front)
+{
+    traci::CommandInterface* cifc = PlexeManager::get()->getCommandInterface();
+    if (leader != vehicle.fedLeader || front != vehicle.fedFront) {
+        if (leader.empty())
+            // stop the internal feeding before data is received again
+            cifc->vehicle(vehicle.externalId).enableAutoFeed(false);
+        else
+            // feed the CACC before the beacons stop
+            cifc->vehicle(vehicle.externalId).enableAutoFeed(true, leader, front);
+        vehicle.fedLeader = leader;
+        vehicle.fedFront = front;
+    }
+
+    if (vehicle.detailed == detailed) return;
+    vehicle.protocol->setFullDetail(detailed);
+    vehicle.detailed = detailed;
+    switches++;
+}
+
+bool LevelOfDetailManager::getAggregatedPosition(int vehicleId, veins::Coord& position) const
+{
+    auto aggregated = aggregatedVehicles.find(vehicleId);
+    if (aggregated == aggregatedVehicles.end()) return false;
+    const Aggregate& aggregate = aggregates.at(aggregated->second);
+    const Vehicle& leader = vehicles.at(aggregate.leaderId);
+    // rigid formation behind the leader
+    position = leader.mobility->getPositionAt(simTime()) - leader.mobility->getHeading().toCoord() * aggregate.members.at(vehicleId).offset;
+    return true;
+}
+
+bool LevelOfDetailManager::canAggregate(const std::vector<int>& members, Aggregate& aggregate)
+{
+    if (members.size() < 2) return false;
+    const Vehicle& leader = vehicles[members.front()];
+    BasePositionHelper* positionHelper = leader.positionHelper;
+    if (!positionHelper->isLeader()) positionHelper = vehicles[positionHelper->getLeaderId()].positionHelper;
+    // all members must be simulated, so that none of them is lost
+    const std::vector<int>& formation = positionHelper->getPlatoonFormation();
+    if (formation.size() != members.size()) return false;
+
+    veins::TraCICommandInterface::Vehicle* leaderVehicle = vehicles[formation.front()].mobility->getVehicleCommandInterface();
+    std::string road = leaderVehicle->getRoadId();
+    int lane = leaderVehicle->getLaneIndex();
+    double position = leaderVehicle->getLanePosition();
+    // the platoon would be expanded right away
+    if (isOnLastEdge(vehicles[formation.front()])) return false;
+
+    aggregate.leaderId = formation.front();
+    aggregate.lane = lane;
+    aggregate.formation = formation;
+    aggregate.members.clear();
+    for (size_t i = 1; i < formation.size(); i++) {
+        auto follower = vehicles.find(formation[i]);
+        if (follower == vehicles.end()) return false;
+        veins::TraCICommandInterface::Vehicle* followerVehicle = follower->second.mobility->getVehicleCommandInterface();
+        if (followerVehicle->getRoadId() != road || followerVehicle->getLaneIndex() != lane) return false;
+        AggregatedMember member;
+        member.externalId = follower->second.externalId;
+        member.typeId = followerVehicle->getTypeId();
+        member.offset = position - followerVehicle->getLanePosition();
+        aggregate.members[formation[i]] = member;
+    }
+    return true;
+}
+
+void LevelOfDetailManager::aggregate(int platoonId, const Aggregate& aggregate)
+{
+    aggregates[platoonId] = aggregate;
+    for (auto& member : aggregate.members) aggregatedVehicles[member.first] = platoonId;
+    for (auto& member : aggregate.members) manager->removeVehicle(member.second.externalId);
+    aggregations++;
+}
+
+bool LevelOfDetailManager::expand(int platoonId)
+{
+    Aggregate& aggregate = aggregates.at(platoonId);
+    Vehicle& leader = vehicles.at(aggregate.leaderId);
+    veins::TraCICommandInterface* traci = manager->getCommandInterface();
+    veins::TraCICommandInterface::Vehicle* leaderVehicle = leader.mobility->getVehicleCommandInterface();
+
+    std::list<std::string> edges = traci->route(leaderVehicle->getRouteId()).getRoadIds();
+    std::vector<std::string> route(edges.begin(), edges.end());
+    auto current = std::find(route.begin(), route.end(), leaderVehicle->getRoadId());
+    // the leader is crossing a junction
+    if (current == route.end()) return false;
+    int lane = leaderVehicle->getLaneIndex();
+    double position = leaderVehicle->getLanePosition();
+    double speed = leader.mobility->getSpeed();
+
+    // the position helpers of the new modules read the formation from here
+    DynamicPositionManager& positions = DynamicPositionManager::getInstance();
+    for (int member : aggregate.formation) positions.removeVehicleFromPlatoon(member);
+    for (size_t i = 0; i < aggregate.formation.size(); i++) positions.addVehicleToPlatoon(aggregate.formation[i], i, platoonId);
+    PlatoonInfo info = positions.getPlatoonInformation(platoonId);
+    info.lane = lane;
+    positions.setPlatoonInformation(platoonId, info);
+
+    for (auto& member : aggregate.members) {
+        // the member might be on one of the previous edges of the route
+        size_t edge = current - route.begin();
+        double memberPosition = position - member.second.offset;
+        while (memberPosition < 0 && edge > 0) {
+            edge--;
+            memberPosition += traci->lane(route[edge] + "_0").getLength();
+        }
+        std::vector<std::string> memberRoute(route.begin() + edge, route.end());
+        std::string& routeId = expandedRoutes[memberRoute];
+        if (routeId.empty()) {
+            std::stringstream name;
+            name << "plexe.expanded." << expandedRoutes.size() - 1;
+            routeId = name.str();
+            PlexeManager::get()->getCommandInterface()->addRoute(routeId, memberRoute);
+        }
+        traci->addVehicle(member.second.externalId, member.second.typeId, routeId, simTime(), std::max(memberPosition, 0.0), speed, lane);
+        aggregatedVehicles.erase(member.first);
+    }
+    aggregates.erase(platoonId);
+
+    // the new followers are fed through beacons until the next update
+    setDetailed(leader, true);
+    expansions++;
+    return true;
+}
+
+bool LevelOfDetailManager::isOnLastEdge(const Vehicle& vehicle) const
+{
+    veins::TraCICommandInterface::Vehicle* traciVehicle = vehicle.mobility->getVehicleCommandInterface();
+    std::list<std::string> edges = manager->getCommandInterface()->route(traciVehicle->getRouteId()).getRoadIds();
+    return !edges.empty() && edges.back() == traciVehicle->getRoadId();
+}
+
+} // namespace plexe
@@ -0,0 +1,196 @@
+//
+// Copyright (C) 2012-2021 Michele Segata <segata@ccs-labs.org>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#pragma once
+
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "plexe/plexe.h"
+
+#include <veins/base/utils/Coord.h>
+#include <veins/modules/utility/SignalManager.h>
+
+namespace veins {
+class TraCIMobility;
+}
+
+namespace plexe {
+
+class BaseProtocol;
+class BasePositionHelper;
+class PlexeScenarioManagerLaunchd;
+
+/**
+ * Switches platoons between two levels of detail depending on their
+ * distance from the places where communication matters. Platoons close to
+ * a vehicle in a maneuver, to a leader signaling a hazard or to a region of
+ * interest are fully simulated: their members beacon through BaseProtocol
+ * and CACCs are fed with the received data. Platoons far from all of them
+ * stop beaconing, and SUMO feeds the CACCs of their followers internally
+ * with the data of the leader and of the vehicle in front (auto-feed), so
+ * that no frame is simulated for them.
+ *
+ * Platoons are switched back to full detail as soon as they get within
+ * detailRange from an active place, and to auto-feed when they are farther
+ * than releaseRange from all of them. Vehicles not belonging to a platoon
+ * are always fully simulated. Auto-feed only provides leader and front
+ * data, so consensus based controllers lose the data of the other members
+ * while their platoon is in auto-feed. As platoons in auto-feed do not
+ * beacon, they cannot be found through the neighbor table, and scenarios
+ * refuse to discover platoons when the manager is enabled.
+ *
+ * Optionally (aggregatePlatoons), platoons in auto-feed farther than
+ * aggregateRange from all active places, with all members on the same lane
+ * of the same road, are aggregated: followers are removed from SUMO
+ * together with their modules, and their positions are derived from the
+ * one of the leader assuming a rigid formation (see
+ * getAggregatedPosition()). When the platoon gets within detailRange from
+ * an active place or its leader changes lane, the followers are inserted
+ * again in SUMO behind the leader, with its speed and their original
+ * distances, and new modules are built for them. The new modules are
+ * initialized as newly inserted vehicles of their platoon, so their
+ * statistics restart. Platoons are expanded before their leader enters the
+ * last edge of its route, so that the followers reach its end in SUMO.
+ * Followers of a leader removed while aggregated are lost, and counted in
+ * the droppedFollowers scalar. Aggregation requires
+ * PlexeScenarioManagerLaunchd.
+ */
+class LevelOfDetailManager : public cSimpleModule {
+
+public:
+    LevelOfDetailManager()
+        : update(nullptr)
+        , aggregatePlatoons(false)
+        , manager(nullptr)
+        , switches(0)
+        , aggregations(0)
+        , expansions(0)
+        , droppedFollowers(0)
+    {
+    }
+    virtual ~LevelOfDetailManager();
+
+    virtual void initialize() override;
+    virtual void finish() override;
+
+    /**
+     * Returns the manager of the running simulation, or nullptr if the
+     * network does not include one
+     */
+    static LevelOfDetailManager* get();
+
+    /**
+     * Registers a vehicle, which starts at full detail. The protocol must
+     * unregister the vehicle when it is deleted or reset for reuse
+     */
+    void registerVehicle(BaseProtocol* protocol, BasePositionHelper* positionHelper, veins::TraCIMobility* mobility);
+    void unregisterVehicle(int vehicleId);
+
+    /**
+     * Computes the position of a follower of an aggregated platoon from the
+     * one of its leader. Returns false if the vehicle is not aggregated
+     */
+    bool getAggregatedPosition(int vehicleId, veins::Coord& position) const;
+
+protected:
+    virtual void handleMessage(cMessage* msg) override;
+
+    typedef struct {
+        BaseProtocol* protocol;
+        BasePositionHelper* positionHelper;
+        veins::TraCIMobility* mobility;
+        std::string externalId;
+        bool detailed;
+        // leader and front vehicle fed by SUMO, empty when detailed
+        std::string fedLeader;
+        std::string fedFront;
+    } Vehicle;
+
+    typedef struct {
+        std::string externalId;
+        std::string typeId;
+        // distance behind the leader along the lane, kept constant
+        double offset;
+    } AggregatedMember;
+
+    typedef struct {
+        int leaderId;
+        int lane;
+        std::vector<int> formation;
+        std::map<int, AggregatedMember> members;
+    } Aggregate;
+
+    void onManeuverEvent(const cObject* obj);
+    // chooses the level of detail of every platoon
+    void updateLevels();
+    // returns the distance of the given positions from the closest active place
+    double getDistance(const std::vector<veins::Coord>& positions, const std::vector<veins::Coord>& activePoints) const;
+    // returns true and fills the aggregate if the platoon is in a steady formation
+    bool canAggregate(const std::vector<int>& members, Aggregate& aggregate);
+    void aggregate(int platoonId, const Aggregate& aggregate);
+    // inserts the followers again. returns false if it must be retried later
+    bool expand(int platoonId);
+    // returns true if the vehicle is on the last edge of its route
+    bool isOnLastEdge(const Vehicle& vehicle) const;
+    // switches a platoon to full detail or to auto-feed
+    void setDetailed(const std::vector<int>& members, bool detailed);
+    // switches a vehicle, letting SUMO feed it with the data of the given
+    // leader and front vehicle (none for detailed vehicles and leaders)
+    void setDetailed(Vehicle& vehicle, bool detailed, const std::string& leader = "", const std::string& front = "");
+
+    static LevelOfDetailManager* instance;
+
+    simtime_t updateInterval;
+    double detailRange;
+    double releaseRange;
+    // regions of interest, as intervals of the x coordinate
+    std::vector<std::pair<double, double>> regions;
+    bool aggregatePlatoons;
+    double aggregateRange;
+    PlexeScenarioManagerLaunchd* manager;
+
+    std::map<int, Vehicle> vehicles;
+    // vehicles in a maneuver and leaders signaling a hazard, by vehicle id
+    std::set<int> maneuveringVehicles;
+    std::set<int> hazardVehicles;
+    // aggregated platoons by platoon id, and their removed followers
+    std::map<int, Aggregate> aggregates;
+    std::map<int, int> aggregatedVehicles;
+    // routes of expanded followers by their edges. SUMO cannot remove
+    // routes, so they are reused instead of adding one per expansion
+    std::map<std::vector<std::string>, std::string> expandedRoutes;
+    cMessage* update;
+    veins::SignalManager signalManager;
+
+    // statistics
+    long switches;
+    long aggregations;
+    long expansions;
+    long droppedFollowers;
+    cOutVector detailedVehiclesOut;
+    cOutVector autoFeedVehiclesOut;
+    cOutVector aggregatedVehiclesOut;
+};
+
+} // namespace plexe
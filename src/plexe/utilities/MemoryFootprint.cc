@@ -0,0 +1,39 @@
+//
+// Copyright (C) 2012-2021 Michele Segata <segata@ccs-labs.org>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include "plexe/utilities/MemoryFootprint.h"
+
+#include <cstring>
+
+namespace plexe {
+
+bool isVectorRecordingEnabled(const cComponent* component, std::initializer_list<const char*> vectorNames)
+{
+    cConfiguration* config = getEnvir()->getConfig();
+    for (const char* name : vectorNames) {
+        std::string path = component->getFullPath() + "." + name;
+        const char* value = config->getPerObjectConfigValue(path.c_str(), "vector-recording");
+        // recording is enabled by default
+        if (!value || strcmp(value, "false") != 0) return true;
+    }
+    return false;
+}
+
+} // namespace plexe
@@ -0,0 +1,77 @@
+//
+// Copyright (C) 2012-2021 Michele Segata <segata@ccs-labs.org>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#pragma once
+
+#include <initializer_list>
+#include <map>
+#include <vector>
+
+#include "plexe/plexe.h"
+
+namespace plexe {
+
+/**
+ * Interface for the modules that account for the memory they use, summed
+ * per module type by the MemoryReport.
+ *
+ * The footprint is an estimate: the size of the object itself plus the
+ * memory it allocates (containers, output vectors, timers, helper objects).
+ * Classes inheriting from a module implementing the interface add the size
+ * of their own members and allocations to the one of their parent class.
+ */
+class MemoryFootprint {
+public:
+    MemoryFootprint(){};
+    virtual ~MemoryFootprint(){};
+
+    /**
+     * Returns the estimated number of bytes used by the module
+     */
+    virtual size_t getMemoryFootprint() const = 0;
+};
+
+/**
+ * Estimated memory used by the nodes of a map, excluding the map itself
+ */
+template <typename K, typename V>
+size_t mapFootprint(const std::map<K, V>& map)
+{
+    // red-black tree nodes hold three pointers and the color
+    return map.size() * (sizeof(typename std::map<K, V>::value_type) + 4 * sizeof(void*));
+}
+
+/**
+ * Estimated memory used by the elements of a vector, excluding the vector
+ * itself
+ */
+template <typename T>
+size_t vectorFootprint(const std::vector<T>& vector)
+{
+    return vector.capacity() * sizeof(T);
+}
+
+/**
+ * Returns true if the configuration enables the recording of at least one
+ * of the given output vectors of the component (vector-recording option)
+ */
+bool isVectorRecordingEnabled(const cComponent* component, std::initializer_list<const char*> vectorNames);
+
+} // namespace plexe
@@ -0,0 +1,135 @@
+//
+// Copyright (C) 2012-2021 Michele Segata <segata@ccs-labs.org>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include "plexe/utilities/MemoryReport.h"
+#include "plexe/utilities/MemoryFootprint.h"
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+
+namespace plexe {
+
+Define_Module(MemoryReport);
+
+MemoryReport::~MemoryReport()
+{
+    cancelAndDelete(sample);
+}
+
+void MemoryReport::initialize()
+{
+    sampleInterval = par("sampleInterval");
+    maxRss = par("maxRss");
+    maxRssGrowth = par("maxRssGrowth");
+    warmupTime = par("warmupTime");
+    baselineRss = -1;
+    peakUsage.clear();
+    peakBytes = 0;
+    if (sampleInterval > 0) {
+        sample = new cMessage("sample");
+        scheduleAt(simTime() + sampleInterval, sample);
+    }
+}
+
+void MemoryReport::finish()
+{
+    std::map<std::string, Usage> usage = update();
+    size_t bytes = 0;
+    for (const auto& type : usage) {
+        const std::string& name = type.first;
+        const Usage& peak = peakUsage[name];
+        recordScalar((name + ".instances").c_str(), type.second.instances);
+        recordScalar((name + ".peakInstances").c_str(), peak.instances);
+        if (type.second.bytes == 0 && peak.bytes == 0) continue;
+        recordScalar((name + ".bytes").c_str(), type.second.bytes);
+        recordScalar((name + ".bytesPerInstance").c_str(), type.second.instances > 0 ? (double) type.second.bytes / type.second.instances : 0.0);
+        recordScalar((name + ".peakBytes").c_str(), peak.bytes);
+        EV_INFO << name << ": " << type.second.instances << " instances, " << type.second.bytes << " bytes (peak " << peak.instances << " instances, " << peak.bytes << " bytes)\n";
+        bytes += type.second.bytes;
+    }
+    recordScalar("bytes", bytes);
+    recordScalar("peakBytes", peakBytes);
+
+    long rss = readProcessMemory("VmRSS");
+    if (rss >= 0) recordScalar("rss", rss);
+    long peakRss = readProcessMemory("VmHWM");
+    if (peakRss >= 0) recordScalar("peakRss", peakRss);
+    if (baselineRss >= 0) recordScalar("baselineRss", baselineRss);
+}
+
+void MemoryReport::handleMessage(cMessage* msg)
+{
+    if (msg == sample) {
+        update();
+        long rss = readProcessMemory("VmRSS");
+        if (maxRss > 0 && rss > maxRss) throw cRuntimeError("Resident set size of %ld bytes exceeds maxRss (%.0f bytes)", rss, maxRss);
+        if (rss >= 0 && simTime() >= warmupTime) {
+            if (baselineRss < 0) baselineRss = rss;
+            if (maxRssGrowth > 0 && rss > baselineRss * (1 + maxRssGrowth)) throw cRuntimeError("Resident set size of %ld bytes grown by more than maxRssGrowth (%g) since the end of the warm-up (%ld bytes)", rss, maxRssGrowth, baselineRss);
+        }
+        scheduleAt(simTime() + sampleInterval, sample);
+    }
+    else {
+        delete msg;
+    }
+}
+
+void MemoryReport::collect(cModule* module, std::map<std::string, Usage>& usage)
+{
+    // submodules of the same type share the name of their class or compound module
+    Usage& typeUsage = usage[module->getComponentType()->getName()];
+    typeUsage.instances++;
+    if (MemoryFootprint* footprint = dynamic_cast<MemoryFootprint*>(module)) typeUsage.bytes += footprint->getMemoryFootprint();
+    for (cModule::SubmoduleIterator submodule(module); !submodule.end(); submodule++) collect(*submodule, usage);
+}
+
+std::map<std::string, MemoryReport::Usage> MemoryReport::update()
+{
+    std::map<std::string, Usage> usage;
+    collect(getSimulation()->getSystemModule(), usage);
+    size_t bytes = 0;
+    for (const auto& type : usage) {
+        Usage& peak = peakUsage[type.first];
+        peak.instances = std::max(peak.instances, type.second.instances);
+        peak.bytes = std::max(peak.bytes, type.second.bytes);
+        bytes += type.second.bytes;
+    }
+    peakBytes = std::max(peakBytes, bytes);
+    return usage;
+}
+
+long MemoryReport::readProcessMemory(const char* field)
+{
+    // only available on Linux. values are given in kB
+    std::ifstream status("/proc/self/status");
+    std::string key;
+    while (status >> key) {
+        if (key == std::string(field) + ":") {
+            long kb;
+            if (status >> kb) return kb * 1024;
+            return -1;
+        }
+        status.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    }
+    return -1;
+}
+
+} // namespace plexe
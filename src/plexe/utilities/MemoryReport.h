@@ -0,0 +1,83 @@
+//
+// Copyright (C) 2012-2021 Michele Segata <segata@ccs-labs.org>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#pragma once
+
+#include <map>
+#include <string>
+
+#include "plexe/plexe.h"
+
+namespace plexe {
+
+/**
+ * Reports the memory used by the modules of the simulation, per module
+ * type. For each type it records the number of instances and, for the
+ * modules implementing MemoryFootprint, the estimated number of bytes they
+ * use, both at the end of the simulation and at their peak (vehicles
+ * leaving the simulation are not counted at finish()). The resident set
+ * size of the process is recorded as well, when available, and can be
+ * bounded for soak runs, either in absolute terms or as growth over the
+ * size after the warm-up.
+ */
+class MemoryReport : public cSimpleModule {
+
+public:
+    MemoryReport()
+        : sample(nullptr)
+        , peakBytes(0)
+        , baselineRss(-1)
+    {
+    }
+    virtual ~MemoryReport();
+
+    virtual void initialize() override;
+    virtual void finish() override;
+
+protected:
+    virtual void handleMessage(cMessage* msg) override;
+
+    typedef struct {
+        long instances;
+        size_t bytes;
+    } Usage;
+
+    // sums the usage of the module and of all its submodules, per type
+    void collect(cModule* module, std::map<std::string, Usage>& usage);
+    // updates the peak usage with the current one and returns the latter
+    std::map<std::string, Usage> update();
+    // reads a memory size from /proc/self/status, in bytes. -1 if unknown
+    static long readProcessMemory(const char* field);
+
+    simtime_t sampleInterval;
+    double maxRss;
+    double maxRssGrowth;
+    simtime_t warmupTime;
+    cMessage* sample;
+    // resident set size at the first sample after the warm-up, -1 before
+    long baselineRss;
+
+    // peak usage per module type
+    std::map<std::string, Usage> peakUsage;
+    // peak bytes used by all accounted modules together
+    size_t peakBytes;
+};
+
+} // namespace plexe
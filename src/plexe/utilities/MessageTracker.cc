@@ -0,0 +1,217 @@
+//
+// Copyright (C) 2012-2021 Michele Segata <segata@ccs-labs.org>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include "plexe/utilities/MessageTracker.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "plexe/apps/GeneralPlatooningApp.h"
+#include "plexe/messages/ManeuverMessage_m.h"
+
+namespace plexe {
+
+Define_Module(MessageTracker);
+
+namespace {
+
+// visits the objects owned by a module, without entering its submodules
+class OwnedMessages : public cVisitor {
+public:
+    std::vector<const cMessage*> messages;
+
+    virtual void visit(cObject* obj) override
+    {
+        if (cMessage* msg = dynamic_cast<cMessage*>(obj)) {
+            // encapsulated packets are counted with their message
+            messages.push_back(msg);
+            return;
+        }
+        // submodules are counted on their own. gates and parameters hold no messages
+        if (dynamic_cast<cComponent*>(obj) || dynamic_cast<cGate*>(obj) || dynamic_cast<cPar*>(obj)) return;
+        processChildrenOf(obj);
+    }
+};
+
+} // namespace
+
+MessageTracker::~MessageTracker()
+{
+    cancelAndDelete(report);
+    for (auto& vector : moduleMessagesOut) delete vector.second;
+    for (auto& vector : stateMessagesOut) delete vector.second;
+}
+
+void MessageTracker::initialize()
+{
+    reportInterval = par("reportInterval");
+    maxLiveMessages = par("maxLiveMessages");
+    maxLiveMessagesGrowth = par("maxLiveMessagesGrowth");
+    warmupTime = par("warmupTime");
+    baselineMessages = -1;
+    peakByModule.clear();
+    peakByState.clear();
+    peak = Count();
+    liveMessagesOut.setName("liveMessages");
+    trackedMessagesOut.setName("trackedMessages");
+    maneuverMessagesOut.setName("maneuverMessages");
+    report = new cMessage("report");
+    scheduleAt(simTime() + reportInterval, report);
+}
+
+void MessageTracker::finish()
+{
+    takeCensus();
+    recordScalar("peakMessages", peak.messages);
+    if (baselineMessages >= 0) recordScalar("baselineMessages", baselineMessages);
+    recordScalar("peakManeuverMessages", peak.maneuverMessages);
+    for (const auto& module : peakByModule) {
+        recordScalar((module.first + ".peakMessages").c_str(), module.second.messages);
+        recordScalar((module.first + ".peakManeuverMessages").c_str(), module.second.maneuverMessages);
+    }
+    for (const auto& state : peakByState) {
+        recordScalar(("state." + state.first + ".peakMessages").c_str(), state.second.messages);
+        recordScalar(("state." + state.first + ".peakManeuverMessages").c_str(), state.second.maneuverMessages);
+    }
+}
+
+void MessageTracker::handleMessage(cMessage* msg)
+{
+    if (msg == report) {
+        takeCensus();
+        scheduleAt(simTime() + reportInterval, report);
+    }
+    else {
+        delete msg;
+    }
+}
+
+bool MessageTracker::isManeuverMessage(const cMessage* msg)
+{
+    if (dynamic_cast<const ManeuverMessage*>(msg)) return true;
+    const cPacket* pkt = dynamic_cast<const cPacket*>(msg);
+    for (; pkt; pkt = pkt->getEncapsulatedPacket()) {
+        if (dynamic_cast<const ManeuverMessage*>(pkt)) return true;
+    }
+    return false;
+}
+
+void MessageTracker::add(Census& census, const std::string& moduleType, const std::string& state, const cMessage* msg)
+{
+    bool maneuver = isManeuverMessage(msg);
+    Count& module = census.byModule[moduleType];
+    Count& vehicle = census.byState[state];
+    module.messages++;
+    vehicle.messages++;
+    census.total.messages++;
+    if (maneuver) {
+        module.maneuverMessages++;
+        vehicle.maneuverMessages++;
+        census.total.maneuverMessages++;
+    }
+}
+
+void MessageTracker::countOwned(cModule* module, const std::string& state, std::map<cModule*, std::string>& vehicleStates, Census& census)
+{
+    OwnedMessages owned;
+    owned.processChildrenOf(module);
+    for (const cMessage* msg : owned.messages) add(census, module->getComponentType()->getName(), state, msg);
+
+    for (cModule::SubmoduleIterator submodule(module); !submodule.end(); submodule++) {
+        std::string submoduleState = state;
+        if (module == getSimulation()->getSystemModule()) {
+            // vehicles are direct submodules of the network
+            GeneralPlatooningApp* app = dynamic_cast<GeneralPlatooningApp*>((*submodule)->getSubmodule("appl"));
+            submoduleState = app ? app->getManeuverState() : "none";
+            vehicleStates[*submodule] = submoduleState;
+        }
+        countOwned(*submodule, submoduleState, vehicleStates, census);
+    }
+}
+
+void MessageTracker::countScheduled(const std::map<cModule*, std::string>& vehicleStates, Census& census)
+{
+    cFutureEventSet* fes = getSimulation()->getFES();
+    for (int i = 0; i < fes->getLength(); i++) {
+        cMessage* msg = dynamic_cast<cMessage*>(fes->get(i));
+        if (!msg) continue;
+        cModule* module = msg->getArrivalModule();
+        if (!module) continue;
+        // find the vehicle (or global module) the destination belongs to
+        cModule* vehicle = module;
+        while (vehicle->getParentModule() && vehicle->getParentModule() != getSimulation()->getSystemModule()) vehicle = vehicle->getParentModule();
+        auto state = vehicleStates.find(vehicle);
+        add(census, module->getComponentType()->getName(), state != vehicleStates.end() ? state->second : "none", msg);
+    }
+}
+
+void MessageTracker::recordCounts(const std::map<std::string, Count>& counts, const std::string& prefix, std::map<std::string, cOutVector*>& vectors)
+{
+    // keys that disappeared since the last report drop to zero
+    for (auto& vector : vectors) {
+        if (counts.find(vector.first) == counts.end()) vector.second->record(0);
+    }
+    for (const auto& count : counts) {
+        cOutVector*& vector = vectors[count.first];
+        if (!vector) vector = new cOutVector((prefix + count.first + ".messages").c_str());
+        vector->record(count.second.messages);
+    }
+}
+
+void MessageTracker::takeCensus()
+{
+    Census census;
+    census.total = Count();
+    std::map<cModule*, std::string> vehicleStates;
+    countOwned(getSimulation()->getSystemModule(), "none", vehicleStates, census);
+    countScheduled(vehicleStates, census);
+
+    long live = cMessage::getLiveMessageCount();
+    liveMessagesOut.record(live);
+    trackedMessagesOut.record(census.total.messages);
+    maneuverMessagesOut.record(census.total.maneuverMessages);
+
+    peak.messages = std::max(peak.messages, census.total.messages);
+    peak.maneuverMessages = std::max(peak.maneuverMessages, census.total.maneuverMessages);
+    for (const auto& module : census.byModule) {
+        Count& modulePeak = peakByModule[module.first];
+        modulePeak.messages = std::max(modulePeak.messages, module.second.messages);
+        modulePeak.maneuverMessages = std::max(modulePeak.maneuverMessages, module.second.maneuverMessages);
+    }
+    for (const auto& state : census.byState) {
+        Count& statePeak = peakByState[state.first];
+        statePeak.messages = std::max(statePeak.messages, state.second.messages);
+        statePeak.maneuverMessages = std::max(statePeak.maneuverMessages, state.second.maneuverMessages);
+    }
+
+    recordCounts(census.byModule, "module.", moduleMessagesOut);
+    recordCounts(census.byState, "state.", stateMessagesOut);
+
+    EV_INFO << live << " live messages, " << census.total.messages << " tracked, " << census.total.maneuverMessages << " maneuver messages\n";
+    for (const auto& module : census.byModule) EV_INFO << "  module " << module.first << ": " << module.second.messages << " (" << module.second.maneuverMessages << " maneuver)\n";
+    for (const auto& state : census.byState) EV_INFO << "  state " << state.first << ": " << state.second.messages << " (" << state.second.maneuverMessages << " maneuver)\n";
+
+    if (maxLiveMessages > 0 && live > maxLiveMessages) throw cRuntimeError("%ld live messages, more than maxLiveMessages (%ld)", live, maxLiveMessages);
+    if (simTime() < warmupTime) return;
+    if (baselineMessages < 0) baselineMessages = live;
+    if (maxLiveMessagesGrowth > 0 && live > baselineMessages * (1 + maxLiveMessagesGrowth)) throw cRuntimeError("%ld live messages, grown by more than maxLiveMessagesGrowth (%g) since the end of the warm-up (%ld)", live, maxLiveMessagesGrowth, baselineMessages);
+}
+
+} // namespace plexe
@@ -0,0 +1,110 @@
+//
+// Copyright (C) 2012-2021 Michele Segata <segata@ccs-labs.org>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#pragma once
+
+#include <map>
+#include <string>
+
+#include "plexe/plexe.h"
+
+namespace plexe {
+
+/**
+ * Debugging aid for long (soak) runs: periodically counts the live messages
+ * and the maneuver messages among them, per owning module type and per
+ * maneuver state of the vehicle they belong to. Messages held by a module
+ * (e.g., timers not scheduled, or messages never freed) are attributed to
+ * that module, while scheduled messages and frames in flight are attributed
+ * to the module they are directed to. A count that grows over time for a
+ * module type or a state points to a leak.
+ *
+ * Each report is logged with EV_INFO, and the totals as well as the counts
+ * of each module type and state are recorded as vectors. Peaks are
+ * recorded as scalars at finish(). If
+ * maxLiveMessages is set, the simulation is stopped with an error as soon
+ * as more messages are alive. As the number of messages depends on the
+ * size of the network, maxLiveMessagesGrowth bounds instead their growth
+ * with respect to the count taken after the warm-up.
+ */
+class MessageTracker : public cSimpleModule {
+
+public:
+    MessageTracker()
+        : report(nullptr)
+        , baselineMessages(-1)
+    {
+    }
+    virtual ~MessageTracker();
+
+    virtual void initialize() override;
+    virtual void finish() override;
+
+    /**
+     * Returns true if the message is a maneuver message or a frame
+     * carrying one
+     */
+    static bool isManeuverMessage(const cMessage* msg);
+
+protected:
+    virtual void handleMessage(cMessage* msg) override;
+
+    typedef struct {
+        long messages;
+        long maneuverMessages;
+    } Count;
+
+    typedef struct {
+        std::map<std::string, Count> byModule;
+        std::map<std::string, Count> byState;
+        Count total;
+    } Census;
+
+    // counts the messages owned by the module and its submodules. state is
+    // the maneuver state of the vehicle the module belongs to
+    void countOwned(cModule* module, const std::string& state, std::map<cModule*, std::string>& vehicleStates, Census& census);
+    // counts the messages in the future event set
+    void countScheduled(const std::map<cModule*, std::string>& vehicleStates, Census& census);
+    void add(Census& census, const std::string& moduleType, const std::string& state, const cMessage* msg);
+    // counts all messages, updates the peaks and logs the report
+    void takeCensus();
+    // records the number of messages of each key, creating the vectors of new keys
+    void recordCounts(const std::map<std::string, Count>& counts, const std::string& prefix, std::map<std::string, cOutVector*>& vectors);
+
+    simtime_t reportInterval;
+    long maxLiveMessages;
+    double maxLiveMessagesGrowth;
+    simtime_t warmupTime;
+    cMessage* report;
+    // live messages at the first report after the warm-up, -1 before
+    long baselineMessages;
+
+    // peaks over all reports
+    std::map<std::string, Count> peakByModule;
+    std::map<std::string, Count> peakByState;
+    Count peak;
+
+    cOutVector liveMessagesOut, trackedMessagesOut, maneuverMessagesOut;
+    // messages of each module type and maneuver state, by name
+    std::map<std::string, cOutVector*> moduleMessagesOut;
+    std::map<std::string, cOutVector*> stateMessagesOut;
+};
+
+} // namespace plexe
@@ -0,0 +1,138 @@
+//
+// Copyright (C) 2012-2021 Michele Segata <segata@ccs-labs.org>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include "plexe/utilities/NeighborTable.h"
+
+namespace plexe {
+
+void NeighborTable::update(const Neighbor& neighbor)
+{
+    expire();
+
+    auto entry = neighbors.find(neighbor.vehicleId);
+    if (entry == neighbors.end()) {
+        Entry created;
+        created.neighbor = neighbor;
+        created.slot = lanes[neighbor.lane].emplace(neighbor.position, neighbor.vehicleId);
+        neighbors.emplace(neighbor.vehicleId, created);
+    }
+    else {
+        Neighbor& known = entry->second.neighbor;
+        if (known.lane != neighbor.lane || known.position != neighbor.position) {
+            LaneIndex& lane = lanes[known.lane];
+            lane.erase(entry->second.slot);
+            if (lane.empty()) lanes.erase(known.lane);
+            entry->second.slot = lanes[neighbor.lane].emplace(neighbor.position, neighbor.vehicleId);
+        }
+        known = neighbor;
+    }
+    if (neighbor.platoonId >= 0 && neighbor.platoonPosition == 0) leaders[neighbor.platoonId] = neighbor.vehicleId;
+    updates.emplace_back(neighbor.time, neighbor.vehicleId);
+}
+
+void NeighborTable::expire()
+{
+    while (!updates.empty() && simTime() - updates.front().first > timeout) {
+        int vehicleId = updates.front().second;
+        updates.pop_front();
+        // the entry might have been refreshed after this update
+        auto entry = neighbors.find(vehicleId);
+        if (entry != neighbors.end() && isStale(entry->second.neighbor)) remove(vehicleId);
+    }
+}
+
+const Neighbor* NeighborTable::findPlatoonAhead(double position, int lane, double distance, int excludedPlatoonId)
+{
+    auto index = lanes.find(lane);
+    if (index == lanes.end()) return nullptr;
+    LaneIndex& vehicles = index->second;
+
+    auto i = vehicles.upper_bound(position);
+    while (i != vehicles.end() && i->first <= position + distance) {
+        const Neighbor& neighbor = neighbors.at(i->second).neighbor;
+        if (isStale(neighbor)) {
+            int vehicleId = i->second;
+            i++;
+            remove(vehicleId);
+            // removing the last vehicle of the lane removes its index
+            if (lanes.find(lane) == lanes.end()) return nullptr;
+            continue;
+        }
+        if (neighbor.platoonId >= 0 && neighbor.platoonId != excludedPlatoonId) return &neighbor;
+        i++;
+    }
+    return nullptr;
+}
+
+int NeighborTable::getPlatoonLeader(int platoonId)
+{
+    auto leader = leaders.find(platoonId);
+    if (leader == leaders.end()) return -1;
+    // the leader might have left the platoon or the range since
+    const Neighbor* neighbor = getNeighbor(leader->second);
+    if (!neighbor || neighbor->platoonId != platoonId || neighbor->platoonPosition != 0) {
+        leaders.erase(leader);
+        return -1;
+    }
+    return neighbor->vehicleId;
+}
+
+const Neighbor* NeighborTable::getNeighbor(int vehicleId)
+{
+    auto entry = neighbors.find(vehicleId);
+    if (entry == neighbors.end()) return nullptr;
+    if (isStale(entry->second.neighbor)) {
+        remove(vehicleId);
+        return nullptr;
+    }
+    return &entry->second.neighbor;
+}
+
+void NeighborTable::remove(int vehicleId)
+{
+    auto entry = neighbors.find(vehicleId);
+    if (entry == neighbors.end()) return;
+    int lane = entry->second.neighbor.lane;
+    LaneIndex& index = lanes[lane];
+    index.erase(entry->second.slot);
+    if (index.empty()) lanes.erase(lane);
+    neighbors.erase(entry);
+}
+
+void NeighborTable::clear()
+{
+    neighbors.clear();
+    lanes.clear();
+    leaders.clear();
+    updates.clear();
+}
+
+size_t NeighborTable::getMemoryFootprint() const
+{
+    // hash and tree nodes hold up to four pointers besides the element
+    size_t bytes = neighbors.size() * (sizeof(std::pair<const int, Entry>) + 4 * sizeof(void*));
+    bytes += neighbors.size() * (sizeof(LaneIndex::value_type) + 4 * sizeof(void*));
+    bytes += lanes.size() * (sizeof(std::pair<const int, LaneIndex>) + 4 * sizeof(void*));
+    bytes += leaders.size() * (sizeof(std::pair<const int, int>) + 4 * sizeof(void*));
+    bytes += updates.size() * sizeof(std::pair<simtime_t, int>);
+    return bytes;
+}
+
+} // namespace plexe
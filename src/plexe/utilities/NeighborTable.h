@@ -0,0 +1,136 @@
+//
+// Copyright (C) 2012-2021 Michele Segata <segata@ccs-labs.org>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#ifndef NEIGHBORTABLE_H_
+#define NEIGHBORTABLE_H_
+
+#include <deque>
+#include <map>
+#include <unordered_map>
+#include <utility>
+
+#include "plexe/plexe.h"
+
+namespace plexe {
+
+/**
+ * State of a neighbor as announced in its last beacon
+ */
+struct Neighbor {
+    int vehicleId = -1;
+    // platoon of the neighbor and its position in it, or -1
+    int platoonId = -1;
+    int platoonPosition = -1;
+    int lane = -1;
+    // position along the road
+    double position = 0;
+    double speed = 0;
+    simtime_t time;
+};
+
+/**
+ * Table of the vehicles a vehicle hears beacons from, indexed by lane and
+ * by position along the road so that nearby platoons can be found in
+ * logarithmic time instead of scanning all the neighbors. The road is
+ * assumed to be locally straight and aligned with the x axis, as in the
+ * highways of the examples, so the position along the road is the x
+ * coordinate.
+ *
+ * Entries not refreshed for longer than the timeout are dropped lazily:
+ * queries skip and remove the stale entries they meet, and each update
+ * removes the entries whose last beacon has become too old, so that the
+ * cost of expiry is amortized over the beacons received.
+ */
+class NeighborTable {
+
+public:
+    explicit NeighborTable(simtime_t timeout = 1)
+        : timeout(timeout)
+    {
+    }
+
+    /**
+     * Adds a neighbor or updates its entry
+     */
+    void update(const Neighbor& neighbor);
+
+    /**
+     * Returns the member of another platoon which is nearest ahead of the
+     * given position, on the given lane and within the given distance, or
+     * nullptr if there is none. Members of the excluded platoon are ignored
+     */
+    const Neighbor* findPlatoonAhead(double position, int lane, double distance, int excludedPlatoonId = -1);
+
+    /**
+     * Returns the id of the leader of the given platoon, or -1 if no recent
+     * beacon of the leader has been received
+     */
+    int getPlatoonLeader(int platoonId);
+
+    /**
+     * Returns the entry of the given vehicle, or nullptr if it is unknown
+     * or stale
+     */
+    const Neighbor* getNeighbor(int vehicleId);
+
+    void remove(int vehicleId);
+
+    void clear();
+
+    size_t size() const
+    {
+        return neighbors.size();
+    }
+
+    /**
+     * Returns the estimated memory allocated by the table, excluding the
+     * table object itself
+     */
+    size_t getMemoryFootprint() const;
+
+protected:
+    // vehicle ids by position along the road, for a lane
+    typedef std::multimap<double, int> LaneIndex;
+
+    struct Entry {
+        Neighbor neighbor;
+        LaneIndex::iterator slot;
+    };
+
+    bool isStale(const Neighbor& neighbor) const
+    {
+        return simTime() - neighbor.time > timeout;
+    }
+
+    // removes the entries whose last update is older than the timeout
+    void expire();
+
+    simtime_t timeout;
+    std::unordered_map<int, Entry> neighbors;
+    std::map<int, LaneIndex> lanes;
+    // leader of each platoon, by platoon id
+    std::unordered_map<int, int> leaders;
+    // updates in time order, used to find the entries to expire
+    std::deque<std::pair<simtime_t, int>> updates;
+};
+
+} // namespace plexe
+
+#endif
@@ -0,0 +1,92 @@
+//
+// Copyright (C) 2012-2021 Michele Segata <segata@ccs-labs.org>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#ifndef PLATOONFORMATION_H_
+#define PLATOONFORMATION_H_
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace plexe {
+
+/**
+ * Immutable platoon formation, shared by all members having the same view
+ * of the platoon (see DynamicPositionManager::getSharedFormation()). Besides
+ * the ordered list of members, it stores the (vehicle id, position) pairs
+ * sorted by id, so that position lookups take logarithmic time and memory
+ * does not depend on how large vehicle ids grow.
+ */
+class PlatoonFormation {
+
+public:
+    explicit PlatoonFormation(const std::vector<int>& members)
+        : members(members)
+    {
+        positions.reserve(members.size());
+        for (int i = 0; i < members.size(); i++) {
+            if (members[i] >= 0) positions.emplace_back(members[i], i);
+        }
+        std::sort(positions.begin(), positions.end());
+    }
+
+    const std::vector<int>& getMembers() const
+    {
+        return members;
+    }
+
+    int size() const
+    {
+        return members.size();
+    }
+
+    /**
+     * Returns the id of the vehicle at the given position, or -1
+     */
+    int getMemberId(int position) const
+    {
+        if (position >= 0 && position < members.size())
+            return members[position];
+        else
+            return -1;
+    }
+
+    /**
+     * Returns the position of the given vehicle, or -1 if it is not a member
+     */
+    int getPosition(int vehicleId) const
+    {
+        auto position = std::lower_bound(positions.begin(), positions.end(), std::make_pair(vehicleId, -1));
+        if (position != positions.end() && position->first == vehicleId)
+            return position->second;
+        else
+            return -1;
+    }
+
+private:
+    // vehicle ids, ordered by position
+    const std::vector<int> members;
+    // (vehicle id, position) of each member, sorted by vehicle id
+    std::vector<std::pair<int, int>> positions;
+};
+
+} // namespace plexe
+
+#endif
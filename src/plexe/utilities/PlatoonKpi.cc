@@ -0,0 +1,157 @@
+//
+// Copyright (C) 2012-2021 Michele Segata <segata@ccs-labs.org>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include "plexe/utilities/PlatoonKpi.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+namespace plexe {
+
+Define_Module(PlatoonKpi);
+
+const simsignal_t PlatoonKpi::vehicleSampleSignal = registerSignal("org_car2x_plexe_vehicleSample");
+const simsignal_t PlatoonKpi::maneuverEventSignal = registerSignal("org_car2x_plexe_maneuverEvent");
+
+void PlatoonKpi::initialize()
+{
+    platoons.clear();
+    maneuverStart.clear();
+    // signals emitted by vehicles propagate up to the network
+    cModule* network = getSimulation()->getSystemModule();
+    network->subscribe(vehicleSampleSignal, this);
+    network->subscribe(maneuverEventSignal, this);
+}
+
+void PlatoonKpi::receiveSignal(cComponent* source, simsignal_t signalID, cObject* obj, cObject* details)
+{
+    if (signalID == vehicleSampleSignal)
+        onVehicleSample(check_and_cast<const VehicleSample*>(obj));
+    else if (signalID == maneuverEventSignal)
+        onManeuverEvent(check_and_cast<const ManeuverEvent*>(obj));
+}
+
+void PlatoonKpi::onVehicleSample(const VehicleSample* sample)
+{
+    if (sample->platoonId < 0) return;
+    Kpis& kpis = platoons[sample->platoonId];
+
+    // the leader has no platoon member in front
+    if (sample->position > 0 && sample->distance >= 0) {
+        kpis.minGap = std::min(kpis.minGap, sample->distance);
+        if (sample->relativeSpeed < 0) kpis.minTimeToCollision = std::min(kpis.minTimeToCollision, sample->distance / -sample->relativeSpeed);
+    }
+
+    if (sample->position >= 0) {
+        if (sample->position >= (int) kpis.peakAcceleration.size()) kpis.peakAcceleration.resize(sample->position + 1, 0);
+        double& peak = kpis.peakAcceleration[sample->position];
+        peak = std::max(peak, std::fabs(sample->acceleration));
+    }
+}
+
+void PlatoonKpi::onManeuverEvent(const ManeuverEvent* event)
+{
+    switch (event->type) {
+    case ManeuverEvent::STARTED: {
+        maneuverStart[event->vehicleId] = simTime();
+        break;
+    }
+    case ManeuverEvent::ENDED: {
+        auto start = maneuverStart.find(event->vehicleId);
+        if (start == maneuverStart.end()) break;
+        simtime_t duration = simTime() - start->second;
+        maneuverStart.erase(start);
+        // the platoon at the end of the maneuver, i.e., the one joined
+        if (event->platoonId < 0) break;
+        Kpis& kpis = platoons[event->platoonId];
+        kpis.maneuvers++;
+        kpis.totalManeuverTime += duration;
+        kpis.maxManeuverTime = std::max(kpis.maxManeuverTime, duration);
+        break;
+    }
+    case ManeuverEvent::HAZARD: {
+        if (event->platoonId < 0) break;
+        Kpis& kpis = platoons[event->platoonId];
+        if (kpis.hazardStart < 0) kpis.hazardStart = simTime();
+        break;
+    }
+    case ManeuverEvent::INTERRUPTED: {
+        if (event->platoonId < 0) break;
+        Kpis& kpis = platoons[event->platoonId];
+        if (kpis.hazardStart < 0) break;
+        simtime_t latency = simTime() - kpis.hazardStart;
+        kpis.hazardStart = -1;
+        kpis.interruptions++;
+        kpis.totalInterruptionLatency += latency;
+        kpis.maxInterruptionLatency = std::max(kpis.maxInterruptionLatency, latency);
+        break;
+    }
+    case ManeuverEvent::HAZARD_CLEARED: {
+        // a hazard that did not lead to a pause must not delay the next one
+        auto platoon = platoons.find(event->platoonId);
+        if (platoon != platoons.end()) platoon->second.hazardStart = -1;
+        break;
+    }
+    case ManeuverEvent::REMOVED: {
+        // an unfinished maneuver is not counted
+        maneuverStart.erase(event->vehicleId);
+        break;
+    }
+    case ManeuverEvent::ABORTED: {
+        // the end of the maneuver that follows is not counted as completed
+        maneuverStart.erase(event->vehicleId);
+        if (event->platoonId < 0) break;
+        platoons[event->platoonId].abortedManeuvers++;
+        break;
+    }
+    }
+}
+
+void PlatoonKpi::finish()
+{
+    for (auto& platoon : platoons) {
+        const Kpis& kpis = platoon.second;
+        std::string prefix = "platoon" + std::to_string(platoon.first) + ".";
+
+        if (std::isfinite(kpis.minGap)) recordScalar((prefix + "minGap").c_str(), kpis.minGap);
+        if (std::isfinite(kpis.minTimeToCollision)) recordScalar((prefix + "minTimeToCollision").c_str(), kpis.minTimeToCollision);
+
+        double amplification = 0;
+        for (int i = 1; i < (int) kpis.peakAcceleration.size(); i++) {
+            if (kpis.peakAcceleration[i - 1] > 0) amplification = std::max(amplification, kpis.peakAcceleration[i] / kpis.peakAcceleration[i - 1]);
+        }
+        if (amplification > 0) recordScalar((prefix + "stringStability").c_str(), amplification);
+
+        if (kpis.maneuvers > 0) {
+            recordScalar((prefix + "maneuvers").c_str(), kpis.maneuvers);
+            recordScalar((prefix + "meanManeuverTime").c_str(), kpis.totalManeuverTime / kpis.maneuvers);
+            recordScalar((prefix + "maxManeuverTime").c_str(), kpis.maxManeuverTime);
+        }
+        if (kpis.abortedManeuvers > 0) recordScalar((prefix + "abortedManeuvers").c_str(), kpis.abortedManeuvers);
+        if (kpis.interruptions > 0) {
+            recordScalar((prefix + "overtakeInterruptions").c_str(), kpis.interruptions);
+            recordScalar((prefix + "meanInterruptionLatency").c_str(), kpis.totalInterruptionLatency / kpis.interruptions);
+            recordScalar((prefix + "maxInterruptionLatency").c_str(), kpis.maxInterruptionLatency);
+        }
+    }
+}
+
+} // namespace plexe
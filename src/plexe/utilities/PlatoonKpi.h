@@ -0,0 +1,130 @@
+//
+// Copyright (C) 2012-2021 Michele Segata <segata@ccs-labs.org>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#ifndef PLATOONKPI_H_
+#define PLATOONKPI_H_
+
+#include <map>
+#include <vector>
+
+#include "plexe/plexe.h"
+
+namespace plexe {
+
+/**
+ * State of a vehicle sampled by BaseApp, emitted with
+ * PlatoonKpi::vehicleSampleSignal
+ */
+class VehicleSample : public cObject {
+public:
+    int vehicleId = -1;
+    int platoonId = -1;
+    int position = -1;
+    // radar measurements. distance is negative if there is no vehicle in front
+    double distance = -1;
+    double relativeSpeed = 0;
+    double acceleration = 0;
+};
+
+/**
+ * Maneuver state transition, emitted with PlatoonKpi::maneuverEventSignal
+ */
+class ManeuverEvent : public cObject {
+public:
+    enum Type {
+        // the vehicle entered or left a maneuver
+        STARTED,
+        ENDED,
+        // the leader detected a hazard, and paused the overtakers because of it
+        HAZARD,
+        INTERRUPTED,
+        // the hazard detected by the leader is over
+        HAZARD_CLEARED,
+        // the vehicle left the simulation, dropping any maneuver in progress
+        REMOVED,
+        // the vehicle gave up the maneuver because a message could not be
+        // delivered. emitted before leaving the maneuver
+        ABORTED,
+    };
+    Type type = STARTED;
+    int vehicleId = -1;
+    int platoonId = -1;
+};
+
+/**
+ * Computes platoon key performance indicators during the simulation, so
+ * that common studies do not need to record and parse full vectors. The
+ * module listens to the samples emitted by the applications and to the
+ * maneuver transitions of GeneralPlatooningApp, updating each indicator in
+ * constant time per sample. At the end of the simulation it records, for
+ * each platoon:
+ * - minGap: minimum distance between two consecutive vehicles
+ * - minTimeToCollision: minimum time to collision among closing vehicles
+ * - stringStability: maximum ratio between the peak absolute acceleration
+ * of a vehicle and the one of the vehicle in front (> 1 means amplification)
+ * - maneuvers, meanManeuverTime, maxManeuverTime: number and duration of
+ * the maneuvers completed by its members
+ * - abortedManeuvers: number of maneuvers given up by its members because
+ * of undelivered messages
+ * - overtakeInterruptions, meanInterruptionLatency, maxInterruptionLatency:
+ * number of overtakes paused because of a hazard and time between the
+ * hazard and the pause order
+ */
+class PlatoonKpi : public cSimpleModule, public cListener {
+
+public:
+    static const simsignal_t vehicleSampleSignal;
+    static const simsignal_t maneuverEventSignal;
+
+    virtual void initialize() override;
+    virtual void finish() override;
+
+    using cListener::receiveSignal;
+    virtual void receiveSignal(cComponent* source, simsignal_t signalID, cObject* obj, cObject* details) override;
+
+protected:
+    struct Kpis {
+        double minGap = INFINITY;
+        double minTimeToCollision = INFINITY;
+        // peak absolute acceleration of each platoon position
+        std::vector<double> peakAcceleration;
+        long maneuvers = 0;
+        simtime_t totalManeuverTime;
+        simtime_t maxManeuverTime;
+        long abortedManeuvers = 0;
+        long interruptions = 0;
+        simtime_t totalInterruptionLatency;
+        simtime_t maxInterruptionLatency;
+        // start of the hazard not yet handled, or -1
+        simtime_t hazardStart = -1;
+    };
+
+    void onVehicleSample(const VehicleSample* sample);
+    void onManeuverEvent(const ManeuverEvent* event);
+
+    // indicators of each platoon, by platoon id
+    std::map<int, Kpis> platoons;
+    // time at which each vehicle in a maneuver started it, by vehicle id
+    std::map<int, simtime_t> maneuverStart;
+};
+
+} // namespace plexe
+
+#endif
@@ -0,0 +1,150 @@
+//
+// Copyright (C) 2012-2021 Michele Segata <segata@ccs-labs.org>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include "plexe/utilities/QuantileSketch.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace plexe {
+
+QuantileSketch::QuantileSketch(double relativeAccuracy)
+    : relativeAccuracy(relativeAccuracy)
+{
+    ASSERT2(relativeAccuracy > 0 && relativeAccuracy < 1, "the accuracy of a quantile sketch must be between 0 and 1");
+    gamma = (1 + relativeAccuracy) / (1 - relativeAccuracy);
+    logGamma = std::log(gamma);
+    minIndexable = 1e-9;
+    clear();
+}
+
+void QuantileSketch::Store::add(int index, long n)
+{
+    if (counts.empty()) {
+        offset = index;
+        counts.push_back(0);
+    }
+    else if (index < offset) {
+        counts.insert(counts.begin(), offset - index, 0);
+        offset = index;
+    }
+    else if (index - offset >= (int) counts.size()) {
+        counts.resize(index - offset + 1, 0);
+    }
+    counts[index - offset] += n;
+}
+
+int QuantileSketch::bucketIndex(double value) const
+{
+    return (int) std::ceil(std::log(value) / logGamma);
+}
+
+double QuantileSketch::bucketValue(int index) const
+{
+    // center of the bucket in terms of relative error
+    return 2 * std::pow(gamma, index) / (gamma + 1);
+}
+
+void QuantileSketch::add(double value)
+{
+    if (std::isnan(value)) return;
+    if (value > minIndexable)
+        positive.add(bucketIndex(value), 1);
+    else if (value < -minIndexable)
+        negative.add(bucketIndex(-value), 1);
+    else
+        zeroCount++;
+    count++;
+    min = std::min(min, value);
+    max = std::max(max, value);
+}
+
+void QuantileSketch::merge(const QuantileSketch& other)
+{
+    ASSERT2(other.relativeAccuracy == relativeAccuracy, "cannot merge quantile sketches with different accuracy");
+    for (int i = 0; i < (int) other.positive.counts.size(); i++) {
+        if (other.positive.counts[i] > 0) positive.add(other.positive.offset + i, other.positive.counts[i]);
+    }
+    for (int i = 0; i < (int) other.negative.counts.size(); i++) {
+        if (other.negative.counts[i] > 0) negative.add(other.negative.offset + i, other.negative.counts[i]);
+    }
+    zeroCount += other.zeroCount;
+    count += other.count;
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+}
+
+double QuantileSketch::getQuantile(double q) const
+{
+    if (count == 0) return NAN;
+    if (q <= 0) return min;
+    if (q >= 1) return max;
+
+    double rank = q * (count - 1);
+    double value;
+    long seen = 0;
+    bool found = false;
+    // negative values from the largest magnitude, then zeros, then positives
+    for (int i = (int) negative.counts.size() - 1; i >= 0 && !found; i--) {
+        seen += negative.counts[i];
+        if (seen > rank) {
+            value = -bucketValue(negative.offset + i);
+            found = true;
+        }
+    }
+    if (!found) {
+        seen += zeroCount;
+        if (seen > rank) {
+            value = 0;
+            found = true;
+        }
+    }
+    for (int i = 0; i < (int) positive.counts.size() && !found; i++) {
+        seen += positive.counts[i];
+        if (seen > rank) {
+            value = bucketValue(positive.offset + i);
+            found = true;
+        }
+    }
+    if (!found) value = max;
+    return std::min(std::max(value, min), max);
+}
+
+void QuantileSketch::clear()
+{
+    positive.counts.clear();
+    negative.counts.clear();
+    zeroCount = 0;
+    count = 0;
+    min = INFINITY;
+    max = -INFINITY;
+}
+
+void QuantileSketch::recordScalars(cComponent* component, const std::string& name) const
+{
+    if (count == 0) return;
+    component->recordScalar((name + ":count").c_str(), count);
+    component->recordScalar((name + ":p50").c_str(), getQuantile(0.5));
+    component->recordScalar((name + ":p95").c_str(), getQuantile(0.95));
+    component->recordScalar((name + ":p99").c_str(), getQuantile(0.99));
+    component->recordScalar((name + ":max").c_str(), max);
+}
+
+} // namespace plexe
@@ -0,0 +1,118 @@
+//
+// Copyright (C) 2012-2021 Michele Segata <segata@ccs-labs.org>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#ifndef QUANTILESKETCH_H_
+#define QUANTILESKETCH_H_
+
+#include <string>
+#include <vector>
+
+#include "plexe/plexe.h"
+
+namespace plexe {
+
+/**
+ * Streaming quantile estimator with bounded relative error (the DDSketch
+ * algorithm). Samples are counted in logarithmically spaced buckets, so
+ * that memory only depends on the range of the values and not on the number
+ * of samples, and any quantile is returned with a relative error of at most
+ * relativeAccuracy. Sketches with the same accuracy can be merged, e.g., to
+ * compute platoon-wide statistics from the ones of its members. Minimum and
+ * maximum are exact.
+ */
+class QuantileSketch {
+
+public:
+    explicit QuantileSketch(double relativeAccuracy = 0.01);
+
+    void add(double value);
+
+    /**
+     * Adds all the samples of another sketch, which must have been built
+     * with the same accuracy
+     */
+    void merge(const QuantileSketch& other);
+
+    /**
+     * Returns the estimate of the given quantile (between 0 and 1), or NaN
+     * if the sketch is empty
+     */
+    double getQuantile(double q) const;
+
+    long getCount() const
+    {
+        return count;
+    }
+    double getMin() const
+    {
+        return min;
+    }
+    double getMax() const
+    {
+        return max;
+    }
+
+    void clear();
+
+    /**
+     * Returns the memory allocated by the bucket counters
+     */
+    size_t getMemoryFootprint() const
+    {
+        return (positive.counts.capacity() + negative.counts.capacity()) * sizeof(long);
+    }
+
+    /**
+     * Records count, median, 95th and 99th percentile and maximum as scalars
+     * of the given module, named name:count, name:p50, name:p95, name:p99 and
+     * name:max. Nothing is recorded for an empty sketch
+     */
+    void recordScalars(cComponent* component, const std::string& name) const;
+
+private:
+    // bucket counters for values of one sign, indexed from offset on
+    struct Store {
+        std::vector<long> counts;
+        int offset = 0;
+
+        void add(int index, long n);
+    };
+
+    // index of the bucket for a (positive) value, and its representative value
+    int bucketIndex(double value) const;
+    double bucketValue(int index) const;
+
+    double relativeAccuracy;
+    double gamma;
+    double logGamma;
+    // values with a smaller magnitude are counted as zeros
+    double minIndexable;
+
+    Store positive;
+    Store negative;
+    long zeroCount;
+    long count;
+    double min;
+    double max;
+};
+
+} // namespace plexe
+
+#endif
@@ -0,0 +1,50 @@
+//
+// Copyright (C) 2012-2021 Michele Segata <segata@ccs-labs.org>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#pragma once
+
+namespace plexe {
+
+/**
+ * Interface for the submodules of a vehicle that can be parked by the
+ * scenario manager when the vehicle leaves the simulation, and reused for a
+ * new vehicle instead of building a new module from scratch.
+ *
+ * When the vehicle leaves, the scenario manager calls finish(), removes all
+ * pending events directed to the vehicle and unsubscribes its submodules
+ * from all signals of the vehicle. It then calls resetForReuse(). When the
+ * module is reused, initialize() is called again for all stages.
+ */
+class RecyclableModule {
+public:
+    RecyclableModule(){};
+    virtual ~RecyclableModule(){};
+
+    /**
+     * Frees what initialize() allocated (timers, maneuvers, registrations
+     * in global managers) and clears any per-vehicle state that initialize()
+     * does not set. Output vectors must not be freed or renamed: OMNeT++
+     * does not allow renaming a vector that already recorded data, so they
+     * are named once and keep recording for the next vehicle
+     */
+    virtual void resetForReuse() = 0;
+};
+
+} // namespace plexe
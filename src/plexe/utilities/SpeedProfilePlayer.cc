@@ -0,0 +1,161 @@
+//
+// Copyright (C) 2012-2021 Michele Segata <segata@ccs-labs.org>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include "plexe/utilities/SpeedProfilePlayer.h"
+
+#include <cmath>
+#include <fstream>
+#include <set>
+#include <sstream>
+
+namespace plexe {
+
+SpeedProfilePlayer& SpeedProfilePlayer::getInstance()
+{
+    static SpeedProfilePlayer instance;
+    return instance;
+}
+
+const SpeedProfile* SpeedProfilePlayer::loadProfile(const std::string& file, double valueScale)
+{
+    std::stringstream key;
+    key << file << ";" << valueScale;
+    auto cached = profiles.find(key.str());
+    if (cached != profiles.end()) return cached->second.get();
+
+    std::ifstream in(file);
+    if (!in) throw cRuntimeError("Unable to open speed profile %s", file.c_str());
+
+    std::unique_ptr<SpeedProfile> profile(new SpeedProfile());
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        lineNumber++;
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#') continue;
+        for (char& c : line) {
+            if (c == ',' || c == ';') c = ' ';
+        }
+        std::istringstream fields(line);
+        double time, value;
+        if (!(fields >> time >> value)) throw cRuntimeError("Invalid sample in speed profile %s, line %d", file.c_str(), lineNumber);
+        if (!profile->times.empty() && time <= profile->times.back()) throw cRuntimeError("Sample times must be increasing in speed profile %s, line %d", file.c_str(), lineNumber);
+        profile->times.push_back(time);
+        profile->values.push_back(value * valueScale);
+    }
+    if (profile->times.empty()) throw cRuntimeError("Speed profile %s has no samples", file.c_str());
+
+    const SpeedProfile* loaded = profile.get();
+    profiles[key.str()] = std::move(profile);
+    return loaded;
+}
+
+void SpeedProfilePlayer::addVehicle(traci::CommandInterface* cifc, const std::string& nodeId, const SpeedProfile* profile, ProfileType type, simtime_t start, bool loop)
+{
+    ASSERT2(vehicleIndex.find(nodeId) == vehicleIndex.end(), "vehicle is already playing a profile");
+    PlayingVehicle vehicle;
+    vehicle.cifc = cifc;
+    vehicle.nodeId = nodeId;
+    vehicle.profile = profile;
+    vehicle.type = type;
+    vehicle.start = start;
+    vehicle.loop = loop;
+    vehicle.cursor = 0;
+    vehicle.lastValue = NAN;
+    vehicle.finished = false;
+    vehicleIndex[nodeId] = vehicles.size();
+    vehicles.push_back(vehicle);
+}
+
+void SpeedProfilePlayer::removeVehicle(const std::string& nodeId)
+{
+    auto index = vehicleIndex.find(nodeId);
+    if (index == vehicleIndex.end()) return;
+    size_t i = index->second;
+    vehicleIndex.erase(index);
+    // order does not matter, so move the last vehicle into the hole
+    if (i != vehicles.size() - 1) {
+        vehicles[i] = vehicles.back();
+        vehicleIndex[vehicles[i].nodeId] = i;
+    }
+    vehicles.pop_back();
+}
+
+double SpeedProfilePlayer::getValue(PlayingVehicle& vehicle, double t) const
+{
+    const std::vector<double>& times = vehicle.profile->times;
+    const std::vector<double>& values = vehicle.profile->values;
+
+    if (t <= times.front()) return values.front();
+    if (t >= times.back()) return values.back();
+
+    // time only moves forward, so the cursor is advanced by a few samples
+    // at most at each step
+    if (times[vehicle.cursor] > t) vehicle.cursor = 0;
+    while (vehicle.cursor + 1 < times.size() && times[vehicle.cursor + 1] <= t) vehicle.cursor++;
+
+    size_t i = vehicle.cursor;
+    double w = (t - times[i]) / (times[i + 1] - times[i]);
+    return values[i] * (1 - w) + values[i + 1] * w;
+}
+
+void SpeedProfilePlayer::step(simtime_t time)
+{
+    std::set<traci::CommandInterface*> interfaces;
+    for (PlayingVehicle& vehicle : vehicles) {
+        if (vehicle.finished || time < vehicle.start) continue;
+
+        double t = (time - vehicle.start).dbl();
+        double duration = vehicle.profile->times.back();
+        if (t > duration) {
+            if (vehicle.loop && duration > 0) {
+                t = std::fmod(t, duration);
+            }
+            else {
+                // stop imposing accelerations and keep the last speed
+                if (vehicle.type == ACCELERATION) vehicle.cifc->vehicle(vehicle.nodeId).queueFixedAcceleration(0, 0);
+                vehicle.finished = true;
+                interfaces.insert(vehicle.cifc);
+                continue;
+            }
+        }
+
+        double value = getValue(vehicle, t);
+        if (value == vehicle.lastValue) continue;
+        vehicle.lastValue = value;
+
+        if (vehicle.type == SPEED)
+            vehicle.cifc->vehicle(vehicle.nodeId).queueCruiseControlDesiredSpeed(value);
+        else
+            vehicle.cifc->vehicle(vehicle.nodeId).queueFixedAcceleration(1, value);
+        interfaces.insert(vehicle.cifc);
+    }
+
+    for (traci::CommandInterface* cifc : interfaces) cifc->sendQueuedParameters();
+}
+
+void SpeedProfilePlayer::clear()
+{
+    vehicles.clear();
+    vehicleIndex.clear();
+    profiles.clear();
+}
+
+} // namespace plexe
@@ -0,0 +1,131 @@
+//
+// Copyright (C) 2012-2021 Michele Segata <segata@ccs-labs.org>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#ifndef SPEEDPROFILEPLAYER_H_
+#define SPEEDPROFILEPLAYER_H_
+
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "plexe/plexe.h"
+#include "plexe/mobility/CommandInterface.h"
+
+namespace plexe {
+
+/**
+ * Time series loaded from a trace file, shared by all vehicles playing it
+ */
+struct SpeedProfile {
+    // sample times, relative to the beginning of the trace
+    std::vector<double> times;
+    // speed (m/s) or acceleration (m/s^2) samples
+    std::vector<double> values;
+};
+
+/**
+ * Plays speed or acceleration traces (e.g., drive cycles or recorded logs)
+ * on a set of vehicles. Instead of having one timer and one TraCI round trip
+ * per vehicle, the player is stepped once per SUMO step by the PlexeManager
+ * and sends the commands for all vehicles in a single TraCI message. Traces
+ * are loaded only once, no matter how many vehicles use them.
+ */
+class SpeedProfilePlayer {
+
+public:
+    enum ProfileType {
+        SPEED,
+        ACCELERATION,
+    };
+
+    static SpeedProfilePlayer& getInstance();
+
+    /**
+     * Loads a trace file, or returns the cached copy if already loaded. The
+     * file has two columns, time in seconds and value, separated by spaces,
+     * tabs or commas. Lines starting with # are ignored
+     *
+     * @param file path of the trace
+     * @param valueScale factor applied to the values, e.g., to convert km/h
+     */
+    const SpeedProfile* loadProfile(const std::string& file, double valueScale = 1);
+
+    /**
+     * Starts playing a profile on a vehicle
+     *
+     * @param cifc the command interface used to control the vehicle
+     * @param nodeId the SUMO id of the vehicle
+     * @param profile the profile to play
+     * @param type whether the profile is a speed or an acceleration trace
+     * @param start the simulation time corresponding to the beginning of
+     * the trace
+     * @param loop whether to restart the trace when it ends
+     */
+    void addVehicle(traci::CommandInterface* cifc, const std::string& nodeId, const SpeedProfile* profile, ProfileType type, simtime_t start, bool loop);
+
+    /**
+     * Stops playing a profile on a vehicle
+     */
+    void removeVehicle(const std::string& nodeId);
+
+    /**
+     * Computes the commands for all vehicles at the given time and sends
+     * them to SUMO
+     */
+    void step(simtime_t time);
+
+    /**
+     * Removes all vehicles and cached profiles
+     */
+    void clear();
+
+private:
+    SpeedProfilePlayer()
+    {
+    }
+
+    struct PlayingVehicle {
+        traci::CommandInterface* cifc;
+        std::string nodeId;
+        const SpeedProfile* profile;
+        ProfileType type;
+        simtime_t start;
+        bool loop;
+        // index of the last sample before the current time
+        size_t cursor;
+        // last value sent to SUMO, to avoid sending unchanged values
+        double lastValue;
+        bool finished;
+    };
+
+    // returns the value of the profile at the given time, advancing the cursor
+    double getValue(PlayingVehicle& vehicle, double t) const;
+
+    std::map<std::string, std::unique_ptr<SpeedProfile>> profiles;
+    // vehicles are kept contiguous, with an index for removals
+    std::vector<PlayingVehicle> vehicles;
+    std::unordered_map<std::string, size_t> vehicleIndex;
+};
+
+} // namespace plexe
+
+#endif
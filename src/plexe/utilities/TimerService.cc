@@ -0,0 +1,159 @@
+//
+// Copyright (C) 2012-2021 Michele Segata <segata@ccs-labs.org>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include "plexe/utilities/TimerService.h"
+
+#include "plexe/utilities/EventProfiler.h"
+
+namespace plexe {
+
+Define_Module(TimerService);
+
+TimerService* TimerService::instance = nullptr;
+
+TimerService::~TimerService()
+{
+    if (instance == this) instance = nullptr;
+    cancelAndDelete(tick);
+}
+
+void TimerService::initialize()
+{
+    instance = this;
+    timers.clear();
+    freeTimers.clear();
+    expirations.clear();
+    ticks = 0;
+    firedTimers = 0;
+    tick = new cMessage("tick");
+}
+
+void TimerService::finish()
+{
+    recordScalar("ticks", ticks);
+    recordScalar("firedTimers", firedTimers);
+}
+
+TimerService* TimerService::get()
+{
+    return instance;
+}
+
+int TimerService::addTimer(cComponent* owner, const char* name, simtime_t first, simtime_t period, Callback callback)
+{
+    Enter_Method_Silent();
+    ASSERT2(period > 0, "timer period must be positive");
+    if (first < simTime()) throw cRuntimeError("Cannot add a timer expiring in the past");
+
+    int timerId;
+    if (freeTimers.empty()) {
+        timerId = timers.size();
+        timers.push_back(Timer());
+    }
+    else {
+        timerId = freeTimers.back();
+        freeTimers.pop_back();
+    }
+    Timer& timer = timers[timerId];
+    timer.owner = owner;
+    timer.name = name;
+    timer.period = period;
+    timer.callback = callback;
+    timer.active = true;
+
+    expirations[first][period].push_back(timerId);
+    scheduleTick();
+    return timerId;
+}
+
+void TimerService::removeTimer(int timerId)
+{
+    ASSERT(timerId >= 0 && timerId < (int) timers.size());
+    // the slot is freed when the timer expires, so that its id is not
+    // reused while it is still in the expiration list
+    timers[timerId].active = false;
+    timers[timerId].owner = nullptr;
+    timers[timerId].callback = nullptr;
+}
+
+void TimerService::enqueue(simtime_t time, simtime_t period, std::vector<int>& timerIds)
+{
+    std::vector<int>& list = expirations[time][period];
+    if (list.empty())
+        list.swap(timerIds);
+    else
+        list.insert(list.end(), timerIds.begin(), timerIds.end());
+}
+
+void TimerService::scheduleTick()
+{
+    if (expirations.empty()) {
+        if (tick->isScheduled()) cancelEvent(tick);
+        return;
+    }
+    simtime_t next = expirations.begin()->first;
+    if (tick->isScheduled()) {
+        if (tick->getArrivalTime() == next) return;
+        cancelEvent(tick);
+    }
+    scheduleAt(next, tick);
+}
+
+void TimerService::handleMessage(cMessage* msg)
+{
+    ASSERT(msg == tick);
+    ticks++;
+
+    // take the timers out of the list, as callbacks might add new ones
+    auto first = expirations.begin();
+    simtime_t now = first->first;
+    std::map<simtime_t, std::vector<int>> expired;
+    expired.swap(first->second);
+    expirations.erase(first);
+
+    for (auto& group : expired) {
+        simtime_t period = group.first;
+        std::vector<int>& timerIds = group.second;
+        for (int timerId : timerIds) {
+            // callbacks can remove any timer, so check before firing
+            if (!timers[timerId].active) continue;
+            firedTimers++;
+            // the callback might add timers, moving the table
+            Callback callback = timers[timerId].callback;
+            cContextSwitcher context(timers[timerId].owner);
+            EventProfiler::Scope profilerScope(timers[timerId].owner, "handleMessage", timers[timerId].name);
+            callback();
+        }
+        // reschedule the timers which are still active with the same period
+        std::vector<int> active;
+        active.reserve(timerIds.size());
+        for (int timerId : timerIds) {
+            if (timers[timerId].active)
+                active.push_back(timerId);
+            else
+                freeTimers.push_back(timerId);
+        }
+        if (!active.empty()) enqueue(now + period, period, active);
+    }
+
+    scheduleTick();
+}
+
+} // namespace plexe
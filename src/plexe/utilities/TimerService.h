@@ -0,0 +1,117 @@
+//
+// Copyright (C) 2012-2021 Michele Segata <segata@ccs-labs.org>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#pragma once
+
+#include <functional>
+#include <map>
+#include <vector>
+
+#include "plexe/plexe.h"
+
+namespace plexe {
+
+/**
+ * Shared service for the periodic timers of vehicles. Instead of scheduling
+ * one self-message per timer, modules register a callback with a period, and
+ * all the timers expiring at the same time are fired by a single event of
+ * the service. Timers of different vehicles with the same period and phase
+ * (e.g., statistics recorded on a common time grid) thus cost one event per
+ * expiration in the future event set instead of one per vehicle.
+ *
+ * Expiration times are never rounded, so timers which are not aligned are
+ * fired at the same times they would be with their own self-messages, only
+ * without saving events. Timers expiring at the same time are fired in
+ * ascending order of period and then in registration order, and before or
+ * after other events scheduled for that time depending on the event set.
+ *
+ * Callbacks are executed in the context of the module owning the timer,
+ * and profiled by EventProfiler as the handleMessage event of the owner
+ * named after the timer, as its self-message would be. Timers must be
+ * removed by their owner when it is deleted or reset for reuse.
+ */
+class TimerService : public cSimpleModule {
+
+public:
+    typedef std::function<void()> Callback;
+
+    TimerService()
+        : tick(nullptr)
+        , ticks(0)
+        , firedTimers(0)
+    {
+    }
+    virtual ~TimerService();
+
+    virtual void initialize() override;
+    virtual void finish() override;
+
+    /**
+     * Returns the timer service of the running simulation, or nullptr if
+     * the network does not include one. Only valid after the network has
+     * been initialized
+     */
+    static TimerService* get();
+
+    /**
+     * Registers a timer firing for the first time at the given time and
+     * then every period. The name must be a string literal. Returns the id
+     * to be used to remove the timer
+     */
+    int addTimer(cComponent* owner, const char* name, simtime_t first, simtime_t period, Callback callback);
+
+    /**
+     * Stops a timer. The callback is not invoked anymore, even if the timer
+     * expires at the current time and has not been fired yet
+     */
+    void removeTimer(int timerId);
+
+protected:
+    virtual void handleMessage(cMessage* msg) override;
+
+    // inserts a list of timers with the same period in the expiration list
+    void enqueue(simtime_t time, simtime_t period, std::vector<int>& timerIds);
+    // schedules the tick event at the earliest expiration
+    void scheduleTick();
+
+    typedef struct {
+        cComponent* owner;
+        const char* name;
+        simtime_t period;
+        Callback callback;
+        bool active;
+    } Timer;
+
+    static TimerService* instance;
+
+    // timers by id. slots of removed timers are reused once the timer is
+    // dropped from the expiration list
+    std::vector<Timer> timers;
+    std::vector<int> freeTimers;
+    // timers by expiration time and period
+    std::map<simtime_t, std::map<simtime_t, std::vector<int>>> expirations;
+    cMessage* tick;
+
+    // statistics
+    long ticks;
+    long firedTimers;
+};
+
+} // namespace plexe
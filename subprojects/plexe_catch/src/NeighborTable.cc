@@ -0,0 +1,102 @@
+//
+// Copyright (C) 2012-2021 Michele Segata <segata@ccs-labs.org>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include "catch2/catch.hpp"
+
+#include "testutils/Simulation.h"
+
+#include "plexe/utilities/NeighborTable.h"
+
+using namespace plexe;
+using omnetpp::SimTime;
+
+namespace {
+
+void setTime(double time)
+{
+    omnetpp::getSimulation()->setSimTime(SimTime(time));
+}
+
+Neighbor beacon(int vehicleId, int platoonId, int platoonPosition, int lane, double position)
+{
+    Neighbor neighbor;
+    neighbor.vehicleId = vehicleId;
+    neighbor.platoonId = platoonId;
+    neighbor.platoonPosition = platoonPosition;
+    neighbor.lane = lane;
+    neighbor.position = position;
+    neighbor.time = omnetpp::simTime();
+    return neighbor;
+}
+
+} // namespace
+
+TEST_CASE("NeighborTable", "[neighbors]")
+{
+    DummySimulation ds(new omnetpp::cNullEnvir(0, nullptr, nullptr));
+    NeighborTable table(1);
+    setTime(0);
+    // platoon 10 on lane 0, a vehicle driving alone ahead of it and
+    // platoon 20 on lane 1
+    table.update(beacon(1, 10, 0, 0, 100));
+    table.update(beacon(2, 10, 1, 0, 90));
+    table.update(beacon(3, -1, -1, 0, 120));
+    table.update(beacon(4, 20, 0, 1, 110));
+
+    SECTION("the nearest platoon member ahead is found")
+    {
+        REQUIRE(table.findPlatoonAhead(50, 0, 100)->vehicleId == 2);
+        REQUIRE(table.findPlatoonAhead(95, 0, 100)->vehicleId == 1);
+        REQUIRE(table.findPlatoonAhead(50, 1, 100)->vehicleId == 4);
+        // out of distance
+        REQUIRE(table.findPlatoonAhead(50, 0, 30) == nullptr);
+        // vehicles driving alone are not platoons
+        REQUIRE(table.findPlatoonAhead(50, 0, 100, 10) == nullptr);
+        REQUIRE(table.findPlatoonAhead(50, 2, 100) == nullptr);
+        REQUIRE(table.getPlatoonLeader(10) == 1);
+        REQUIRE(table.getPlatoonLeader(30) == -1);
+    }
+
+    SECTION("moving vehicles are indexed at their new position")
+    {
+        setTime(0.5);
+        table.update(beacon(2, 10, 1, 1, 105));
+        REQUIRE(table.findPlatoonAhead(50, 0, 100)->vehicleId == 1);
+        REQUIRE(table.findPlatoonAhead(100, 1, 100)->vehicleId == 2);
+        REQUIRE(table.size() == 4);
+    }
+
+    SECTION("entries expire after the timeout")
+    {
+        setTime(0.8);
+        table.update(beacon(1, 10, 0, 0, 100));
+        setTime(1.5);
+        REQUIRE(table.getNeighbor(2) == nullptr);
+        REQUIRE(table.getNeighbor(1) != nullptr);
+        REQUIRE(table.findPlatoonAhead(50, 0, 100)->vehicleId == 1);
+        REQUIRE(table.getPlatoonLeader(10) == 1);
+        setTime(2);
+        REQUIRE(table.getPlatoonLeader(10) == -1);
+        REQUIRE(table.findPlatoonAhead(50, 0, 100) == nullptr);
+        // updates drop the stale entries nobody asked for
+        table.update(beacon(5, -1, -1, 2, 0));
+        REQUIRE(table.size() == 1);
+    }
+}
@@ -0,0 +1,59 @@
+//
+// Copyright (C) 2012-2021 Michele Segata <segata@ccs-labs.org>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include "catch2/catch.hpp"
+
+#include "plexe/utilities/PlatoonFormation.h"
+
+using namespace plexe;
+
+TEST_CASE("PlatoonFormation", "[formation]")
+{
+    // ids not sorted and far apart
+    PlatoonFormation formation({42, 7, 1000000, 3});
+
+    SECTION("positions do not depend on the order of the ids")
+    {
+        REQUIRE(formation.size() == 4);
+        REQUIRE(formation.getPosition(42) == 0);
+        REQUIRE(formation.getPosition(7) == 1);
+        REQUIRE(formation.getPosition(1000000) == 2);
+        REQUIRE(formation.getPosition(3) == 3);
+        for (int i = 0; i < formation.size(); i++) REQUIRE(formation.getPosition(formation.getMemberId(i)) == i);
+    }
+
+    SECTION("unknown vehicles and positions")
+    {
+        REQUIRE(formation.getPosition(5) == -1);
+        REQUIRE(formation.getPosition(0) == -1);
+        REQUIRE(formation.getPosition(2000000) == -1);
+        REQUIRE(formation.getMemberId(4) == -1);
+        REQUIRE(formation.getMemberId(-1) == -1);
+    }
+
+    SECTION("empty slots are not indexed")
+    {
+        PlatoonFormation withGap({5, -1, 9});
+        REQUIRE(withGap.size() == 3);
+        REQUIRE(withGap.getPosition(-1) == -1);
+        REQUIRE(withGap.getPosition(9) == 2);
+        REQUIRE(withGap.getMemberId(1) == -1);
+    }
+}
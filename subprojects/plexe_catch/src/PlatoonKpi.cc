@@ -0,0 +1,73 @@
+//
+// Copyright (C) 2012-2021 Michele Segata <segata@ccs-labs.org>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include "catch2/catch.hpp"
+
+#include "testutils/Simulation.h"
+
+#include "plexe/utilities/PlatoonKpi.h"
+
+using namespace plexe;
+using omnetpp::SimTime;
+
+namespace {
+
+class TestPlatoonKpi : public PlatoonKpi {
+public:
+    using PlatoonKpi::onManeuverEvent;
+    using PlatoonKpi::platoons;
+};
+
+void emitAt(TestPlatoonKpi& kpi, double time, ManeuverEvent::Type type, int vehicleId = 0, int platoonId = 0)
+{
+    omnetpp::getSimulation()->setSimTime(SimTime(time));
+    ManeuverEvent event;
+    event.type = type;
+    event.vehicleId = vehicleId;
+    event.platoonId = platoonId;
+    kpi.onManeuverEvent(&event);
+}
+
+} // namespace
+
+TEST_CASE("PlatoonKpi", "[kpi]")
+{
+    DummySimulation ds(new omnetpp::cNullEnvir(0, nullptr, nullptr));
+    TestPlatoonKpi kpi;
+
+    SECTION("interruption latency is measured from the first hazard")
+    {
+        emitAt(kpi, 1, ManeuverEvent::HAZARD);
+        emitAt(kpi, 2, ManeuverEvent::HAZARD);
+        emitAt(kpi, 3, ManeuverEvent::INTERRUPTED);
+        REQUIRE(kpi.platoons[0].interruptions == 1);
+        REQUIRE(kpi.platoons[0].maxInterruptionLatency == SimTime(2));
+    }
+
+    SECTION("a cleared hazard does not inflate the latency of the next one")
+    {
+        emitAt(kpi, 1, ManeuverEvent::HAZARD);
+        emitAt(kpi, 2, ManeuverEvent::HAZARD_CLEARED);
+        emitAt(kpi, 5, ManeuverEvent::HAZARD);
+        emitAt(kpi, 5.5, ManeuverEvent::INTERRUPTED);
+        REQUIRE(kpi.platoons[0].interruptions == 1);
+        REQUIRE(kpi.platoons[0].totalInterruptionLatency == SimTime(0.5));
+    }
+}
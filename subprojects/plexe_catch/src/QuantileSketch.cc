@@ -0,0 +1,86 @@
+//
+// Copyright (C) 2012-2021 Michele Segata <segata@ccs-labs.org>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include "catch2/catch.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "plexe/utilities/QuantileSketch.h"
+
+using namespace plexe;
+
+TEST_CASE("QuantileSketch", "[sketch]")
+{
+    const double alpha = 0.01;
+    // delays spanning several orders of magnitude
+    std::mt19937 rng(42);
+    std::lognormal_distribution<double> delay(-3, 1);
+    std::vector<double> values;
+    QuantileSketch sketch(alpha);
+    for (int i = 0; i < 10000; i++) {
+        values.push_back(delay(rng));
+        sketch.add(values.back());
+    }
+    std::sort(values.begin(), values.end());
+
+    SECTION("quantiles are within the relative accuracy")
+    {
+        for (double q : {0.01, 0.1, 0.25, 0.5, 0.75, 0.9, 0.95, 0.99}) {
+            double exact = values[(size_t)(q * (values.size() - 1))];
+            REQUIRE(std::fabs(sketch.getQuantile(q) - exact) <= alpha * exact * (1 + 1e-9));
+        }
+        REQUIRE(sketch.getCount() == (long) values.size());
+        REQUIRE(sketch.getMin() == values.front());
+        REQUIRE(sketch.getMax() == values.back());
+        REQUIRE(sketch.getQuantile(0) == values.front());
+        REQUIRE(sketch.getQuantile(1) == values.back());
+    }
+
+    SECTION("negative values and zeros are ordered")
+    {
+        QuantileSketch gaps(alpha);
+        for (int i = -50; i <= 50; i++) gaps.add(i);
+        REQUIRE(gaps.getQuantile(0.5) == 0);
+        REQUIRE(std::fabs(gaps.getQuantile(0.1) + 40) <= alpha * 40 * (1 + 1e-9));
+        REQUIRE(std::fabs(gaps.getQuantile(0.9) - 40) <= alpha * 40 * (1 + 1e-9));
+    }
+
+    SECTION("merging is equivalent to adding all the samples")
+    {
+        QuantileSketch first(alpha);
+        QuantileSketch second(alpha);
+        for (size_t i = 0; i < values.size(); i++) (i % 3 == 0 ? first : second).add(values[i]);
+        first.merge(second);
+        REQUIRE(first.getCount() == sketch.getCount());
+        REQUIRE(first.getMin() == sketch.getMin());
+        REQUIRE(first.getMax() == sketch.getMax());
+        for (double q : {0.01, 0.1, 0.25, 0.5, 0.75, 0.9, 0.95, 0.99}) REQUIRE(first.getQuantile(q) == sketch.getQuantile(q));
+    }
+
+    SECTION("an empty sketch has no quantiles")
+    {
+        sketch.clear();
+        REQUIRE(sketch.getCount() == 0);
+        REQUIRE(std::isnan(sketch.getQuantile(0.5)));
+    }
+}
@@ -0,0 +1,76 @@
+//
+// Copyright (C) 2012-2021 Michele Segata <segata@ccs-labs.org>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include "catch2/catch.hpp"
+
+#include <sstream>
+
+#include "testutils/Simulation.h"
+
+#include "plexe/driver/RadioTrace.h"
+
+using namespace plexe;
+using omnetpp::SIMTIME_MS;
+using omnetpp::SimTime;
+
+TEST_CASE("RadioTrace", "[trace]")
+{
+    DummySimulation ds(new omnetpp::cNullEnvir(0, nullptr, nullptr));
+    std::istringstream events("T 1 1.0 5 -1 0 800\n"
+                              "D 1 1.001 6\n"
+                              "D 1 1.002 7\n"
+                              "T 2 1.1 5 6 0 800\n"
+                              "F 2 1.2\n"
+                              "T 3 2.0 5 -1 0 800\n"
+                              "T 4 2.05 5 -1 0 800\n"
+                              "D 9 2.1 6\n");
+    RadioTrace& trace = RadioTrace::getInstance();
+    trace.parse(events, "test");
+
+    SECTION("frames are matched to the closest transmission to the same destination")
+    {
+        RadioTrace::Transmission* broadcast = trace.match(5, -1, SimTime(1020, SIMTIME_MS), SimTime(100, SIMTIME_MS));
+        REQUIRE(broadcast);
+        REQUIRE(broadcast->time == SimTime(1000, SIMTIME_MS));
+        REQUIRE(broadcast->deliveries.size() == 2);
+        REQUIRE(broadcast->deliveries[0].receiver == 6);
+        REQUIRE(broadcast->deliveries[0].delay == SimTime(1, SIMTIME_MS));
+
+        RadioTrace::Transmission* unicast = trace.match(5, 6, SimTime(1000, SIMTIME_MS), SimTime(200, SIMTIME_MS));
+        REQUIRE(unicast);
+        REQUIRE(unicast->time == SimTime(1100, SIMTIME_MS));
+        REQUIRE(unicast->failed);
+        REQUIRE(unicast->failureDelay == SimTime(100, SIMTIME_MS));
+    }
+
+    SECTION("each transmission is replayed once")
+    {
+        REQUIRE(trace.match(5, -1, SimTime(2040, SIMTIME_MS), SimTime(100, SIMTIME_MS))->time == SimTime(2050, SIMTIME_MS));
+        REQUIRE(trace.match(5, -1, SimTime(2040, SIMTIME_MS), SimTime(100, SIMTIME_MS))->time == SimTime(2000, SIMTIME_MS));
+        REQUIRE(trace.match(5, -1, SimTime(2040, SIMTIME_MS), SimTime(100, SIMTIME_MS)) == nullptr);
+    }
+
+    SECTION("no match outside the window or for unknown senders")
+    {
+        REQUIRE(trace.match(5, -1, SimTime(1500, SIMTIME_MS), SimTime(100, SIMTIME_MS)) == nullptr);
+        REQUIRE(trace.match(5, 7, SimTime(1100, SIMTIME_MS), SimTime(100, SIMTIME_MS)) == nullptr);
+        REQUIRE(trace.match(6, -1, SimTime(1000, SIMTIME_MS), SimTime(1000, SIMTIME_MS)) == nullptr);
+    }
+}
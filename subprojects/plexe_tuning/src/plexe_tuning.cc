@@ -0,0 +1,555 @@
+//
+// Copyright (C) 2012-2021 Michele Segata <segata@ccs-labs.org>
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+/**
+ * Offline evaluator of the longitudinal controllers of Plexe.
+ *
+ * Simulates the longitudinal dynamics of a platoon for a grid of controller
+ * parameters and platoon sizes, without SUMO and OMNeT++, and reports the
+ * minimum gap and the string stability of each combination. The control
+ * laws and the first order lag engine are the ones of the Plexe car
+ * following model, the parameters are the ones of BaseScenario and the
+ * controllers are the ACTIVE_CONTROLLER values of CC_Const.h.
+ *
+ * Combinations are simulated in batches, one combination per SIMD lane: the
+ * state of the platoons is stored as a structure of arrays indexed by
+ * vehicle and then by combination, so that the inner loops over the
+ * combinations are vectorized by the compiler. Batches are distributed
+ * among threads.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "plexe/CC_Const.h"
+
+using namespace plexe;
+
+namespace {
+
+// number of combinations simulated together, one per SIMD lane
+const int BATCH_SIZE = 256;
+// vehicle length, as in the vehicle types of the examples
+const double VEHICLE_LENGTH = 4;
+// gain of the cruise control driving the leader and of the ACC (SUMO defaults)
+const double CC_KP = 1;
+const double ACC_LAMBDA = 0.1;
+// standstill distance of ACC and PLOEG
+const double STANDSTILL_DISTANCE = 2;
+
+/**
+ * A controller parameter that can be explored. name is the parameter of
+ * BaseScenario, sumoName the one used to set it in SUMO
+ */
+struct ParameterDefinition {
+    std::string name;
+    std::string sumoName;
+    double defaultValue;
+    // controller using the parameter, or DRIVER if used by all
+    ACTIVE_CONTROLLER controller;
+};
+
+// defaults match BBaseScenario.ned
+const std::vector<ParameterDefinition> parameterDefinitions = {
+    {"accHeadway", PAR_ACC_HEADWAY_TIME, 1.2, ACC},
+    {"caccXi", CC_PAR_CACC_XI, 1, CACC},
+    {"caccOmegaN", CC_PAR_CACC_OMEGA_N, 0.2, CACC},
+    {"caccC1", CC_PAR_CACC_C1, 0.5, CACC},
+    {"caccSpacing", PAR_CACC_SPACING, 5, CACC},
+    {"ploegH", CC_PAR_PLOEG_H, 0.5, PLOEG},
+    {"ploegKp", CC_PAR_PLOEG_KP, 0.2, PLOEG},
+    {"ploegKd", CC_PAR_PLOEG_KD, 0.7, PLOEG},
+    {"flatbedKa", CC_PAR_FLATBED_KA, 2.4, FLATBED},
+    {"flatbedKv", CC_PAR_FLATBED_KV, 0.6, FLATBED},
+    {"flatbedKp", CC_PAR_FLATBED_KP, 12, FLATBED},
+    {"flatbedH", CC_PAR_FLATBED_H, 4, FLATBED},
+    {"flatbedD", CC_PAR_FLATBED_D, 5, FLATBED},
+    {"engineTau", CC_PAR_ENGINE_TAU, 0.5, DRIVER},
+    {"uMin", CC_PAR_UMIN, -1e6, DRIVER},
+    {"uMax", CC_PAR_UMAX, 1e6, DRIVER},
+};
+
+enum LeaderScenario {
+    SINUSOIDAL,
+    BRAKING
+};
+
+struct Settings {
+    ACTIVE_CONTROLLER controller = CACC;
+    std::vector<int> sizes = {8};
+    // values of each parameter, by parameter name
+    std::map<std::string, std::vector<double>> grid;
+    LeaderScenario scenario = SINUSOIDAL;
+    double leaderSpeed = 100 / 3.6;
+    double oscillationAmplitude = 10 / 3.6;
+    double oscillationFrequency = 0.2;
+    double brakingDeceleration = 8;
+    double start = 5;
+    double duration = 60;
+    double step = 0.01;
+    double beaconingInterval = 0.1;
+    bool useControllerAcceleration = true;
+    int threads = 1;
+};
+
+/**
+ * A batch of combinations for a given platoon size. Parameters and results
+ * hold one value per lane
+ */
+struct Batch {
+    int size;
+    // index of the first combination of the batch
+    long first;
+    int lanes;
+    // parameter values, by parameter index and lane
+    std::vector<std::vector<double>> parameters;
+    std::vector<double> minGap;
+    std::vector<double> stringStability;
+};
+
+const char* controllerName(ACTIVE_CONTROLLER controller)
+{
+    switch (controller) {
+    case ACC:
+        return "ACC";
+    case CACC:
+        return "CACC";
+    case PLOEG:
+        return "PLOEG";
+    case FLATBED:
+        return "FLATBED";
+    default:
+        return "?";
+    }
+}
+
+/**
+ * Parses a list of values, either comma separated or as start:step:end
+ */
+std::vector<double> parseValues(const std::string& spec)
+{
+    std::vector<double> values;
+    if (spec.find(':') != std::string::npos) {
+        double start, step, end;
+        char c1, c2;
+        std::istringstream in(spec);
+        if (!(in >> start >> c1 >> step >> c2 >> end) || c1 != ':' || c2 != ':' || step <= 0 || end < start) throw std::invalid_argument("invalid range " + spec);
+        // tolerate rounding errors on the last value
+        long n = (long) std::floor((end - start) / step + 1e-9);
+        for (long i = 0; i <= n; i++) values.push_back(start + i * step);
+    }
+    else {
+        std::istringstream in(spec);
+        std::string value;
+        while (std::getline(in, value, ',')) values.push_back(std::stod(value));
+    }
+    if (values.empty()) throw std::invalid_argument("no values in " + spec);
+    return values;
+}
+
+bool usesParameter(ACTIVE_CONTROLLER controller, const ParameterDefinition& definition)
+{
+    return definition.controller == DRIVER || definition.controller == controller;
+}
+
+/**
+ * Simulates a batch of platoons and fills in its results
+ */
+void simulate(const Settings& settings, const std::vector<int>& parameterIndexes, Batch& batch)
+{
+    const int n = batch.size;
+    const int B = BATCH_SIZE;
+    const double dt = settings.step;
+    const long steps = (long) std::llround(settings.duration / dt);
+    const long beaconSteps = std::max(1L, (long) std::llround(settings.beaconingInterval / dt));
+
+    // parameters of each lane, by name
+    std::map<std::string, const double*> p;
+    for (int j = 0; j < (int) parameterIndexes.size(); j++) p[parameterDefinitions[parameterIndexes[j]].name] = batch.parameters[j].data();
+    auto par = [&p](const char* name) { return p.at(name); };
+    const double* tau = par("engineTau");
+    const double* uMin = par("uMin");
+    const double* uMax = par("uMax");
+
+    // per lane constants
+    std::vector<double> alpha(B), c1(B), c2(B), c3(B), c4(B), c5(B), distance(B);
+    for (int k = 0; k < B; k++) {
+        alpha[k] = dt / (tau[k] + dt);
+        switch (settings.controller) {
+        case ACC:
+            distance[k] = STANDSTILL_DISTANCE + par("accHeadway")[k] * settings.leaderSpeed;
+            break;
+        case CACC: {
+            // gains of the Rajamani CACC, as computed by the SUMO car following model
+            double xi = par("caccXi")[k];
+            double omegaN = par("caccOmegaN")[k];
+            double C1 = par("caccC1")[k];
+            double root = std::sqrt(xi * xi - 1);
+            c1[k] = 1 - C1;
+            c2[k] = C1;
+            c3[k] = -(2 * xi - C1 * (xi + root)) * omegaN;
+            c4[k] = -(xi + root) * omegaN * C1;
+            c5[k] = -omegaN * omegaN;
+            distance[k] = par("caccSpacing")[k];
+            break;
+        }
+        case PLOEG:
+            distance[k] = STANDSTILL_DISTANCE + par("ploegH")[k] * settings.leaderSpeed;
+            break;
+        case FLATBED:
+            distance[k] = par("flatbedD")[k];
+            break;
+        default:
+            break;
+        }
+    }
+
+    // state of the platoons, by vehicle and lane
+    std::vector<double> position(n * B), speed(n * B, settings.leaderSpeed), acceleration(n * B, 0), u(n * B, 0);
+    // data in the last beacon of each vehicle
+    std::vector<double> sentSpeed(n * B, settings.leaderSpeed), sentAcceleration(n * B, 0);
+    std::vector<double> peak(n * B, 0);
+    std::vector<double> minGap(B, INFINITY);
+    for (int i = 0; i < n; i++) {
+        for (int k = 0; k < B; k++) position[i * B + k] = -i * (VEHICLE_LENGTH + distance[k]);
+    }
+
+    for (long s = 0; s < steps; s++) {
+        double t = s * dt;
+
+        // leader, driven by its cruise control or braking
+        double desiredSpeed = settings.leaderSpeed;
+        bool braking = false;
+        if (t >= settings.start) {
+            if (settings.scenario == SINUSOIDAL)
+                desiredSpeed += settings.oscillationAmplitude * std::sin(2 * M_PI * settings.oscillationFrequency * (t - settings.start));
+            else
+                braking = true;
+        }
+        {
+            double* __restrict u0 = &u[0];
+            const double* __restrict v0 = &speed[0];
+            for (int k = 0; k < B; k++) u0[k] = braking ? -settings.brakingDeceleration : -CC_KP * (v0[k] - desiredSpeed);
+        }
+
+        // followers, all computed on the state at the beginning of the step
+        for (int i = 1; i < n; i++) {
+            double* __restrict ui = &u[i * B];
+            const double* __restrict v = &speed[i * B];
+            const double* __restrict a = &acceleration[i * B];
+            const double* __restrict x = &position[i * B];
+            const double* __restrict xFront = &position[(i - 1) * B];
+            const double* __restrict vFront = &speed[(i - 1) * B];
+            const double* __restrict sentVFront = &sentSpeed[(i - 1) * B];
+            const double* __restrict sentAFront = &sentAcceleration[(i - 1) * B];
+            const double* __restrict sentVLeader = &sentSpeed[0];
+            const double* __restrict sentALeader = &sentAcceleration[0];
+
+            switch (settings.controller) {
+            case ACC: {
+                const double* h = par("accHeadway");
+                for (int k = 0; k < B; k++) {
+                    double gap = xFront[k] - x[k] - VEHICLE_LENGTH;
+                    ui[k] = -1.0 / h[k] * (v[k] - vFront[k] + ACC_LAMBDA * (-gap + h[k] * v[k] + STANDSTILL_DISTANCE));
+                }
+                break;
+            }
+            case CACC: {
+                const double* spacing = par("caccSpacing");
+                for (int k = 0; k < B; k++) {
+                    double gap = xFront[k] - x[k] - VEHICLE_LENGTH;
+                    ui[k] = c1[k] * sentAFront[k] + c2[k] * sentALeader[k] + c3[k] * (v[k] - sentVFront[k]) + c4[k] * (v[k] - sentVLeader[k]) + c5[k] * (spacing[k] - gap);
+                }
+                break;
+            }
+            case PLOEG: {
+                const double* h = par("ploegH");
+                const double* kp = par("ploegKp");
+                const double* kd = par("ploegKd");
+                // the controller integrates the derivative of the control input
+                for (int k = 0; k < B; k++) {
+                    double gap = xFront[k] - x[k] - VEHICLE_LENGTH;
+                    ui[k] += dt / h[k] * (-ui[k] + kp[k] * (gap - (STANDSTILL_DISTANCE + h[k] * v[k])) + kd[k] * (vFront[k] - v[k] - h[k] * a[k]) + sentAFront[k]);
+                }
+                break;
+            }
+            case FLATBED: {
+                const double* ka = par("flatbedKa");
+                const double* kv = par("flatbedKv");
+                const double* kp = par("flatbedKp");
+                const double* h = par("flatbedH");
+                const double* d = par("flatbedD");
+                for (int k = 0; k < B; k++) {
+                    double gap = xFront[k] - x[k] - VEHICLE_LENGTH;
+                    ui[k] = -ka[k] * a[k] + kv[k] * (vFront[k] - v[k]) + kp[k] * (gap - d[k] - h[k] * (v[k] - sentVLeader[k]));
+                }
+                break;
+            }
+            default:
+                break;
+            }
+        }
+
+        // first order lag engine and integration, as in SUMO
+        for (int i = 0; i < n; i++) {
+            double* __restrict ui = &u[i * B];
+            double* __restrict a = &acceleration[i * B];
+            double* __restrict v = &speed[i * B];
+            double* __restrict x = &position[i * B];
+            double* __restrict pk = &peak[i * B];
+            for (int k = 0; k < B; k++) {
+                ui[k] = std::min(uMax[k], std::max(uMin[k], ui[k]));
+                double lagged = alpha[k] * ui[k] + (1 - alpha[k]) * a[k];
+                double newSpeed = std::max(0.0, v[k] + lagged * dt);
+                a[k] = (newSpeed - v[k]) / dt;
+                v[k] = newSpeed;
+                x[k] += newSpeed * dt;
+                pk[k] = std::max(pk[k], std::fabs(a[k]));
+            }
+        }
+
+        for (int i = 1; i < n; i++) {
+            const double* __restrict x = &position[i * B];
+            const double* __restrict xFront = &position[(i - 1) * B];
+            double* __restrict g = &minGap[0];
+            for (int k = 0; k < B; k++) g[k] = std::min(g[k], xFront[k] - x[k] - VEHICLE_LENGTH);
+        }
+
+        // all vehicles beacon at the same time
+        if ((s + 1) % beaconSteps == 0) {
+            const std::vector<double>& sent = settings.useControllerAcceleration ? u : acceleration;
+            std::copy(speed.begin(), speed.end(), sentSpeed.begin());
+            std::copy(sent.begin(), sent.end(), sentAcceleration.begin());
+        }
+    }
+
+    // string stability as computed by PlatoonKpi
+    for (int k = 0; k < batch.lanes; k++) {
+        double amplification = 0;
+        for (int i = 1; i < n; i++) {
+            if (peak[(i - 1) * B + k] > 0) amplification = std::max(amplification, peak[i * B + k] / peak[(i - 1) * B + k]);
+        }
+        batch.minGap[k] = minGap[k];
+        batch.stringStability[k] = amplification;
+    }
+}
+
+void usage()
+{
+    std::cerr << "usage: plexe_tuning [options] [--<parameter> <values>]...\n"
+              << "\n"
+              << "Evaluates the platoon controllers of Plexe for all the combinations of the\n"
+              << "given parameter values and platoon sizes. Prints one CSV line per combination\n"
+              << "with the minimum gap (m, negative in case of a collision) and the string\n"
+              << "stability indicator (maximum ratio between the peak acceleration of a vehicle\n"
+              << "and the one of the vehicle in front, > 1 means amplification).\n"
+              << "\n"
+              << "Values are given as a comma separated list or as start:step:end.\n"
+              << "\n"
+              << "options:\n"
+              << "  --controller <ACC|CACC|PLOEG|FLATBED>  controller of the followers (CACC)\n"
+              << "  --sizes <values>                 platoon sizes (8)\n"
+              << "  --scenario <sinusoidal|braking>  leader behavior (sinusoidal)\n"
+              << "  --leaderSpeed <kmph>             leader speed (100)\n"
+              << "  --oscillationAmplitude <kmph>    amplitude of the sinusoidal scenario (10)\n"
+              << "  --leaderOscillationFrequency <Hz>  frequency of the sinusoidal scenario (0.2)\n"
+              << "  --brakingDeceleration <mpsps>    deceleration of the braking scenario (8)\n"
+              << "  --start <s>                      when the leader starts oscillating or braking (5)\n"
+              << "  --duration <s>                   simulated time (60)\n"
+              << "  --step <s>                       integration step, i.e., SUMO step length (0.01)\n"
+              << "  --beaconingInterval <s>          interval between two beacons (0.1)\n"
+              << "  --useRealAcceleration            send the actual acceleration instead of the\n"
+              << "                                   controller one (useControllerAcceleration = false)\n"
+              << "  --threads <n>                    number of threads (all cores)\n"
+              << "\n"
+              << "parameters (defaults as in BBaseScenario.ned):\n";
+    for (const ParameterDefinition& definition : parameterDefinitions) {
+        std::cerr << "  --" << definition.name << " (" << definition.sumoName << ", " << (definition.controller == DRIVER ? "all" : controllerName(definition.controller)) << ", default " << definition.defaultValue << ")\n";
+    }
+}
+
+Settings parseArguments(int argc, char* argv[])
+{
+    Settings settings;
+    settings.threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (int i = 1; i < argc; i++) {
+        std::string option = argv[i];
+        if (option == "--help" || option == "-h") {
+            usage();
+            exit(0);
+        }
+        if (option == "--useRealAcceleration") {
+            settings.useControllerAcceleration = false;
+            continue;
+        }
+        if (option.compare(0, 2, "--") != 0 || i + 1 >= argc) throw std::invalid_argument("invalid option " + option);
+        std::string name = option.substr(2);
+        std::string value = argv[++i];
+
+        if (name == "controller") {
+            if (value == "ACC")
+                settings.controller = ACC;
+            else if (value == "CACC")
+                settings.controller = CACC;
+            else if (value == "PLOEG")
+                settings.controller = PLOEG;
+            else if (value == "FLATBED")
+                settings.controller = FLATBED;
+            else
+                throw std::invalid_argument("unsupported controller " + value);
+        }
+        else if (name == "sizes") {
+            settings.sizes.clear();
+            for (double size : parseValues(value)) {
+                if (size < 2 || size != std::floor(size)) throw std::invalid_argument("platoon sizes must be integers >= 2");
+                settings.sizes.push_back((int) size);
+            }
+        }
+        else if (name == "scenario") {
+            if (value == "sinusoidal")
+                settings.scenario = SINUSOIDAL;
+            else if (value == "braking")
+                settings.scenario = BRAKING;
+            else
+                throw std::invalid_argument("unknown scenario " + value);
+        }
+        else if (name == "leaderSpeed")
+            settings.leaderSpeed = std::stod(value) / 3.6;
+        else if (name == "oscillationAmplitude")
+            settings.oscillationAmplitude = std::stod(value) / 3.6;
+        else if (name == "leaderOscillationFrequency")
+            settings.oscillationFrequency = std::stod(value);
+        else if (name == "brakingDeceleration")
+            settings.brakingDeceleration = std::stod(value);
+        else if (name == "start")
+            settings.start = std::stod(value);
+        else if (name == "duration")
+            settings.duration = std::stod(value);
+        else if (name == "step")
+            settings.step = std::stod(value);
+        else if (name == "beaconingInterval")
+            settings.beaconingInterval = std::stod(value);
+        else if (name == "threads")
+            settings.threads = std::max(1, std::stoi(value));
+        else {
+            auto definition = std::find_if(parameterDefinitions.begin(), parameterDefinitions.end(), [&name](const ParameterDefinition& d) { return d.name == name; });
+            if (definition == parameterDefinitions.end()) throw std::invalid_argument("unknown parameter " + name);
+            settings.grid[name] = parseValues(value);
+        }
+    }
+
+    if (settings.step <= 0 || settings.duration <= 0) throw std::invalid_argument("step and duration must be positive");
+    for (const auto& values : settings.grid) {
+        auto definition = std::find_if(parameterDefinitions.begin(), parameterDefinitions.end(), [&values](const ParameterDefinition& d) { return d.name == values.first; });
+        if (!usesParameter(settings.controller, *definition)) std::cerr << "warning: " << values.first << " is not used by " << controllerName(settings.controller) << "\n";
+        if (values.first == "caccXi" && *std::min_element(values.second.begin(), values.second.end()) < 1) throw std::invalid_argument("caccXi must be >= 1");
+        if (values.first == "engineTau" && *std::min_element(values.second.begin(), values.second.end()) < 0) throw std::invalid_argument("engineTau cannot be negative");
+    }
+    return settings;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    Settings settings;
+    try {
+        settings = parseArguments(argc, argv);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "plexe_tuning: " << e.what() << "\n\n";
+        usage();
+        return 1;
+    }
+
+    // parameters of the controller and their values, in definition order
+    std::vector<int> parameterIndexes;
+    std::vector<std::vector<double>> values;
+    for (int j = 0; j < (int) parameterDefinitions.size(); j++) {
+        const ParameterDefinition& definition = parameterDefinitions[j];
+        if (!usesParameter(settings.controller, definition)) continue;
+        parameterIndexes.push_back(j);
+        auto grid = settings.grid.find(definition.name);
+        values.push_back(grid != settings.grid.end() ? grid->second : std::vector<double>{definition.defaultValue});
+    }
+    long combinations = 1;
+    for (const auto& v : values) combinations *= v.size();
+
+    // split the combinations of each platoon size into batches
+    std::vector<Batch> batches;
+    for (int size : settings.sizes) {
+        for (long first = 0; first < combinations; first += BATCH_SIZE) {
+            Batch batch;
+            batch.size = size;
+            batch.first = first;
+            batch.lanes = (int) std::min<long>(BATCH_SIZE, combinations - first);
+            batch.parameters.assign(values.size(), std::vector<double>(BATCH_SIZE));
+            for (int k = 0; k < BATCH_SIZE; k++) {
+                // unused lanes repeat the last combination
+                long index = first + std::min(k, batch.lanes - 1);
+                for (int j = (int) values.size() - 1; j >= 0; j--) {
+                    batch.parameters[j][k] = values[j][index % values[j].size()];
+                    index /= values[j].size();
+                }
+            }
+            batch.minGap.resize(BATCH_SIZE);
+            batch.stringStability.resize(BATCH_SIZE);
+            batches.push_back(std::move(batch));
+        }
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> workers;
+    for (int w = 0; w < settings.threads; w++) {
+        workers.emplace_back([&]() {
+            for (size_t b = next++; b < batches.size(); b = next++) simulate(settings, parameterIndexes, batches[b]);
+        });
+    }
+    for (std::thread& worker : workers) worker.join();
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    std::cout << "controller,size";
+    for (int j : parameterIndexes) std::cout << "," << parameterDefinitions[j].name;
+    std::cout << ",minGap,stringStability\n";
+    for (const Batch& batch : batches) {
+        for (int k = 0; k < batch.lanes; k++) {
+            std::cout << controllerName(settings.controller) << "," << batch.size;
+            for (const auto& parameter : batch.parameters) std::cout << "," << parameter[k];
+            std::cout << "," << batch.minGap[k] << "," << batch.stringStability[k] << "\n";
+        }
+    }
+
+    std::cerr << "evaluated " << combinations * settings.sizes.size() << " combinations in " << elapsed << " s with " << settings.threads << " threads\n";
+    return 0;
+}